@@ -0,0 +1,328 @@
+#include <math.h>
+
+#include "affine.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+/* out = a x b, for 3 floats */
+static void cross3(GLfloat* out, const GLfloat* a, const GLfloat* b) {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static GLfloat dot3(const GLfloat* a, const GLfloat* b) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/* Are the upper 3x3 columns orthonormal? */
+static bool orthonormal(const GLfloat* m) {
+        return fabs(dot3(m,m) - 1)         < OGLL_RIGID_EPSILON &&
+               fabs(dot3(m+4,m+4) - 1)     < OGLL_RIGID_EPSILON &&
+               fabs(dot3(m+8,m+8) - 1)     < OGLL_RIGID_EPSILON &&
+               fabs(dot3(m,m+4))           < OGLL_RIGID_EPSILON &&
+               fabs(dot3(m,m+8))           < OGLL_RIGID_EPSILON &&
+               fabs(dot3(m+4,m+8))         < OGLL_RIGID_EPSILON;
+}
+
+static ogll_m4kind_t kindOf(const GLfloat* m) {
+        if(m[3] != 0 || m[7] != 0 || m[11] != 0 || m[15] != 1) {
+                return OGLL_M4_GENERAL;
+        }
+
+        return orthonormal(m) ? OGLL_M4_RIGID : OGLL_M4_AFFINE;
+}
+
+static void copy16(GLfloat* out, const GLfloat* fs) {
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                out[i] = fs[i];
+        }
+}
+
+/* R^T and -R^T t */
+static void inverseRigid(GLfloat* out, const GLfloat* m) {
+        GLfloat fs[16];
+
+        // Column 1
+        fs[0]  = m[0];
+        fs[1]  = m[4];
+        fs[2]  = m[8];
+        fs[3]  = 0;
+        // Column 2
+        fs[4]  = m[1];
+        fs[5]  = m[5];
+        fs[6]  = m[9];
+        fs[7]  = 0;
+        // Column 3
+        fs[8]  = m[2];
+        fs[9]  = m[6];
+        fs[10] = m[10];
+        fs[11] = 0;
+        // Column 4
+        fs[12] = -dot3(m, m + 12);
+        fs[13] = -dot3(m + 4, m + 12);
+        fs[14] = -dot3(m + 8, m + 12);
+        fs[15] = 1;
+
+        copy16(out, fs);
+}
+
+/* Rows of the 3x3 inverse are the cross products of column pairs over
+   the determinant. Fills `rows` (3 x 3 floats) and yields the
+   determinant. */
+static GLfloat adjugate3(GLfloat* rows, const GLfloat* m) {
+        cross3(rows,     m + 4, m + 8);
+        cross3(rows + 3, m + 8, m);
+        cross3(rows + 6, m,     m + 4);
+
+        return dot3(m, rows);
+}
+
+static bool inverseAffine(GLfloat* out, const GLfloat* m) {
+        GLfloat rows[9];
+        GLfloat fs[16];
+        GLfloat det = adjugate3(rows, m);
+        size_t i;
+
+        if(det == 0) {
+                return false;
+        }
+
+        for(i = 0; i < 9; i++) {
+                rows[i] /= det;
+        }
+
+        for(i = 0; i < 3; i++) {
+                fs[i]      = rows[i * 3];
+                fs[4 + i]  = rows[i * 3 + 1];
+                fs[8 + i]  = rows[i * 3 + 2];
+                fs[12 + i] = -dot3(rows + i * 3, m + 12);
+        }
+
+        fs[3]  = 0;
+        fs[7]  = 0;
+        fs[11] = 0;
+        fs[15] = 1;
+
+        copy16(out, fs);
+
+        return true;
+}
+
+static bool inverse(GLfloat* out, const GLfloat* m) {
+        switch(kindOf(m)) {
+        case OGLL_M4_RIGID:
+                inverseRigid(out, m);
+                return true;
+        case OGLL_M4_AFFINE:
+                return inverseAffine(out, m);
+        default:
+                return ogllSimdM4Inverse(out, m);
+        }
+}
+
+/* The inverse-transpose has the cross products as its columns */
+static bool normal(GLfloat* out, const GLfloat* m) {
+        GLfloat fs[16];
+        size_t i;
+
+        if(orthonormal(m)) {
+                for(i = 0; i < 12; i++) {
+                        fs[i] = m[i];
+                }
+        } else {
+                GLfloat det = adjugate3(fs, m);
+
+                if(det == 0) {
+                        return false;
+                }
+
+                // Spread the three packed columns out to a stride of 4.
+                for(i = 9; i-- > 0; ) {
+                        fs[(i / 3) * 4 + i % 3] = fs[i] / det;
+                }
+        }
+
+        fs[3]  = 0;
+        fs[7]  = 0;
+        fs[11] = 0;
+        fs[12] = 0;
+        fs[13] = 0;
+        fs[14] = 0;
+        fs[15] = 1;
+
+        copy16(out, fs);
+
+        return true;
+}
+
+/* The cheapest inverse that's valid for a 4x4 Matrix */
+ogll_m4kind_t ogllM4Kind(matrix_t* m) {
+        OGLL_PROBE();
+        check(m, "Null Matrix given.");
+        check(m->cols == 4 && m->rows == 4, "Matrix not 4x4.");
+
+        return kindOf(m->m);
+ error:
+        return OGLL_M4_GENERAL;
+}
+
+/* Invert a 4x4 Matrix by the cheapest valid path */
+matrix_t* ogllM4Inverse(matrix_t* dst, matrix_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrix given.");
+        check(m->cols == 4 && m->rows == 4 && dst->cols == 4 && dst->rows == 4,
+              "Matrix not 4x4.");
+        check(inverse(dst->m, m->m), "Matrix is singular.");
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Full inverse of any 4x4 Matrix */
+matrix_t* ogllM4InverseGeneral(matrix_t* dst, matrix_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrix given.");
+        check(m->cols == 4 && m->rows == 4 && dst->cols == 4 && dst->rows == 4,
+              "Matrix not 4x4.");
+        check(ogllSimdM4Inverse(dst->m, m->m), "Matrix is singular.");
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Inverse of an affine Matrix */
+matrix_t* ogllM4InverseAffine(matrix_t* dst, matrix_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrix given.");
+        check(m->cols == 4 && m->rows == 4 && dst->cols == 4 && dst->rows == 4,
+              "Matrix not 4x4.");
+        check(inverseAffine(dst->m, m->m), "Matrix is singular.");
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Inverse of a rigid Matrix */
+matrix_t* ogllM4InverseRigid(matrix_t* dst, matrix_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrix given.");
+        check(m->cols == 4 && m->rows == 4 && dst->cols == 4 && dst->rows == 4,
+              "Matrix not 4x4.");
+
+        inverseRigid(dst->m, m->m);
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* The normal Matrix */
+matrix_t* ogllM4Normal(matrix_t* dst, matrix_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrix given.");
+        check(m->cols == 4 && m->rows == 4 && dst->cols == 4 && dst->rows == 4,
+              "Matrix not 4x4.");
+        check(normal(dst->m, m->m), "Matrix is singular.");
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Split an affine Matrix into translation, rotation and per-axis scale */
+bool ogllM4Decompose(matrix_t* m, vec3_t* t, quat_t* r, vec3_t* s) {
+        OGLL_PROBE();
+        GLfloat c[3];
+        GLfloat sx, sy, sz;
+        mat4_t rot;
+        size_t i;
+
+        check(m && t && r && s, "Null argument given.");
+        check(m->cols == 4 && m->rows == 4, "Matrix not 4x4.");
+
+        sx = sqrt(dot3(m->m, m->m));
+        sy = sqrt(dot3(m->m + 4, m->m + 4));
+        sz = sqrt(dot3(m->m + 8, m->m + 8));
+        check(sx != 0 && sy != 0 && sz != 0, "Matrix has a zero axis.");
+
+        cross3(c, m->m + 4, m->m + 8);
+        if(dot3(m->m, c) < 0) {
+                sx = -sx;
+        }
+
+        rot = ogllMat4Identity();
+        for(i = 0; i < 3; i++) {
+                rot.m[i]     = m->m[i] / sx;
+                rot.m[4 + i] = m->m[4 + i] / sy;
+                rot.m[8 + i] = m->m[8 + i] / sz;
+        }
+
+        *t = ogllV3Make(m->m[12], m->m[13], m->m[14]);
+        *r = ogllQNormalize(ogllQFromMat4(&rot));
+        *s = ogllV3Make(sx, sy, sz);
+
+        return true;
+ error:
+        return false;
+}
+
+/* Build T * R * S into a 4x4 Matrix */
+matrix_t* ogllM4Compose(matrix_t* dst, vec3_t t, quat_t r, vec3_t s) {
+        OGLL_PROBE();
+        mat4_t rot;
+        size_t i;
+
+        check(dst, "Null Matrix given.");
+        check(dst->cols == 4 && dst->rows == 4, "Matrix not 4x4.");
+
+        ogllQToMat4(r, &rot);
+
+        for(i = 0; i < 3; i++) {
+                rot.m[i]     *= s.x;
+                rot.m[4 + i] *= s.y;
+                rot.m[8 + i] *= s.z;
+        }
+
+        rot.m[12] = t.x;
+        rot.m[13] = t.y;
+        rot.m[14] = t.z;
+
+        copy16(dst->m, rot.m);
+
+        return dst;
+ error:
+        return NULL;
+}
+
+// --- VALUES --- //
+
+/* As `ogllM4Inverse`, for values */
+mat4_t* ogllMat4Inverse(mat4_t* dst, const mat4_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrix given.");
+        check(inverse(dst->m, m->m), "Matrix is singular.");
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* As `ogllM4Normal`, for values */
+mat4_t* ogllMat4Normal(mat4_t* dst, const mat4_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrix given.");
+        check(normal(dst->m, m->m), "Matrix is singular.");
+
+        return dst;
+ error:
+        return NULL;
+}
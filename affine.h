@@ -0,0 +1,81 @@
+#ifndef __ogll_affine__
+#define __ogll_affine__
+
+#include "opengl-linalg.h"
+#include "value.h"
+#include "quat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Inverses and decompositions of 4x4 transforms.
+ *
+ * Most Matrices a renderer inverts are built by `ogllM4Translate`,
+ * `ogllM4Rotate` and friends, and their inverses have closed forms far
+ * cheaper than a general inverse:
+ *
+ *   rigid   (rotation + translation):  R^T, -R^T t
+ *   affine  (any 3x3 + translation):   3x3 inverse by cross products
+ *   general (projections etc.):        full inverse, SIMD accelerated
+ *
+ * `ogllM4Inverse` picks the cheapest path that's valid. Nothing here
+ * allocates, and every `dst` may be the same Matrix as the input.
+ */
+
+// --- //
+
+/* Columns must be orthonormal to within this for a Matrix to count as rigid */
+#define OGLL_RIGID_EPSILON 1e-5
+
+typedef enum ogll_m4kind_t {
+        OGLL_M4_GENERAL,
+        OGLL_M4_AFFINE,
+        OGLL_M4_RIGID
+} ogll_m4kind_t;
+
+/* The cheapest inverse that's valid for a 4x4 Matrix. Affine means the
+   bottom row is exactly 0 0 0 1. Rigid means affine with orthonormal
+   upper 3x3 columns (reflections included). */
+ogll_m4kind_t ogllM4Kind(matrix_t* m);
+
+/* Invert a 4x4 Matrix by the cheapest valid path.
+   Yields `dst`, or NULL if `m` is singular. */
+matrix_t* ogllM4Inverse(matrix_t* dst, matrix_t* m);
+
+/* Full inverse of any 4x4 Matrix. Yields NULL if singular. */
+matrix_t* ogllM4InverseGeneral(matrix_t* dst, matrix_t* m);
+
+/* Inverse of an affine Matrix. The bottom row isn't checked.
+   Yields NULL if the upper 3x3 is singular. */
+matrix_t* ogllM4InverseAffine(matrix_t* dst, matrix_t* m);
+
+/* Inverse of a rigid Matrix. Orthonormality isn't checked. */
+matrix_t* ogllM4InverseRigid(matrix_t* dst, matrix_t* m);
+
+/* The normal Matrix: inverse-transpose of the upper 3x3, written into
+   a 4x4 with no translation. Yields NULL if the 3x3 is singular. */
+matrix_t* ogllM4Normal(matrix_t* dst, matrix_t* m);
+
+/* Split an affine Matrix into translation, rotation and per-axis scale,
+   such that m = T * R * S. A negative determinant is carried by `s->x`.
+   Shear can't be represented and is lost. Yields false if a column of
+   the 3x3 is zero. */
+bool ogllM4Decompose(matrix_t* m, vec3_t* t, quat_t* r, vec3_t* s);
+
+/* Build T * R * S into a 4x4 Matrix. Inverse of `ogllM4Decompose`. */
+matrix_t* ogllM4Compose(matrix_t* dst, vec3_t t, quat_t r, vec3_t s);
+
+// --- VALUES --- //
+
+/* As `ogllM4Inverse`, for values. Yields NULL if `m` is singular. */
+mat4_t* ogllMat4Inverse(mat4_t* dst, const mat4_t* m);
+
+/* As `ogllM4Normal`, for values */
+mat4_t* ogllMat4Normal(mat4_t* dst, const mat4_t* m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "alloc.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+static __thread const allocator_t* current = NULL;
+
+static void* arenaAlloc(void* ctx, size_t size, size_t align) {
+        arena_t* a = (arena_t*)ctx;
+        uintptr_t at = (uintptr_t)(a->base + a->used);
+        size_t pad = (align - at % align) % align;
+
+        check(a->used + pad + size <= a->size,
+              "Arena exhausted (%zu of %zu bytes used).", a->used, a->size);
+
+        a->used += pad + size;
+
+        if(a->used > a->peak) {
+                a->peak = a->used;
+        }
+
+        return (void*)(at + pad);
+ error:
+        return NULL;
+}
+
+static void arenaFree(void* ctx, void* p) {
+        // Reclaimed all at once by `ogllArenaReset`.
+        (void)ctx;
+        (void)p;
+}
+
+/* Install `a` for Matrices created on the calling thread */
+void ogllSetAllocator(const allocator_t* a) {
+        OGLL_PROBE();
+        current = a;
+}
+
+/* The calling thread's current allocator, or NULL for malloc */
+const allocator_t* ogllGetAllocator(void) {
+        OGLL_PROBE();
+        return current;
+}
+
+/* Create an Arena of `size` bytes */
+arena_t* ogllArenaCreate(size_t size) {
+        OGLL_PROBE();
+        arena_t* a = NULL;
+
+        check(size > 0, "Bad Arena size given.");
+
+        a = calloc(1, sizeof(arena_t));
+        check_mem(a);
+
+        a->base = malloc(size);
+        check_mem(a->base);
+
+        a->size = size;
+        a->allocator.alloc = arenaAlloc;
+        a->allocator.free = arenaFree;
+        a->allocator.ctx = a;
+
+        return a;
+ error:
+        ogllArenaDestroy(a);
+        return NULL;
+}
+
+/* Deallocate an Arena and everything allocated from it */
+void ogllArenaDestroy(arena_t* a) {
+        OGLL_PROBE();
+        if(a) {
+                if(current == &a->allocator) {
+                        current = NULL;
+                }
+
+                free(a->base);
+                free(a);
+        }
+}
+
+/* Forget every allocation at once */
+void ogllArenaReset(arena_t* a) {
+        OGLL_PROBE();
+        if(a) {
+                a->used = 0;
+        }
+}
+
+/* The allocator interface of an Arena */
+const allocator_t* ogllArenaAllocator(arena_t* a) {
+        OGLL_PROBE();
+        return a ? &a->allocator : NULL;
+}
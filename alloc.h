@@ -0,0 +1,64 @@
+#ifndef __ogll_alloc__
+#define __ogll_alloc__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pluggable memory for `matrix_t` construction.
+ *
+ * Every constructor (`ogllMCreate` and all the `*P` functions built on it)
+ * asks the calling thread's current allocator for memory. When one is
+ * installed, the `matrix_t` header and its data come from a single
+ * OGLL_ALIGN-aligned block, and `ogllMDestroy` hands that block back to the
+ * same allocator. With no allocator installed, an aligned malloc is used.
+ */
+
+// --- //
+
+typedef struct allocator_t {
+        /* Return `size` bytes aligned to `align`, or NULL */
+        void* (*alloc)(void* ctx, size_t size, size_t align);
+        /* Release a block from `alloc`. May do nothing. */
+        void (*free)(void* ctx, void* p);
+        void* ctx;
+} allocator_t;
+
+/* A linear allocator over one fixed block. Allocation bumps a cursor,
+   freeing does nothing, and resetting reclaims everything at once. */
+typedef struct arena_t {
+        char* base;
+        size_t size;
+        size_t used;
+        size_t peak;
+        allocator_t allocator;
+} arena_t;
+
+/* Install `a` for Matrices created on the calling thread. NULL restores
+   malloc. `a` must outlive every Matrix created through it. */
+void ogllSetAllocator(const allocator_t* a);
+
+/* The calling thread's current allocator, or NULL for malloc */
+const allocator_t* ogllGetAllocator(void);
+
+/* Create an Arena of `size` bytes */
+arena_t* ogllArenaCreate(size_t size);
+
+/* Deallocate an Arena and everything allocated from it */
+void ogllArenaDestroy(arena_t* a);
+
+/* Forget every allocation at once, e.g. at the end of a frame. Matrices
+   from before the reset must no longer be used. */
+void ogllArenaReset(arena_t* a);
+
+/* The allocator interface of an Arena, for `ogllSetAllocator` */
+const allocator_t* ogllArenaAllocator(arena_t* a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
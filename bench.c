@@ -0,0 +1,379 @@
+// Benchmarks for opengl-linalg
+//
+// Times every operation in opengl-linalg.h and prints one JSON document
+// to stdout, with a readable table on stderr. Build with NDEBUG so that
+// debug() logging doesn't end up in the timings:
+//
+//   gcc -O2 -DNDEBUG bench.c opengl-linalg.c simd.c gemm.c pool.c alloc.c
+//       error.c -lm -lpthread -o bench
+//
+// Options:
+//   --time SEC       Minimum time spent per measurement (default 0.1)
+//   --max N          Largest square size for the sized cases (default 1024)
+//   --threads N      Pool size for large products (default 1, no pool)
+//   --baseline FILE  Previous JSON output to compare against
+//
+// Allocations are counted by installing a counting allocator (alloc.h).
+// New Matrices and the GEMM packing buffers both go through it, so the
+// allocs/op and bytes/op columns cover everything the library asks for.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "opengl-linalg.h"
+#include "alloc.h"
+#include "simd.h"
+#include "gemm.h"
+#include "dbg.h"
+
+// --- //
+
+#define MAX_BASELINE 512
+
+typedef struct ctx_t {
+        size_t n;
+        matrix_t* a;
+        matrix_t* b;
+        matrix_t* d;
+        matrix_t* v1;
+        matrix_t* v2;
+        matrix_t* v3;
+        GLfloat* buf;
+} ctx_t;
+
+typedef void (*body_f)(ctx_t* c, size_t iters);
+
+typedef struct baseline_t {
+        char name[64];
+        size_t size;
+        double ns;
+} baseline_t;
+
+static double minTime = 0.1;
+static size_t maxSize = 1024;
+static baseline_t baseline[MAX_BASELINE];
+static size_t baselineCount = 0;
+static bool firstResult = true;
+
+static size_t allocs = 0;
+static size_t allocBytes = 0;
+
+// --- COUNTING ALLOCATOR --- //
+
+static void* countAlloc(void* ctx, size_t size, size_t align) {
+        void* p = NULL;
+
+        (void)ctx;
+        allocs++;
+        allocBytes += size;
+
+        return posix_memalign(&p, align, size) == 0 ? p : NULL;
+}
+
+static void countFree(void* ctx, void* p) {
+        (void)ctx;
+        free(p);
+}
+
+static const allocator_t counting = { countAlloc, countFree, NULL };
+
+// --- TIMING --- //
+
+static double now(void) {
+        struct timespec t;
+
+        clock_gettime(CLOCK_MONOTONIC, &t);
+
+        return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static double baselineFor(const char* name, size_t size) {
+        size_t i;
+
+        for(i = 0; i < baselineCount; i++) {
+                if(baseline[i].size == size && strcmp(baseline[i].name, name) == 0) {
+                        return baseline[i].ns;
+                }
+        }
+
+        return 0;
+}
+
+/* Run `body` with a growing iteration count until it takes `minTime`,
+   then report per-op figures. `flops` is the work of one op, or 0. */
+static void measure(const char* name, size_t size, body_f body, ctx_t* c,
+                    double flops) {
+        size_t iters = 1;
+        size_t a0, b0;
+        double t0, t, ns, base, grow;
+
+        body(c, 1);  // Warm up caches and the SIMD dispatch.
+
+        for(;;) {
+                a0 = allocs;
+                b0 = allocBytes;
+                t0 = now();
+                body(c, iters);
+                t = now() - t0;
+
+                if(t >= minTime || iters >= ((size_t)1 << 40)) {
+                        break;
+                }
+
+                // Aim a little past `minTime`, growing by 2x to 100x.
+                grow = t > 0 ? minTime * 1.2 / t : 100;
+                iters *= grow < 2 ? 2 : grow > 100 ? 100 : (size_t)grow;
+        }
+
+        ns = t * 1e9 / iters;
+        base = baselineFor(name, size);
+
+        printf("%s\n    {\"name\": \"%s\", \"size\": %zu, \"iterations\": %zu, "
+               "\"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, "
+               "\"gflops\": %.3f, \"allocs_per_op\": %.3f, "
+               "\"bytes_per_op\": %.1f",
+               firstResult ? "" : ",",
+               name, size, iters, ns, 1e9 / ns,
+               flops > 0 ? flops / ns : 0,
+               (double)(allocs - a0) / iters,
+               (double)(allocBytes - b0) / iters);
+
+        if(base > 0) {
+                printf(", \"baseline_ns_per_op\": %.3f, \"change\": %.4f",
+                       base, ns / base - 1);
+        }
+
+        printf("}");
+        firstResult = false;
+
+        fprintf(stderr, "%-18s %5zu %14.1f ns/op %8.2f allocs/op", name, size,
+                ns, (double)(allocs - a0) / iters);
+        if(base > 0) {
+                fprintf(stderr, "   %+6.1f%%", (ns / base - 1) * 100);
+        }
+        fprintf(stderr, "\n");
+}
+
+static bool loadBaseline(const char* path) {
+        FILE* f = fopen(path, "r");
+        char line[512];
+        baseline_t* b;
+
+        check(f, "Couldn't open baseline `%s`.", path);
+
+        while(fgets(line, sizeof(line), f) && baselineCount < MAX_BASELINE) {
+                b = &baseline[baselineCount];
+
+                if(sscanf(line, " {\"name\": \"%63[^\"]\", \"size\": %zu, "
+                          "\"iterations\": %*u, \"ns_per_op\": %lf",
+                          b->name, &b->size, &b->ns) == 3) {
+                        baselineCount++;
+                }
+        }
+
+        fclose(f);
+
+        return true;
+ error:
+        return false;
+}
+
+// --- BODIES --- //
+
+#define BODY(NAME, STMT) \
+        static void NAME(ctx_t* c, size_t iters) { \
+                size_t it; \
+                for(it = 0; it < iters; it++) { STMT; } \
+        }
+
+static volatile GLfloat sinkF;
+static volatile bool sinkB;
+
+BODY(bVCreate,       ogllMDestroy(ogllVCreate(c->n)))
+BODY(bVFromArray,    ogllMDestroy(ogllVFromArray(4, c->buf)))
+BODY(bVCrossP,       ogllMDestroy(ogllVCrossP(c->v1, c->v2)))
+BODY(bVCrossInto,    ogllVCrossInto(c->v3, c->v1, c->v2))
+BODY(bVLength,       sinkF = ogllVLength(c->v1))
+BODY(bVDotProduct,   sinkF = ogllVDotProduct(c->v1, c->v2))
+BODY(bVDotProductBad, sinkF = ogllVDotProduct(c->v1, c->a))
+BODY(bVIsOrtho,      sinkB = ogllVIsOrtho(c->v1, c->v2))
+BODY(bVIsVector,     sinkB = ogllVIsVector(c->v1))
+BODY(bMCreate,       ogllMDestroy(ogllMCreate(c->n, c->n)))
+BODY(bMFromArray,    ogllMDestroy(ogllMFromArray(c->n, c->n, c->buf)))
+BODY(bMCopy,         ogllMDestroy(ogllMCopy(c->a)))
+BODY(bMIdentity,     ogllMDestroy(ogllMIdentity(c->n)))
+BODY(bMEqual,        sinkB = ogllMEqual(c->a, c->a))
+BODY(bMSet,          ogllMSet(c->a, it % c->n, it % c->n, 1))
+BODY(bMScale,        ogllMScale(c->a, 1))
+BODY(bMAdd,          ogllMAdd(c->a, c->b))
+BODY(bMAddP,         ogllMDestroy(ogllMAddP(c->a, c->b)))
+BODY(bMAddInto,      ogllMAddInto(c->d, c->a, c->b))
+BODY(bM4Multiply,    ogllM4Multiply(c->a, c->b))
+BODY(bMMultiplyP,    ogllMDestroy(ogllMMultiplyP(c->a, c->b)))
+BODY(bMMultiplyInto, ogllMMultiplyInto(c->d, c->a, c->b))
+BODY(bM4TransformN,  ogllM4TransformN(c->a, c->buf, c->buf, c->n, 4, 0))
+BODY(bM4MultiplyN,   ogllM4MultiplyN(c->a, c->buf, c->buf, c->n))
+BODY(bMTranspose,    ogllMDestroy(ogllMTranspose(c->a)))
+BODY(bMTransposeInto, ogllMTransposeInto(c->d, c->a))
+BODY(bM4Rotate,      ogllM4Rotate(c->a, 0.001, 0,0,1))
+BODY(bM4Translate,   ogllM4Translate(c->a, 1,2,3))
+BODY(bMPerspectiveP, ogllMDestroy(ogllMPerspectiveP(tau/8, 1.5, 0.1, 100)))
+BODY(bM4LookAtP,     ogllMDestroy(ogllM4LookAtP(c->v1, c->v2, c->v3)))
+BODY(bMPerspectiveInto, ogllMPerspectiveInto(c->d, tau/8, 1.5, 0.1, 100))
+BODY(bM4LookAtInto,  ogllM4LookAtInto(c->d, c->v1, c->v2, c->v3))
+
+// --- CASES --- //
+
+/* Fill every operand for an n x n case. Entries stay near 1 so repeated
+   in-place products don't overflow. */
+static bool setup(ctx_t* c, size_t n, size_t bufLen) {
+        GLfloat id[] = { 1,0,0, 0,1,0, 0,0,1 };
+        size_t i;
+
+        memset(c, 0, sizeof(ctx_t));
+        c->n = n;
+        c->a = ogllMIdentity(n);
+        c->b = ogllMIdentity(n);
+        c->d = ogllMIdentity(n);
+        c->v1 = ogllVFromArray(3, id);
+        c->v2 = ogllVFromArray(3, id + 3);
+        c->v3 = ogllVFromArray(3, id + 6);
+        c->buf = calloc(bufLen > 16 ? bufLen : 16, sizeof(GLfloat));
+        check(c->a && c->b && c->d && c->v1 && c->v2 && c->v3 && c->buf,
+              "Benchmark setup failed.");
+
+        for(i = 0; i < (bufLen > 16 ? bufLen : 16); i++) {
+                c->buf[i] = (i % 5 == 0);
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+static void teardown(ctx_t* c) {
+        ogllMDestroy(c->a);
+        ogllMDestroy(c->b);
+        ogllMDestroy(c->d);
+        ogllMDestroy(c->v1);
+        ogllMDestroy(c->v2);
+        ogllMDestroy(c->v3);
+        free(c->buf);
+}
+
+/* Operations on fixed-size Vectors and 4x4 Matrices */
+static void fixedCases(void) {
+        ctx_t c;
+
+        check(setup(&c, 4, 16 * 1024), "Setup failed.");
+
+        measure("ogllVCreate",       4, bVCreate,       &c, 0);
+        measure("ogllVFromArray",    4, bVFromArray,    &c, 0);
+        measure("ogllVCrossP",       3, bVCrossP,       &c, 9);
+        measure("ogllVCrossInto",    3, bVCrossInto,    &c, 9);
+        measure("ogllVLength",       3, bVLength,       &c, 6);
+        measure("ogllVDotProduct",   3, bVDotProduct,   &c, 5);
+
+        // A failing call, with logging off, costs only the error slot.
+        ogllSetErrorLogging(false);
+        measure("ogllVDotProduct!",  3, bVDotProductBad, &c, 0);
+        ogllSetErrorLogging(true);
+
+        measure("ogllVIsOrtho",      3, bVIsOrtho,      &c, 5);
+        measure("ogllVIsVector",     3, bVIsVector,     &c, 0);
+        measure("ogllM4Multiply",    4, bM4Multiply,    &c, 112);
+        measure("ogllM4Rotate",      4, bM4Rotate,      &c, 140);
+        measure("ogllM4Translate",   4, bM4Translate,   &c, 0);
+        measure("ogllMPerspectiveP", 4, bMPerspectiveP, &c, 0);
+        measure("ogllM4LookAtP",     4, bM4LookAtP,     &c, 0);
+        measure("ogllMPerspectiveInto", 4, bMPerspectiveInto, &c, 0);
+        measure("ogllM4LookAtInto",  4, bM4LookAtInto,  &c, 0);
+
+        // The batch calls are measured per element.
+        c.n = 1024;
+        measure("ogllM4TransformN",  1024, bM4TransformN, &c, 28 * 1024);
+        c.n = 1024 / 16;
+        measure("ogllM4MultiplyN",   64, bM4MultiplyN,   &c, 112 * 64);
+
+        teardown(&c);
+ error:
+        return;
+}
+
+/* Operations on general n x n Matrices, n = 2..maxSize */
+static void sizedCases(void) {
+        ctx_t c;
+        double n3;
+        size_t n;
+
+        for(n = 2; n <= maxSize; n *= 2) {
+                check(setup(&c, n, n * n), "Setup failed.");
+                n3 = (double)n * n * n;
+
+                measure("ogllMCreate",    n, bMCreate,    &c, 0);
+                measure("ogllMFromArray", n, bMFromArray, &c, 0);
+                measure("ogllMCopy",      n, bMCopy,      &c, 0);
+                measure("ogllMIdentity",  n, bMIdentity,  &c, 0);
+                measure("ogllMEqual",     n, bMEqual,     &c, 0);
+                measure("ogllMSet",       n, bMSet,       &c, 0);
+                measure("ogllMScale",     n, bMScale,     &c, n * n);
+                measure("ogllMAdd",       n, bMAdd,       &c, n * n);
+                measure("ogllMAddP",      n, bMAddP,      &c, n * n);
+                measure("ogllMAddInto",   n, bMAddInto,   &c, n * n);
+                measure("ogllMTranspose", n, bMTranspose, &c, 0);
+                measure("ogllMTransposeInto", n, bMTransposeInto, &c, 0);
+                measure("ogllMMultiplyP", n, bMMultiplyP, &c, 2 * n3);
+                measure("ogllMMultiplyInto", n, bMMultiplyInto, &c, 2 * n3);
+
+                teardown(&c);
+        }
+
+ error:
+        return;
+}
+
+int main(int argc, char** argv) {
+        pool_t* pool = NULL;
+        size_t threads = 1;
+        int i;
+
+        for(i = 1; i < argc; i++) {
+                if(strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+                        minTime = atof(argv[++i]);
+                } else if(strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+                        maxSize = strtoul(argv[++i], NULL, 10);
+                } else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                        threads = strtoul(argv[++i], NULL, 10);
+                } else if(strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+                        check(loadBaseline(argv[++i]), "Bad baseline.");
+                } else {
+                        sentinel("Unknown option `%s`.", argv[i]);
+                }
+        }
+
+        if(threads != 1) {
+                pool = ogllPoolCreate(threads);
+                check(pool, "Pool creation failed.");
+                ogllGemmSetPool(pool);
+        }
+
+        ogllSetAllocator(&counting);
+
+        printf("{\"backend\": \"%s\", \"threads\": %zu, \"results\": [",
+               ogllSimdName(ogllSimdBackend()), ogllPoolSize(pool));
+
+        fixedCases();
+        sizedCases();
+
+        printf("\n]}\n");
+
+        ogllSetAllocator(NULL);
+        ogllGemmSetPool(NULL);
+        ogllPoolDestroy(pool);
+
+        return EXIT_SUCCESS;
+ error:
+        return EXIT_FAILURE;
+}
@@ -0,0 +1,846 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <math.h>
+
+#include "bvh.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OGLL_X86
+#include <immintrin.h>
+#endif
+
+// --- //
+
+#define BVH_LEAF  4     // Most triangles in a leaf
+#define BVH_BINS  12    // SAH buckets per split
+#define BVH_DEPTH 32    // Below this, splits are by median, so trees stay shallow
+#define BVH_STACK 72    // Enough for BVH_DEPTH plus 32 median levels
+#define BVH_GRAIN 256   // Rays per chunk, a multiple of 4
+
+/* Slab tests round, so a box could come out a hair further than a
+   triangle it holds. Widen every box by a few ulps to be safe. */
+#define SLAB_SLACK 1.0000004f
+
+typedef struct ray_t {
+        GLfloat o[3];
+        GLfloat d[3];
+        GLfloat inv[3];
+        GLfloat tmax;
+} ray_t;
+
+typedef struct job_t {
+        const bvh_t* b;
+        const soa_t* origins;
+        const soa_t* dirs;
+        const GLfloat* tmax;
+        hit_t* hits;
+        uint8_t* occluded;
+        bool any;
+        bool sse;
+        size_t count;
+} job_t;
+
+static bool useSse(void) {
+#ifdef OGLL_X86
+        return ogllSimdBackend() != OGLL_SIMD_SCALAR;
+#else
+        return false;
+#endif
+}
+
+/* These pick the same operand as `_mm_min_ps` and `_mm_max_ps`, NaNs
+   included */
+static GLfloat minf(GLfloat a, GLfloat b) {
+        return a < b ? a : b;
+}
+
+static GLfloat maxf(GLfloat a, GLfloat b) {
+        return a > b ? a : b;
+}
+
+static void corners(const bvh_t* b, uint32_t tri, const GLfloat** v0,
+                    const GLfloat** v1, const GLfloat** v2) {
+        if(b->indices) {
+                *v0 = b->vertices + 3 * b->indices[3 * tri];
+                *v1 = b->vertices + 3 * b->indices[3 * tri + 1];
+                *v2 = b->vertices + 3 * b->indices[3 * tri + 2];
+        } else {
+                *v0 = b->vertices + 9 * tri;
+                *v1 = b->vertices + 9 * tri + 3;
+                *v2 = b->vertices + 9 * tri + 6;
+        }
+}
+
+/* Bounds of the triangles tris[first..first+count) */
+static void bound(const bvh_t* b, bvh_node_t* n, size_t first, size_t count) {
+        const GLfloat* v[3];
+        size_t i, k, a;
+
+        for(a = 0; a < 3; a++) {
+                n->min[a] = INFINITY;
+                n->max[a] = -INFINITY;
+        }
+
+        for(i = first; i < first + count; i++) {
+                corners(b, b->tris[i], &v[0], &v[1], &v[2]);
+
+                for(k = 0; k < 3; k++) {
+                        for(a = 0; a < 3; a++) {
+                                n->min[a] = minf(n->min[a], v[k][a]);
+                                n->max[a] = maxf(n->max[a], v[k][a]);
+                        }
+                }
+        }
+}
+
+// --- BUILDING --- //
+
+typedef struct bin_t {
+        GLfloat min[3], max[3];
+        size_t count;
+} bin_t;
+
+typedef struct task_t {
+        uint32_t node;
+        uint32_t first;
+        uint32_t count;
+        uint32_t depth;
+} task_t;
+
+static void binEmpty(bin_t* bin) {
+        size_t a;
+
+        for(a = 0; a < 3; a++) {
+                bin->min[a] = INFINITY;
+                bin->max[a] = -INFINITY;
+        }
+        bin->count = 0;
+}
+
+static void binGrow(bin_t* bin, const bin_t* other) {
+        size_t a;
+
+        for(a = 0; a < 3; a++) {
+                bin->min[a] = minf(bin->min[a], other->min[a]);
+                bin->max[a] = maxf(bin->max[a], other->max[a]);
+        }
+        bin->count += other->count;
+}
+
+static GLfloat binCost(const bin_t* bin) {
+        GLfloat x = bin->max[0] - bin->min[0];
+        GLfloat y = bin->max[1] - bin->min[1];
+        GLfloat z = bin->max[2] - bin->min[2];
+
+        return bin->count == 0 ? 0 : (x * y + y * z + z * x) * bin->count;
+}
+
+static GLfloat centroid(const bin_t* box, size_t axis) {
+        return (box->min[axis] + box->max[axis]) * 0.5f;
+}
+
+/* Which of BVH_BINS buckets a centroid falls in along `axis` */
+static size_t binOf(const bin_t* box, size_t axis, GLfloat lo, GLfloat scale) {
+        size_t i = (size_t)((centroid(box, axis) - lo) * scale);
+
+        return i < BVH_BINS ? i : BVH_BINS - 1;
+}
+
+static void swapTris(bvh_t* b, bin_t* boxes, size_t i, size_t j) {
+        uint32_t t = b->tris[i];
+        bin_t box = boxes[i];
+
+        b->tris[i] = b->tris[j];
+        b->tris[j] = t;
+        boxes[i] = boxes[j];
+        boxes[j] = box;
+}
+
+/* Select around the median centroid along `axis`, so the first count/2
+   of tris[first..first+count) lie at or below it and the rest at or
+   above. Yields count/2. */
+static size_t medianSplit(bvh_t* b, bin_t* boxes,
+                          size_t first, size_t count, size_t axis) {
+        ptrdiff_t lo = first;
+        ptrdiff_t hi = first + count - 1;
+        ptrdiff_t k = first + count / 2;
+        ptrdiff_t i, j;
+        GLfloat pivot;
+
+        while(lo < hi) {
+                pivot = centroid(&boxes[lo + (hi - lo) / 2], axis);
+                i = lo;
+                j = hi;
+
+                while(i <= j) {
+                        while(centroid(&boxes[i], axis) < pivot) {
+                                i++;
+                        }
+                        while(centroid(&boxes[j], axis) > pivot) {
+                                j--;
+                        }
+                        if(i <= j) {
+                                swapTris(b, boxes, i++, j--);
+                        }
+                }
+
+                if(k <= j) {
+                        hi = j;
+                } else if(k >= i) {
+                        lo = i;
+                } else {
+                        break;
+                }
+        }
+
+        return count / 2;
+}
+
+/* Split tris[first..first+count) in two, yielding the size of the left
+   part. `boxes[i]` bounds `tris[i]`, and is moved along with it. Falls
+   back to a median split along the widest axis when the centroids can't
+   be binned, SAH finds no split, or the tree is getting deep. */
+static size_t split(bvh_t* b, bin_t* boxes, bvh_node_t* n,
+                    size_t first, size_t count, size_t depth) {
+        GLfloat lo[3], hi[3], scale;
+        bin_t bins[BVH_BINS], left[BVH_BINS], right;
+        GLfloat cost, best = INFINITY;
+        size_t i, a, axis = 0, at = 0;
+        size_t l, r;
+
+        for(a = 0; a < 3; a++) {
+                lo[a] = INFINITY;
+                hi[a] = -INFINITY;
+        }
+
+        for(i = first; i < first + count; i++) {
+                for(a = 0; a < 3; a++) {
+                        lo[a] = minf(lo[a], centroid(&boxes[i], a));
+                        hi[a] = maxf(hi[a], centroid(&boxes[i], a));
+                }
+        }
+
+        for(a = 1; a < 3; a++) {
+                if(hi[a] - lo[a] > hi[axis] - lo[axis]) {
+                        axis = a;
+                }
+        }
+        n->axis = axis;
+
+        if(depth >= BVH_DEPTH || !(hi[axis] - lo[axis] > 0)) {
+                return medianSplit(b, boxes, first, count, axis);
+        }
+
+        // An extent that overflows to inf gives a scale of 0, and inf * 0
+        // can't be binned.
+        scale = BVH_BINS / (hi[axis] - lo[axis]);
+        if(!(scale > 0) || !isfinite(scale)) {
+                return medianSplit(b, boxes, first, count, axis);
+        }
+
+        for(i = 0; i < BVH_BINS; i++) {
+                binEmpty(&bins[i]);
+        }
+
+        for(i = first; i < first + count; i++) {
+                const bin_t* box = &boxes[i];
+
+                binGrow(&bins[binOf(box, axis, lo[axis], scale)], box);
+        }
+
+        // Sweep from each end. Both end buckets hold a centroid, so every
+        // split leaves something on both sides.
+        left[0] = bins[0];
+        for(i = 1; i < BVH_BINS; i++) {
+                left[i] = left[i - 1];
+                binGrow(&left[i], &bins[i]);
+        }
+
+        binEmpty(&right);
+        for(i = BVH_BINS - 1; i > 0; i--) {
+                binGrow(&right, &bins[i]);
+                cost = binCost(&left[i - 1]) + binCost(&right);
+
+                if(cost < best) {
+                        best = cost;
+                        at = i;
+                }
+        }
+
+        if(at == 0) {
+                return medianSplit(b, boxes, first, count, axis);
+        }
+
+        // Partition around bucket `at`
+        l = first;
+        r = first + count;
+        while(l < r) {
+                if(binOf(&boxes[l], axis, lo[axis], scale) < at) {
+                        l++;
+                } else {
+                        swapTris(b, boxes, l, --r);
+                }
+        }
+
+        return l - first;
+}
+
+static bool build(bvh_t* b) {
+        bin_t* boxes = NULL;
+        task_t* tasks = NULL;
+        size_t top = 0;
+        size_t i, a;
+
+        boxes = malloc(b->triCount * sizeof(bin_t));
+        tasks = malloc(b->triCount * sizeof(task_t));
+        check_mem(boxes && tasks);
+
+        for(i = 0; i < b->triCount; i++) {
+                bvh_node_t n;
+
+                b->tris[i] = i;
+                bound(b, &n, i, 1);
+
+                for(a = 0; a < 3; a++) {
+                        boxes[i].min[a] = n.min[a];
+                        boxes[i].max[a] = n.max[a];
+                }
+                boxes[i].count = 1;
+        }
+
+        b->nodeCount = 1;
+        tasks[top++] = (task_t){ 0, 0, b->triCount, 0 };
+
+        while(top > 0) {
+                task_t t = tasks[--top];
+                bvh_node_t* n = &b->nodes[t.node];
+                bin_t all;
+                size_t left;
+
+                binEmpty(&all);
+                for(i = t.first; i < t.first + t.count; i++) {
+                        binGrow(&all, &boxes[i]);
+                }
+
+                for(a = 0; a < 3; a++) {
+                        n->min[a] = all.min[a];
+                        n->max[a] = all.max[a];
+                }
+                n->axis = 0;
+
+                if(t.count <= BVH_LEAF) {
+                        n->first = t.first;
+                        n->count = t.count;
+                        continue;
+                }
+
+                left = split(b, boxes, n, t.first, t.count, t.depth);
+                n->first = b->nodeCount;
+                n->count = 0;
+                b->nodeCount += 2;
+
+                tasks[top++] = (task_t){ n->first, t.first, left, t.depth + 1 };
+                tasks[top++] = (task_t){ n->first + 1, t.first + left,
+                                         t.count - left, t.depth + 1 };
+        }
+
+        free(boxes);
+        free(tasks);
+
+        return true;
+ error:
+        free(boxes);
+        free(tasks);
+        return false;
+}
+
+// --- SINGLE RAYS --- //
+
+/* Both the plain and SSE tests form each value in the same order, so they
+   always agree. */
+
+static bool slab(const bvh_node_t* n, const ray_t* r, GLfloat tmax) {
+        GLfloat tn = 0;
+        GLfloat tf = tmax * SLAB_SLACK;
+        size_t a;
+
+        for(a = 0; a < 3; a++) {
+                GLfloat t0 = (n->min[a] - r->o[a]) * r->inv[a];
+                GLfloat t1 = (n->max[a] - r->o[a]) * r->inv[a];
+
+                tn = maxf(tn, minf(t0, t1));
+                tf = minf(tf, maxf(t0, t1));
+        }
+
+        return tn <= tf;
+}
+
+/* Möller-Trumbore */
+static bool triangle(const bvh_t* b, uint32_t tri, const ray_t* r,
+                     GLfloat* t, GLfloat* u, GLfloat* v) {
+        const GLfloat *v0, *v1, *v2;
+        GLfloat e1[3], e2[3], s[3], p[3], q[3];
+        GLfloat det, inv;
+        size_t a;
+
+        corners(b, tri, &v0, &v1, &v2);
+        for(a = 0; a < 3; a++) {
+                e1[a] = v1[a] - v0[a];
+                e2[a] = v2[a] - v0[a];
+                s[a] = r->o[a] - v0[a];
+        }
+
+        p[0] = r->d[1] * e2[2] - r->d[2] * e2[1];
+        p[1] = r->d[2] * e2[0] - r->d[0] * e2[2];
+        p[2] = r->d[0] * e2[1] - r->d[1] * e2[0];
+        q[0] = s[1] * e1[2] - s[2] * e1[1];
+        q[1] = s[2] * e1[0] - s[0] * e1[2];
+        q[2] = s[0] * e1[1] - s[1] * e1[0];
+
+        det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        inv = 1 / det;
+        *u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+        *v = (r->d[0] * q[0] + r->d[1] * q[1] + r->d[2] * q[2]) * inv;
+        *t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+
+        return det != 0 && *u >= 0 && *v >= 0 && *u + *v <= 1 && *t > 0;
+}
+
+/* Is a hit at `t` on `tri` better than the best so far? Ties go to the
+   lower index, so the answer doesn't depend on the order of the tests.
+   The signed compare puts OGLL_BVH_MISS first, so nothing ties with the
+   limit of a ray. */
+static bool closer(GLfloat t, uint32_t tri, const hit_t* best) {
+        return t < best->t ||
+                (t == best->t && (int32_t)tri < (int32_t)best->triangle);
+}
+
+static void cast(const bvh_t* b, const ray_t* r, hit_t* hit, bool any) {
+        uint32_t stack[BVH_STACK];
+        size_t top = 0;
+        GLfloat t, u, v;
+        size_t i;
+
+        hit->t = r->tmax;
+        hit->u = 0;
+        hit->v = 0;
+        hit->triangle = OGLL_BVH_MISS;
+
+        if(b->triCount > 0) {
+                stack[top++] = 0;
+        }
+
+        while(top > 0) {
+                const bvh_node_t* n = &b->nodes[stack[--top]];
+
+                if(!slab(n, r, hit->t)) {
+                        continue;
+                }
+
+                if(n->count > 0) {
+                        for(i = n->first; i < n->first + n->count; i++) {
+                                uint32_t tri = b->tris[i];
+
+                                if(triangle(b, tri, r, &t, &u, &v) && closer(t, tri, hit)) {
+                                        hit->t = t;
+                                        hit->u = u;
+                                        hit->v = v;
+                                        hit->triangle = tri;
+
+                                        if(any) {
+                                                return;
+                                        }
+                                }
+                        }
+                } else {
+                        // Near child on top
+                        bool back = r->d[n->axis] < 0;
+
+                        stack[top++] = n->first + !back;
+                        stack[top++] = n->first + back;
+                }
+        }
+}
+
+static void makeRay(ray_t* r, GLfloat ox, GLfloat oy, GLfloat oz,
+                    GLfloat dx, GLfloat dy, GLfloat dz, GLfloat tmax) {
+        r->o[0] = ox;
+        r->o[1] = oy;
+        r->o[2] = oz;
+        r->d[0] = dx;
+        r->d[1] = dy;
+        r->d[2] = dz;
+        r->inv[0] = 1 / dx;
+        r->inv[1] = 1 / dy;
+        r->inv[2] = 1 / dz;
+        r->tmax = tmax;
+}
+
+// --- PACKETS --- //
+
+#ifdef OGLL_X86
+
+typedef struct packet_t {
+        __m128 o[3];
+        __m128 d[3];
+        __m128 inv[3];
+        __m128 t, u, v;
+        __m128i tri;
+} packet_t;
+
+__attribute__((target("sse2")))
+static __m128 sseSelect(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/* Lanes whose ray meets the box */
+__attribute__((target("sse2")))
+static int sseSlab(const bvh_node_t* n, const packet_t* p) {
+        __m128 tn = _mm_setzero_ps();
+        __m128 tf = _mm_mul_ps(p->t, _mm_set1_ps(SLAB_SLACK));
+        size_t a;
+
+        for(a = 0; a < 3; a++) {
+                __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(n->min[a]), p->o[a]), p->inv[a]);
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(n->max[a]), p->o[a]), p->inv[a]);
+
+                tn = _mm_max_ps(tn, _mm_min_ps(t0, t1));
+                tf = _mm_min_ps(tf, _mm_max_ps(t0, t1));
+        }
+
+        return _mm_movemask_ps(_mm_cmple_ps(tn, tf));
+}
+
+/* One triangle against four rays. Yields the lanes it improved on. */
+__attribute__((target("sse2")))
+static int sseTriangle(const bvh_t* b, uint32_t tri, packet_t* p, int lanes) {
+        const GLfloat *v0, *v1, *v2;
+        __m128 e1[3], e2[3], s[3], pv[3], qv[3];
+        __m128 det, inv, u, v, t, ok, better;
+        __m128i id = _mm_set1_epi32((int32_t)tri);
+        size_t a;
+
+        corners(b, tri, &v0, &v1, &v2);
+        for(a = 0; a < 3; a++) {
+                e1[a] = _mm_set1_ps(v1[a] - v0[a]);
+                e2[a] = _mm_set1_ps(v2[a] - v0[a]);
+                s[a] = _mm_sub_ps(p->o[a], _mm_set1_ps(v0[a]));
+        }
+
+        pv[0] = _mm_sub_ps(_mm_mul_ps(p->d[1], e2[2]), _mm_mul_ps(p->d[2], e2[1]));
+        pv[1] = _mm_sub_ps(_mm_mul_ps(p->d[2], e2[0]), _mm_mul_ps(p->d[0], e2[2]));
+        pv[2] = _mm_sub_ps(_mm_mul_ps(p->d[0], e2[1]), _mm_mul_ps(p->d[1], e2[0]));
+        qv[0] = _mm_sub_ps(_mm_mul_ps(s[1], e1[2]), _mm_mul_ps(s[2], e1[1]));
+        qv[1] = _mm_sub_ps(_mm_mul_ps(s[2], e1[0]), _mm_mul_ps(s[0], e1[2]));
+        qv[2] = _mm_sub_ps(_mm_mul_ps(s[0], e1[1]), _mm_mul_ps(s[1], e1[0]));
+
+        det = _mm_mul_ps(e1[0], pv[0]);
+        det = _mm_add_ps(det, _mm_mul_ps(e1[1], pv[1]));
+        det = _mm_add_ps(det, _mm_mul_ps(e1[2], pv[2]));
+        inv = _mm_div_ps(_mm_set1_ps(1), det);
+
+        u = _mm_mul_ps(s[0], pv[0]);
+        u = _mm_add_ps(u, _mm_mul_ps(s[1], pv[1]));
+        u = _mm_mul_ps(_mm_add_ps(u, _mm_mul_ps(s[2], pv[2])), inv);
+        v = _mm_mul_ps(p->d[0], qv[0]);
+        v = _mm_add_ps(v, _mm_mul_ps(p->d[1], qv[1]));
+        v = _mm_mul_ps(_mm_add_ps(v, _mm_mul_ps(p->d[2], qv[2])), inv);
+        t = _mm_mul_ps(e2[0], qv[0]);
+        t = _mm_add_ps(t, _mm_mul_ps(e2[1], qv[1]));
+        t = _mm_mul_ps(_mm_add_ps(t, _mm_mul_ps(e2[2], qv[2])), inv);
+
+        ok = _mm_cmpneq_ps(det, _mm_setzero_ps());
+        ok = _mm_and_ps(ok, _mm_cmpge_ps(u, _mm_setzero_ps()));
+        ok = _mm_and_ps(ok, _mm_cmpge_ps(v, _mm_setzero_ps()));
+        ok = _mm_and_ps(ok, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1)));
+        ok = _mm_and_ps(ok, _mm_cmpgt_ps(t, _mm_setzero_ps()));
+
+        better = _mm_and_ps(_mm_cmpeq_ps(t, p->t),
+                            _mm_castsi128_ps(_mm_cmplt_epi32(id, p->tri)));
+        better = _mm_or_ps(_mm_cmplt_ps(t, p->t), better);
+        ok = _mm_and_ps(ok, better);
+        ok = _mm_and_ps(ok, _mm_castsi128_ps(_mm_set_epi32(-((lanes >> 3) & 1),
+                                                           -((lanes >> 2) & 1),
+                                                           -((lanes >> 1) & 1),
+                                                           -(lanes & 1))));
+
+        lanes = _mm_movemask_ps(ok);
+        if(lanes == 0) {
+                return 0;
+        }
+
+        p->t = sseSelect(ok, t, p->t);
+        p->u = sseSelect(ok, u, p->u);
+        p->v = sseSelect(ok, v, p->v);
+        p->tri = _mm_castps_si128(sseSelect(ok, _mm_castsi128_ps(id),
+                                            _mm_castsi128_ps(p->tri)));
+
+        return lanes;
+}
+
+/* Walk the tree with four rays at once. Lanes not in `live` are left
+   alone. */
+__attribute__((target("sse2")))
+static void sseCast(const bvh_t* b, packet_t* p, int live, bool any) {
+        uint32_t stack[BVH_STACK];
+        size_t top = 0;
+        GLfloat dirs[3][4];
+        size_t i, a;
+
+        for(a = 0; a < 3; a++) {
+                _mm_storeu_ps(dirs[a], p->d[a]);
+        }
+
+        if(b->triCount > 0) {
+                stack[top++] = 0;
+        }
+
+        while(top > 0 && live) {
+                const bvh_node_t* n = &b->nodes[stack[--top]];
+                int lanes = sseSlab(n, p) & live;
+
+                if(lanes == 0) {
+                        continue;
+                }
+
+                if(n->count > 0) {
+                        for(i = n->first; i < n->first + n->count; i++) {
+                                int found = sseTriangle(b, b->tris[i], p, lanes);
+
+                                if(any) {
+                                        live &= ~found;
+                                        lanes &= ~found;
+                                }
+                        }
+                } else {
+                        // Near child on top, by vote of the lanes
+                        size_t back = 0, all = 0;
+
+                        for(i = 0; i < 4; i++) {
+                                if(lanes & (1 << i)) {
+                                        all++;
+                                        back += dirs[n->axis][i] < 0;
+                                }
+                        }
+
+                        stack[top++] = n->first + (2 * back <= all);
+                        stack[top++] = n->first + (2 * back > all);
+                }
+        }
+}
+
+/* Rays [begin,end) in packets of four. Yields where it stopped. */
+__attribute__((target("sse2")))
+static size_t sseRange(job_t* job, size_t begin, size_t end, size_t* count) {
+        const soa_t* os = job->origins;
+        const soa_t* ds = job->dirs;
+        packet_t p;
+        GLfloat t[4], u[4], v[4];
+        int32_t tri[4];
+        size_t k, i;
+
+        for(k = begin; k + 4 <= end; k += 4) {
+                p.o[0] = _mm_loadu_ps(os->x + k);
+                p.o[1] = _mm_loadu_ps(os->y + k);
+                p.o[2] = _mm_loadu_ps(os->z + k);
+                p.d[0] = _mm_loadu_ps(ds->x + k);
+                p.d[1] = _mm_loadu_ps(ds->y + k);
+                p.d[2] = _mm_loadu_ps(ds->z + k);
+                for(i = 0; i < 3; i++) {
+                        p.inv[i] = _mm_div_ps(_mm_set1_ps(1), p.d[i]);
+                }
+                p.t = job->tmax ? _mm_loadu_ps(job->tmax + k) : _mm_set1_ps(INFINITY);
+                p.u = _mm_setzero_ps();
+                p.v = _mm_setzero_ps();
+                p.tri = _mm_set1_epi32(-1);
+
+                sseCast(job->b, &p, 0xf, job->any);
+
+                _mm_storeu_ps(t, p.t);
+                _mm_storeu_ps(u, p.u);
+                _mm_storeu_ps(v, p.v);
+                _mm_storeu_si128((__m128i*)tri, p.tri);
+
+                for(i = 0; i < 4; i++) {
+                        *count += tri[i] != -1;
+
+                        if(job->any) {
+                                job->occluded[k + i] = tri[i] != -1;
+                        } else {
+                                job->hits[k + i].t = t[i];
+                                job->hits[k + i].u = u[i];
+                                job->hits[k + i].v = v[i];
+                                job->hits[k + i].triangle = (uint32_t)tri[i];
+                        }
+                }
+        }
+
+        return k;
+}
+
+#endif
+
+static void castRange(void* arg, size_t begin, size_t end) {
+        job_t* job = arg;
+        const soa_t* os = job->origins;
+        const soa_t* ds = job->dirs;
+        size_t count = 0;
+        size_t k = begin;
+        ray_t r;
+        hit_t h;
+
+#ifdef OGLL_X86
+        if(job->sse) {
+                k = sseRange(job, begin, end, &count);
+        }
+#endif
+
+        for(; k < end; k++) {
+                makeRay(&r, os->x[k], os->y[k], os->z[k], ds->x[k], ds->y[k], ds->z[k],
+                        job->tmax ? job->tmax[k] : INFINITY);
+                cast(job->b, &r, &h, job->any);
+
+                count += h.triangle != OGLL_BVH_MISS;
+
+                if(job->any) {
+                        job->occluded[k] = h.triangle != OGLL_BVH_MISS;
+                } else {
+                        job->hits[k] = h;
+                }
+        }
+
+        __atomic_fetch_add(&job->count, count, __ATOMIC_RELAXED);
+}
+
+static size_t castAll(job_t* job, pool_t* pool) {
+        job->count = 0;
+        job->sse = useSse();
+
+        ogllPoolFor(pool, job->origins->count, BVH_GRAIN, castRange, job);
+
+        return job->count;
+}
+
+// --- HIERARCHIES --- //
+
+/* Build a hierarchy over a triangle array */
+bvh_t* ogllBvhCreate(const GLfloat* vertices, const uint32_t* indices,
+                     size_t triangles) {
+        OGLL_PROBE();
+        bvh_t* b = NULL;
+
+        check(vertices || triangles == 0, "Null vertices given.");
+        check(triangles < INT32_MAX, "Too many triangles.");
+
+        b = calloc(1, sizeof(bvh_t));
+        check_mem(b);
+
+        b->vertices = vertices;
+        b->indices = indices;
+        b->triCount = triangles;
+
+        if(triangles > 0) {
+                b->nodes = malloc((2 * triangles - 1) * sizeof(bvh_node_t));
+                b->tris = malloc(triangles * sizeof(uint32_t));
+                check_mem(b->nodes && b->tris);
+
+                check(build(b), "Hierarchy build failed.");
+        }
+
+        return b;
+ error:
+        ogllBvhDestroy(b);
+        return NULL;
+}
+
+/* Deallocate a hierarchy */
+void ogllBvhDestroy(bvh_t* b) {
+        OGLL_PROBE();
+        if(b) {
+                free(b->nodes);
+                free(b->tris);
+                free(b);
+        }
+}
+
+/* Recompute every bound after the vertices have moved */
+bool ogllBvhRefit(bvh_t* b, const GLfloat* vertices) {
+        OGLL_PROBE();
+        size_t i, a;
+
+        check(b, "Null hierarchy given.");
+
+        if(vertices) {
+                b->vertices = vertices;
+        }
+
+        // Children always come after their parent
+        for(i = b->nodeCount; i-- > 0;) {
+                bvh_node_t* n = &b->nodes[i];
+
+                if(n->count > 0) {
+                        bound(b, n, n->first, n->count);
+                } else {
+                        const bvh_node_t* l = &b->nodes[n->first];
+                        const bvh_node_t* r = &b->nodes[n->first + 1];
+
+                        for(a = 0; a < 3; a++) {
+                                n->min[a] = minf(l->min[a], r->min[a]);
+                                n->max[a] = maxf(l->max[a], r->max[a]);
+                        }
+                }
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* Nearest hit of a single ray */
+bool ogllBvhIntersect(const bvh_t* b, vec3_t origin, vec3_t dir,
+                      GLfloat tmax, hit_t* hit) {
+        OGLL_PROBE();
+        ray_t r;
+
+        check(b && hit, "Null argument given.");
+
+        makeRay(&r, origin.x, origin.y, origin.z, dir.x, dir.y, dir.z, tmax);
+        cast(b, &r, hit, false);
+
+        return hit->triangle != OGLL_BVH_MISS;
+ error:
+        return false;
+}
+
+/* Nearest hit of every ray */
+size_t ogllBvhIntersectRays(const bvh_t* b, const soa_t* origins,
+                            const soa_t* dirs, const GLfloat* tmax,
+                            hit_t* hits, pool_t* pool) {
+        OGLL_PROBE();
+        job_t job = { b, origins, dirs, tmax, hits, NULL, false, false, 0 };
+
+        check(b && origins && dirs && hits, "Null argument given.");
+        check(origins->count == dirs->count, "Ray streams aren't the same length.");
+
+        return castAll(&job, pool);
+ error:
+        return 0;
+}
+
+/* Is anything in the way of each ray? */
+size_t ogllBvhOccludedRays(const bvh_t* b, const soa_t* origins,
+                           const soa_t* dirs, const GLfloat* tmax,
+                           uint8_t* occluded, pool_t* pool) {
+        OGLL_PROBE();
+        job_t job = { b, origins, dirs, tmax, NULL, occluded, true, false, 0 };
+
+        check(b && origins && dirs && occluded, "Null argument given.");
+        check(origins->count == dirs->count, "Ray streams aren't the same length.");
+
+        return castAll(&job, pool);
+ error:
+        return 0;
+}
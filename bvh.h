@@ -0,0 +1,99 @@
+#ifndef __ogll_bvh__
+#define __ogll_bvh__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "value.h"
+#include "soa.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Ray casting against triangle meshes through a bounding volume
+ * hierarchy.
+ *
+ * The hierarchy is built once over a triangle array, with a binned
+ * surface area heuristic. Rays are best cast in model space: transform
+ * them by the inverse of the model Matrix rather than moving the mesh.
+ * When the mesh itself changes (skinning, or vertices baked through
+ * `ogllM4Rotate` and `ogllM4TransformN`), `ogllBvhRefit` recomputes the
+ * bounds in place in linear time. Refitting keeps the old tree shape, so
+ * after large deformations a rebuild casts faster.
+ *
+ * Batches of rays are cast in packets of four that walk the tree
+ * together, with SSE slab and triangle tests, in chunks spread over a
+ * `pool_t`. Each ray gets the same hit whichever SIMD backend is active:
+ * triangle tests are bit-identical, and ties in distance go to the
+ * lowest triangle index.
+ */
+
+// --- //
+
+/* Triangle index of a ray that hit nothing */
+#define OGLL_BVH_MISS UINT32_MAX
+
+typedef struct bvh_node_t {
+        GLfloat min[3];
+        uint32_t first;         // Left child, or first triangle of a leaf
+        GLfloat max[3];
+        uint16_t count;         // Triangles in a leaf, 0 for inner nodes
+        uint16_t axis;          // Split axis of an inner node
+} bvh_node_t;
+
+typedef struct bvh_t {
+        bvh_node_t* nodes;      // Root first. Children follow their parent.
+        size_t nodeCount;
+        uint32_t* tris;         // Triangle indices in leaf order
+        size_t triCount;
+        const GLfloat* vertices;   // Borrowed
+        const uint32_t* indices;   // Borrowed. May be NULL.
+} bvh_t;
+
+typedef struct hit_t {
+        GLfloat t;              // Distance along the ray, in units of its direction
+        GLfloat u, v;           // Barycentric coordinates of the hit
+        uint32_t triangle;      // OGLL_BVH_MISS if nothing was hit
+} hit_t;
+
+/* Build a hierarchy over `triangles` triangles. `vertices` holds packed
+   xyz. `indices` holds 3 per triangle, or is NULL if every 3 vertices
+   make a triangle. Both arrays are borrowed, not copied, and must
+   outlive the hierarchy. */
+bvh_t* ogllBvhCreate(const GLfloat* vertices, const uint32_t* indices,
+                     size_t triangles);
+
+/* Deallocate a hierarchy */
+void ogllBvhDestroy(bvh_t* b);
+
+/* Recompute every bound after the vertices have moved. `vertices` is the
+   new array, laid out like the old one, or NULL if the old one was
+   changed in place. */
+bool ogllBvhRefit(bvh_t* b, const GLfloat* vertices);
+
+/* Nearest hit of a single ray within (0, tmax). Yields whether there was
+   one. */
+bool ogllBvhIntersect(const bvh_t* b, vec3_t origin, vec3_t dir,
+                      GLfloat tmax, hit_t* hit);
+
+/* Nearest hit of every ray, from the xyz of `origins` and `dirs`.
+   `tmax` holds one limit per ray, or is NULL for no limit. `pool` may be
+   NULL to run on the calling thread only. Yields how many rays hit. */
+size_t ogllBvhIntersectRays(const bvh_t* b, const soa_t* origins,
+                            const soa_t* dirs, const GLfloat* tmax,
+                            hit_t* hits, pool_t* pool);
+
+/* Is anything in the way of each ray within (0, tmax)? Stops at the
+   first hit found, so it's cheaper than the nearest hit for line of
+   sight. Writes 1 or 0 per ray to `occluded`, and yields how many were. */
+size_t ogllBvhOccludedRays(const bvh_t* b, const soa_t* origins,
+                           const soa_t* dirs, const GLfloat* tmax,
+                           uint8_t* occluded, pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
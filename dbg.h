@@ -8,7 +8,9 @@
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <assert.h>
 #include "colour.h"
+#include "error.h"
 
 #ifdef NDEBUG
 #define debug(M, ...)
@@ -16,6 +18,11 @@
 #define debug(M, ...) fprintf(stderr, "[" ANSI_MAGENTA "DEBUG" ANSI_RESET "] (%s:%d:%s) " M "\n", __FILE__, __LINE__, __func__, ##__VA_ARGS__)
 #endif
 
+/* Hook for counting failed checks. See instrument.h. */
+#ifndef OGLL_PROBE_FAIL
+#define OGLL_PROBE_FAIL()
+#endif
+
 #define clean_errno() (errno == 0 ? "None" : strerror(errno))
 
 #define log_err(M, ...) fprintf(stderr, "[" ANSI_RED "ERROR" ANSI_RESET "] (%s:%d:%s: errno: %s) " M "\n", __FILE__, __LINE__, __func__, clean_errno(), ##__VA_ARGS__)
@@ -24,13 +31,29 @@
 
 #define log_info(M, ...) fprintf(stderr, "[" ANSI_CYAN "INFO" ANSI_RESET " ] (%s:%d:%s) " M "\n", __FILE__, __LINE__, __func__, ##__VA_ARGS__)
 
-#define check(A, M, ...) if(!(A)) { log_err(M, ##__VA_ARGS__); errno=0; goto error; }
+/* A failed check records itself in the thread's error slot (error.h),
+   then logs unless that's off or compiled out. */
+#ifdef OGLL_QUIET_CHECKS
+#define log_fail(M, ...)
+#else
+#define log_fail(M, ...) if(ogllErrorLogging()) { log_err(M, ##__VA_ARGS__); errno=0; }
+#endif
+
+#ifdef OGLL_ASSERT_CHECKS
+#define assert_fail(M) assert(!M)
+#else
+#define assert_fail(M)
+#endif
+
+#define ogll_fail(S, M, ...) { ogllErrorRecord(S, __func__, __FILE__, __LINE__, M); log_fail(M, ##__VA_ARGS__); OGLL_PROBE_FAIL(); assert_fail(M); goto error; }
+
+#define check(A, M, ...) if(__builtin_expect(!(A), 0)) ogll_fail(OGLL_EINVAL, M, ##__VA_ARGS__)
 
 #define quiet_check(A) if(!(A)) { errno=0; goto error; }
 
-#define sentinel(M, ...)  { log_err(M, ##__VA_ARGS__); errno=0; goto error; }
+#define sentinel(M, ...) ogll_fail(OGLL_EINVAL, M, ##__VA_ARGS__)
 
-#define check_mem(A) check((A), "Out of memory.")
+#define check_mem(A) if(__builtin_expect(!(A), 0)) ogll_fail(OGLL_ENOMEM, "Out of memory.")
 
 #define check_debug(A, M, ...) if(!(A)) { debug(M, ##__VA_ARGS__); errno=0; goto error; }
 
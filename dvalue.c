@@ -0,0 +1,412 @@
+#include <stdio.h>
+#include <math.h>
+
+#include "dvalue.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+// --- VECTORS --- //
+
+/* Construct Vectors from their components */
+dvec3_t ogllDV3Make(GLdouble x, GLdouble y, GLdouble z) {
+        OGLL_PROBE();
+        dvec3_t v = { x, y, z };
+        return v;
+}
+
+dvec4_t ogllDV4Make(GLdouble x, GLdouble y, GLdouble z, GLdouble w) {
+        OGLL_PROBE();
+        dvec4_t v = { x, y, z, w };
+        return v;
+}
+
+/* Widen or narrow a Vector */
+dvec3_t ogllDV3FromV3(vec3_t v) {
+        OGLL_PROBE();
+        return ogllDV3Make(v.x, v.y, v.z);
+}
+
+vec3_t ogllDV3ToV3(dvec3_t v) {
+        OGLL_PROBE();
+        return ogllV3Make(v.x, v.y, v.z);
+}
+
+/* Component-wise sum and difference of two Vectors */
+dvec3_t ogllDV3Add(dvec3_t v1, dvec3_t v2) {
+        OGLL_PROBE();
+        return ogllDV3Make(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);
+}
+
+dvec3_t ogllDV3Sub(dvec3_t v1, dvec3_t v2) {
+        OGLL_PROBE();
+        return ogllDV3Make(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z);
+}
+
+/* Scale a Vector by some scalar */
+dvec3_t ogllDV3Scale(dvec3_t v, GLdouble f) {
+        OGLL_PROBE();
+        return ogllDV3Make(v.x * f, v.y * f, v.z * f);
+}
+
+/* The Cross-Product of two Vectors. Agrees with `ogllV3Cross`. */
+dvec3_t ogllDV3Cross(dvec3_t v1, dvec3_t v2) {
+        OGLL_PROBE();
+        return ogllDV3Make(v1.y * v2.z - v1.z * v2.y,
+                           v1.z * v2.x - v1.x * v2.z,
+                           v1.x * v2.y - v1.y * v2.x);
+}
+
+/* Yields the Dot Product of two Vectors */
+GLdouble ogllDV3Dot(dvec3_t v1, dvec3_t v2) {
+        OGLL_PROBE();
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+
+GLdouble ogllDV4Dot(dvec4_t v1, dvec4_t v2) {
+        OGLL_PROBE();
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+}
+
+/* Yields the Length/Magnitude of a given Vector */
+GLdouble ogllDV3Length(dvec3_t v) {
+        OGLL_PROBE();
+        return sqrt(ogllDV3Dot(v,v));
+}
+
+GLdouble ogllDV4Length(dvec4_t v) {
+        OGLL_PROBE();
+        return sqrt(ogllDV4Dot(v,v));
+}
+
+// --- MATRICES --- //
+
+/* A 4x4 Matrix of all 0s */
+dmat4_t ogllDMat4Zero(void) {
+        OGLL_PROBE();
+        dmat4_t m = {{ 0 }};
+        return m;
+}
+
+/* The 4x4 Identity Matrix */
+dmat4_t ogllDMat4Identity(void) {
+        OGLL_PROBE();
+        dmat4_t m = {{
+                1,0,0,0,
+                0,1,0,0,
+                0,0,1,0,
+                0,0,0,1
+        }};
+        return m;
+}
+
+/* A 4x4 Matrix from 16 column-major doubles */
+dmat4_t ogllDMat4FromArray(const GLdouble* ds) {
+        OGLL_PROBE();
+        dmat4_t m;
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                m.m[i] = ds[i];
+        }
+
+        return m;
+}
+
+/* Widen a float Matrix */
+dmat4_t ogllDMat4FromMat4(const mat4_t* m) {
+        OGLL_PROBE();
+        dmat4_t d;
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                d.m[i] = m->m[i];
+        }
+
+        return d;
+}
+
+/* Narrow a Matrix to float */
+mat4_t* ogllDMat4ToMat4(mat4_t* dst, const dmat4_t* m) {
+        OGLL_PROBE();
+        size_t i;
+
+        check(dst && m, "Null Matrices given.");
+
+        for(i = 0; i < 16; i++) {
+                dst->m[i] = m->m[i];
+        }
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Are two Matrices equal? */
+bool ogllDMat4Equal(const dmat4_t* m1, const dmat4_t* m2) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                if(m1->m[i] != m2->m[i]) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+/* Multiply two 4x4 matrices together in place. Affects `m1`. */
+dmat4_t* ogllDMat4Multiply(dmat4_t* m1, const dmat4_t* m2) {
+        OGLL_PROBE();
+        ogllSimdDM4Multiply(m1->m, m1->m, m2->m);
+
+        return m1;
+}
+
+/* Multiply two 4x4 matrices together. Returns the product by value. */
+dmat4_t ogllDMat4MultiplyP(const dmat4_t* m1, const dmat4_t* m2) {
+        OGLL_PROBE();
+        dmat4_t p;
+
+        ogllSimdDM4Multiply(p.m, m1->m, m2->m);
+
+        return p;
+}
+
+/* Transform a Vector by a 4x4 Matrix: m * v */
+dvec4_t ogllDMat4MultiplyV(const dmat4_t* m, dvec4_t v) {
+        OGLL_PROBE();
+        ogllSimdDM4Transform((GLdouble*)&v, m->m, (GLdouble*)&v);
+
+        return v;
+}
+
+/* Transpose a 4x4 Matrix. Returns the result by value. */
+dmat4_t ogllDMat4Transpose(const dmat4_t* m) {
+        OGLL_PROBE();
+        dmat4_t t;
+        size_t i,j;
+
+        for(i = 0; i < 4; i++) {
+                for(j = 0; j < 4; j++) {
+                        t.m[i * 4 + j] = m->m[j * 4 + i];
+                }
+        }
+
+        return t;
+}
+
+/* Invert a 4x4 Matrix. Same cofactor expansion as the scalar float
+   kernel in simd.c. */
+dmat4_t* ogllDMat4Inverse(dmat4_t* dst, const dmat4_t* m) {
+        OGLL_PROBE();
+        check(dst && m, "Null Matrices given.");
+
+        const GLdouble* a = m->m;
+        GLdouble s0 = a[0] * a[5] - a[4] * a[1];
+        GLdouble s1 = a[0] * a[6] - a[4] * a[2];
+        GLdouble s2 = a[0] * a[7] - a[4] * a[3];
+        GLdouble s3 = a[1] * a[6] - a[5] * a[2];
+        GLdouble s4 = a[1] * a[7] - a[5] * a[3];
+        GLdouble s5 = a[2] * a[7] - a[6] * a[3];
+        GLdouble c5 = a[10] * a[15] - a[14] * a[11];
+        GLdouble c4 = a[9]  * a[15] - a[13] * a[11];
+        GLdouble c3 = a[9]  * a[14] - a[13] * a[10];
+        GLdouble c2 = a[8]  * a[15] - a[12] * a[11];
+        GLdouble c1 = a[8]  * a[14] - a[12] * a[10];
+        GLdouble c0 = a[8]  * a[13] - a[12] * a[9];
+        GLdouble det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        GLdouble inv;
+        dmat4_t r;
+
+        check(det != 0, "Matrix is singular.");
+
+        inv = 1 / det;
+
+        r.m[0]  = ( a[5]  * c5 - a[6]  * c4 + a[7]  * c3) * inv;
+        r.m[1]  = (-a[1]  * c5 + a[2]  * c4 - a[3]  * c3) * inv;
+        r.m[2]  = ( a[13] * s5 - a[14] * s4 + a[15] * s3) * inv;
+        r.m[3]  = (-a[9]  * s5 + a[10] * s4 - a[11] * s3) * inv;
+        r.m[4]  = (-a[4]  * c5 + a[6]  * c2 - a[7]  * c1) * inv;
+        r.m[5]  = ( a[0]  * c5 - a[2]  * c2 + a[3]  * c1) * inv;
+        r.m[6]  = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * inv;
+        r.m[7]  = ( a[8]  * s5 - a[10] * s2 + a[11] * s1) * inv;
+        r.m[8]  = ( a[4]  * c4 - a[5]  * c2 + a[7]  * c0) * inv;
+        r.m[9]  = (-a[0]  * c4 + a[1]  * c2 - a[3]  * c0) * inv;
+        r.m[10] = ( a[12] * s4 - a[13] * s2 + a[15] * s0) * inv;
+        r.m[11] = (-a[8]  * s4 + a[9]  * s2 - a[11] * s0) * inv;
+        r.m[12] = (-a[4]  * c3 + a[5]  * c1 - a[6]  * c0) * inv;
+        r.m[13] = ( a[0]  * c3 - a[1]  * c1 + a[2]  * c0) * inv;
+        r.m[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * inv;
+        r.m[15] = ( a[8]  * s3 - a[9]  * s1 + a[10] * s0) * inv;
+
+        *dst = r;
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Rotate a 4x4 Matrix in place by `r` radians around the unit vector
+formed by `x` `y` and `z` */
+dmat4_t* ogllDMat4Rotate(dmat4_t* m, GLdouble r,
+                         GLdouble x, GLdouble y, GLdouble z) {
+        OGLL_PROBE();
+        dmat4_t rot = ogllDMat4Identity();
+        GLdouble cosr = cos(r);
+        GLdouble sinr = sin(r);
+
+        // Same construction as `ogllM4Rotate`.
+        // Column 1
+        rot.m[0] = cosr+x*x*(1-cosr);
+        rot.m[1] = y*x*(1-cosr)+z*sinr;
+        rot.m[2] = z*x*(1-cosr)-y*sinr;
+        // Column 2
+        rot.m[4] = x*y*(1-cosr)-z*sinr;
+        rot.m[5] = cosr+y*y*(1-cosr);
+        rot.m[6] = z*y*(1-cosr)+x*sinr;
+        // Column 3
+        rot.m[8]  = x*z*(1-cosr)+y*sinr;
+        rot.m[9]  = y*z*(1-cosr)-x*sinr;
+        rot.m[10] = cosr+z*z*(1-cosr);
+
+        return ogllDMat4Multiply(m,&rot);
+}
+
+/* Adds translation factor to a transformation Matrix (in place) */
+dmat4_t* ogllDMat4Translate(dmat4_t* m, GLdouble x, GLdouble y, GLdouble z) {
+        OGLL_PROBE();
+        m->m[12] = x;
+        m->m[13] = y;
+        m->m[14] = z;
+
+        return m;
+}
+
+/* Writes a Perspective Projection Matrix into `dst` */
+dmat4_t* ogllDMat4Perspective(dmat4_t* dst,
+                              GLdouble fov, GLdouble aspr, GLdouble n, GLdouble f) {
+        OGLL_PROBE();
+        check(dst, "Null Matrix given.");
+        check(aspr > 0, "Invalid Aspect Ratio given.");
+        check(n < f, "Near-clipping plane farther than far-clipping plane!");
+
+        GLdouble t = n * tan(fov / 2.0);
+        GLdouble r = t * aspr;
+
+        *dst = ogllDMat4Zero();
+        dst->m[0]  = n/r;
+        dst->m[5]  = n/t;
+        dst->m[10] = -(f+n)/(f-n);
+        dst->m[11] = -1;
+        dst->m[14] = (-2*f*n)/(f-n);
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* A Cross-Product with the y component negated, as `ogllVCrossP`
+   computes it, so that `ogllDMat4LookAt` agrees with `ogllMat4LookAt` */
+static dvec3_t lookAtCross(dvec3_t v1, dvec3_t v2) {
+        return ogllDV3Make(v1.y * v2.z - v1.z * v2.y,
+                           v1.x * v2.z - v1.z * v2.x,
+                           v1.x * v2.y - v1.y * v2.x);
+}
+
+/* Writes a View Matrix into `dst` */
+dmat4_t* ogllDMat4LookAt(dmat4_t* dst, dvec3_t camPos, dvec3_t target, dvec3_t up) {
+        OGLL_PROBE();
+        dvec3_t camDir, camRight, camUp;
+
+        check(dst, "Null Matrix given.");
+
+        camDir   = ogllDV3Add(camPos, ogllDV3Scale(target,-1));
+        camRight = lookAtCross(up,camDir);
+        camUp    = lookAtCross(camDir,camRight);
+
+        *dst = ogllDMat4Identity();
+
+        // Column 1
+        dst->m[0] = camRight.x;
+        dst->m[1] = camUp.x;
+        dst->m[2] = camDir.x;
+
+        // Column 2
+        dst->m[4] = camRight.y;
+        dst->m[5] = camUp.y;
+        dst->m[6] = camDir.y;
+
+        // Column 3
+        dst->m[8]  = camRight.z;
+        dst->m[9]  = camUp.z;
+        dst->m[10] = camDir.z;
+
+        // Column 4
+        dst->m[12] = -camPos.x;
+        dst->m[13] = -camPos.y;
+        dst->m[14] = -camPos.z;
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Print a Matrix */
+void ogllDMat4Print(const dmat4_t* m) {
+        OGLL_PROBE();
+        size_t i,j;
+
+        if(m) {
+                for(i = 0; i < 4; i++) {
+                        printf("[ ");
+
+                        for(j = 0; j < 4; j++) {
+                                printf("%.2f ", m->m[4 * j + i]);
+                        }
+
+                        printf("]\n");
+                }
+        }
+}
+
+// --- MIXED PRECISION --- //
+
+/* m1 * m2 computed in double, narrowed into `dst` */
+mat4_t* ogllDMat4MultiplyF(mat4_t* dst, const dmat4_t* m1, const dmat4_t* m2) {
+        OGLL_PROBE();
+        dmat4_t p;
+
+        check(dst && m1 && m2, "Null Matrices given.");
+
+        ogllSimdDM4Multiply(p.m, m1->m, m2->m);
+
+        return ogllDMat4ToMat4(dst, &p);
+ error:
+        return NULL;
+}
+
+/* `model` with `eye` taken off its translation, narrowed into `dst` */
+mat4_t* ogllDMat4CameraRelative(mat4_t* dst, const dmat4_t* model, dvec3_t eye) {
+        OGLL_PROBE();
+        dmat4_t rel;
+        size_t j;
+
+        check(dst && model, "Null Matrices given.");
+
+        // T(-eye) * M, without the full product. For affine M the w row
+        // is 0 0 0 1 and only the translation moves.
+        rel = *model;
+        for(j = 0; j < 4; j++) {
+                rel.m[j * 4]     -= eye.x * rel.m[j * 4 + 3];
+                rel.m[j * 4 + 1] -= eye.y * rel.m[j * 4 + 3];
+                rel.m[j * 4 + 2] -= eye.z * rel.m[j * 4 + 3];
+        }
+
+        return ogllDMat4ToMat4(dst, &rel);
+ error:
+        return NULL;
+}
@@ -0,0 +1,132 @@
+#ifndef __ogll_dvalue__
+#define __ogll_dvalue__
+
+#include "value.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Double-precision twins of the value types, for worlds too large for
+ * float. Far from the origin a float can't tell neighbouring millimetres
+ * apart, so positions and transforms are kept and composed in double,
+ * and only the camera-relative result is narrowed to a `mat4_t` for
+ * upload. Nothing in this module touches the heap.
+ *
+ * Layout is column-major, as for `mat4_t`. Products go through the
+ * double SIMD kernels (see simd.h).
+ */
+
+// --- //
+
+typedef struct dvec3_t {
+        GLdouble x, y, z;
+} dvec3_t;
+
+typedef struct dvec4_t {
+        GLdouble x, y, z, w;
+} __attribute__((aligned(16))) dvec4_t;
+
+typedef struct dmat4_t {
+        GLdouble m[16];
+} __attribute__((aligned(32))) dmat4_t;
+
+// --- VECTORS --- //
+
+/* Construct Vectors from their components */
+dvec3_t ogllDV3Make(GLdouble x, GLdouble y, GLdouble z);
+dvec4_t ogllDV4Make(GLdouble x, GLdouble y, GLdouble z, GLdouble w);
+
+/* Widen or narrow a Vector */
+dvec3_t ogllDV3FromV3(vec3_t v);
+vec3_t ogllDV3ToV3(dvec3_t v);
+
+/* Component-wise sum and difference of two Vectors */
+dvec3_t ogllDV3Add(dvec3_t v1, dvec3_t v2);
+dvec3_t ogllDV3Sub(dvec3_t v1, dvec3_t v2);
+
+/* Scale a Vector by some scalar */
+dvec3_t ogllDV3Scale(dvec3_t v, GLdouble f);
+
+/* The Cross-Product of two Vectors. Agrees with `ogllV3Cross`. */
+dvec3_t ogllDV3Cross(dvec3_t v1, dvec3_t v2);
+
+/* Yields the Dot Product of two Vectors */
+GLdouble ogllDV3Dot(dvec3_t v1, dvec3_t v2);
+GLdouble ogllDV4Dot(dvec4_t v1, dvec4_t v2);
+
+/* Yields the Length/Magnitude of a given Vector */
+GLdouble ogllDV3Length(dvec3_t v);
+GLdouble ogllDV4Length(dvec4_t v);
+
+// --- MATRICES --- //
+
+/* A 4x4 Matrix of all 0s */
+dmat4_t ogllDMat4Zero(void);
+
+/* The 4x4 Identity Matrix */
+dmat4_t ogllDMat4Identity(void);
+
+/* A 4x4 Matrix from 16 column-major doubles */
+dmat4_t ogllDMat4FromArray(const GLdouble* ds);
+
+/* Widen a float Matrix */
+dmat4_t ogllDMat4FromMat4(const mat4_t* m);
+
+/* Narrow a Matrix to float, for upload. Returns `dst`. */
+mat4_t* ogllDMat4ToMat4(mat4_t* dst, const dmat4_t* m);
+
+/* Are two Matrices equal? */
+bool ogllDMat4Equal(const dmat4_t* m1, const dmat4_t* m2);
+
+/* Multiply two 4x4 matrices together in place. Affects `m1`. */
+dmat4_t* ogllDMat4Multiply(dmat4_t* m1, const dmat4_t* m2);
+
+/* Multiply two 4x4 matrices together. Returns the product by value. */
+dmat4_t ogllDMat4MultiplyP(const dmat4_t* m1, const dmat4_t* m2);
+
+/* Transform a Vector by a 4x4 Matrix: m * v */
+dvec4_t ogllDMat4MultiplyV(const dmat4_t* m, dvec4_t v);
+
+/* Transpose a 4x4 Matrix. Returns the result by value. */
+dmat4_t ogllDMat4Transpose(const dmat4_t* m);
+
+/* Invert a 4x4 Matrix into `dst`, which may be `m`. Returns NULL,
+   leaving `dst` alone, if `m` is singular. */
+dmat4_t* ogllDMat4Inverse(dmat4_t* dst, const dmat4_t* m);
+
+/* Rotate a 4x4 Matrix in place by `r` radians around the unit vector
+formed by `x` `y` and `z` */
+dmat4_t* ogllDMat4Rotate(dmat4_t* m, GLdouble r,
+                         GLdouble x, GLdouble y, GLdouble z);
+
+/* Adds translation factor to a transformation Matrix (in place) */
+dmat4_t* ogllDMat4Translate(dmat4_t* m, GLdouble x, GLdouble y, GLdouble z);
+
+/* Writes a Perspective Projection Matrix into `dst`.
+   See `ogllMPerspectiveP` for the meaning of the arguments. */
+dmat4_t* ogllDMat4Perspective(dmat4_t* dst,
+                              GLdouble fov, GLdouble aspr, GLdouble n, GLdouble f);
+
+/* Writes a View Matrix into `dst`. Agrees with `ogllMat4LookAt`. */
+dmat4_t* ogllDMat4LookAt(dmat4_t* dst, dvec3_t camPos, dvec3_t target, dvec3_t up);
+
+/* Print a Matrix */
+void ogllDMat4Print(const dmat4_t* m);
+
+// --- MIXED PRECISION --- //
+
+/* m1 * m2 computed in double, narrowed into `dst` */
+mat4_t* ogllDMat4MultiplyF(mat4_t* dst, const dmat4_t* m1, const dmat4_t* m2);
+
+/* `model` with `eye` taken off its translation, narrowed into `dst`.
+   Pair it with a view Matrix built at the origin (camPos = 0, target =
+   target - eye), and the huge coordinates cancel in double before
+   anything is rounded to float. */
+mat4_t* ogllDMat4CameraRelative(mat4_t* dst, const dmat4_t* model, dvec3_t eye);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+#include <stddef.h>
+
+#include "error.h"
+
+// --- //
+
+/* Logging is read on every failure and flipped rarely */
+static int logging = 1;
+
+static __thread ogll_status_t pending = OGLL_OK;
+static __thread ogll_error_t last = { OGLL_OK, NULL, NULL, 0, NULL };
+
+/* The first failure on this thread since the last call */
+ogll_status_t ogllGetError(void) {
+        ogll_status_t s = pending;
+
+        pending = OGLL_OK;
+
+        return s;
+}
+
+/* Details of the most recent failure on this thread */
+const ogll_error_t* ogllLastError(void) {
+        return &last;
+}
+
+/* Human-readable name of a status */
+const char* ogllStatusName(ogll_status_t s) {
+        switch(s) {
+        case OGLL_OK:     return "ok";
+        case OGLL_EINVAL: return "invalid argument";
+        case OGLL_ENOMEM: return "out of memory";
+        default:          return "unknown";
+        }
+}
+
+/* Log failures to stderr? */
+void ogllSetErrorLogging(bool on) {
+        __atomic_store_n(&logging, on, __ATOMIC_RELAXED);
+}
+
+bool ogllErrorLogging(void) {
+        return __atomic_load_n(&logging, __ATOMIC_RELAXED);
+}
+
+/* Record a failure. No I/O. */
+void ogllErrorRecord(ogll_status_t s, const char* func, const char* file,
+                     int line, const char* msg) {
+        // Like `glGetError`, the first failure sticks until it's read.
+        if(pending == OGLL_OK) {
+                pending = s;
+        }
+
+        last.status = s;
+        last.func = func;
+        last.file = file;
+        last.line = line;
+        last.msg = msg;
+}
@@ -0,0 +1,69 @@
+#ifndef __ogll_error__
+#define __ogll_error__
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* What a failed `check()` leaves behind.
+ *
+ * Every failure is recorded in a slot private to the calling thread, with
+ * no I/O: a status code, and where it happened. Functions that can't
+ * signal failure through their return value, like `ogllVDotProduct`
+ * returning 0, can be checked with `ogllGetError`, which works like
+ * `glGetError`.
+ *
+ * By default each failure is also logged to stderr, which is what you
+ * want while developing. In a hot loop that's a `strerror` and an
+ * `fprintf` per failure, so it can be switched off at runtime with
+ * `ogllSetErrorLogging`, or compiled out by building the library with
+ * -DOGLL_QUIET_CHECKS.
+ *
+ * Built with -DOGLL_ASSERT_CHECKS, a failed check also trips an
+ * `assert` at the spot, so debug builds stop on the first misuse. Under
+ * NDEBUG that compiles away and only the slot is set. The check itself
+ * is always evaluated, since many wrap calls that do the actual work.
+ */
+
+// --- //
+
+typedef enum ogll_status_t {
+        OGLL_OK,
+        OGLL_EINVAL,   // A check on the arguments failed
+        OGLL_ENOMEM    // Memory ran out
+} ogll_status_t;
+
+typedef struct ogll_error_t {
+        ogll_status_t status;
+        const char* func;
+        const char* file;
+        int line;
+        const char* msg;   // Unformatted
+} ogll_error_t;
+
+/* The first failure on this thread since the last call, or OGLL_OK.
+   Resets the status to OGLL_OK. */
+ogll_status_t ogllGetError(void);
+
+/* Details of the most recent failure on this thread. Not reset by
+   `ogllGetError`. Status is OGLL_OK if nothing has failed yet. */
+const ogll_error_t* ogllLastError(void);
+
+/* Human-readable name of a status */
+const char* ogllStatusName(ogll_status_t s);
+
+/* Log failures to stderr? On by default. Applies to every thread. */
+void ogllSetErrorLogging(bool on);
+bool ogllErrorLogging(void);
+
+/* Used by `check()` and friends in dbg.h */
+void ogllErrorRecord(ogll_status_t s, const char* func, const char* file,
+                     int line, const char* msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,385 @@
+#ifndef __ogll_expr_hpp__
+#define __ogll_expr_hpp__
+
+/* Lazy Matrix expressions.
+ *
+ * Chains of sums, differences, scalings, transposes and products over
+ * `matrix_t` (or `ogll::Matrix`) operands build a small expression tree
+ * instead of calling `ogllMAddP`, `ogllMScale`, `ogllMTranspose` and
+ * `ogllMMultiplyP` one after the other. `assign` then walks the
+ * destination once and computes each entry straight from the operands,
+ * so something like
+ *
+ *     expr::assign(dst, ref(A) * ref(B) + 0.5f * t(ref(C)));
+ *
+ * makes no temporaries at all. Products are the exception, where
+ * summing entry by entry would be slower than the C API. A product used
+ * as an operand of another product is evaluated into scratch once first,
+ * so `A * B * C` doesn't redo `A * B` for every entry. A product big
+ * enough that `ogllMMultiplyP` would use the blocked GEMM goes through
+ * `ogllGemm` into scratch as well. Each product entry is summed from 0 in
+ * k order either way, so results match the C API exactly. Scaling here is plain
+ * multiplication: unlike `ogllMScale` it doesn't reset the homo bit.
+ *
+ * Shapes of `matrix_t` operands are only known at runtime, so they're
+ * checked once in `assign`, before anything is written. If the
+ * destination is also read through a product or transpose, or overlaps
+ * an operand without being exactly the same Matrix, the result is built
+ * in a scratch buffer first.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+#include "opengl-linalg.h"
+#include "opengl-linalg.hpp"
+#include "gemm.h"
+
+namespace ogll {
+namespace expr {
+
+// --- NODES --- //
+
+/* Base of every node. `E` provides cols(), rows(), valid(), at(col,row),
+   overlaps(p,n), which says whether any operand touches [p,p+n), and
+   prepare(), which fills the scratch of every product under it and
+   returns false if that fails. `E::nested`
+   says whether a product sits anywhere under it, making at() cost more
+   than a few loads. */
+template<typename E>
+struct Expr {
+        const E& self() const { return static_cast<const E&>(*this); }
+};
+
+/* An operand. Doesn't own its data. */
+struct Leaf : Expr<Leaf> {
+        const GLfloat* m;
+        std::size_t c, r;
+
+        static constexpr bool nested = false;
+
+        Leaf(const GLfloat* m, std::size_t c, std::size_t r) : m(m), c(c), r(r) {}
+
+        std::size_t cols() const { return c; }
+        std::size_t rows() const { return r; }
+        bool valid() const { return m != nullptr; }
+        GLfloat at(std::size_t col, std::size_t row) const { return m[col * r + row]; }
+
+        bool overlaps(const GLfloat* p, std::size_t n) const {
+                return m < p + n && p < m + c * r;
+        }
+
+        /* Reading entry (col,row) only ever touches the same entry of
+           the destination if it's exactly the same Matrix. */
+        bool hazard(const GLfloat* p, std::size_t n) const {
+                return overlaps(p, n) && !(m == p && c * r == n);
+        }
+        bool prepare() const { return true; }
+};
+
+template<typename A, typename B>
+struct Sum : Expr<Sum<A, B>> {
+        A a; B b; GLfloat sign;
+
+        static constexpr bool nested = A::nested || B::nested;
+
+        Sum(const A& a, const B& b, GLfloat sign) : a(a), b(b), sign(sign) {}
+
+        std::size_t cols() const { return a.cols(); }
+        std::size_t rows() const { return a.rows(); }
+        bool valid() const {
+                return a.valid() && b.valid() &&
+                        a.cols() == b.cols() && a.rows() == b.rows();
+        }
+        GLfloat at(std::size_t col, std::size_t row) const {
+                return sign > 0 ? a.at(col, row) + b.at(col, row)
+                                : a.at(col, row) - b.at(col, row);
+        }
+        bool overlaps(const GLfloat* p, std::size_t n) const {
+                return a.overlaps(p, n) || b.overlaps(p, n);
+        }
+        bool hazard(const GLfloat* p, std::size_t n) const {
+                return a.hazard(p, n) || b.hazard(p, n);
+        }
+        bool prepare() const { return a.prepare() && b.prepare(); }
+};
+
+template<typename A>
+struct Scale : Expr<Scale<A>> {
+        A a; GLfloat f;
+
+        static constexpr bool nested = A::nested;
+
+        Scale(const A& a, GLfloat f) : a(a), f(f) {}
+
+        std::size_t cols() const { return a.cols(); }
+        std::size_t rows() const { return a.rows(); }
+        bool valid() const { return a.valid(); }
+        GLfloat at(std::size_t col, std::size_t row) const { return f * a.at(col, row); }
+        bool overlaps(const GLfloat* p, std::size_t n) const { return a.overlaps(p, n); }
+        bool hazard(const GLfloat* p, std::size_t n) const { return a.hazard(p, n); }
+        bool prepare() const { return a.prepare(); }
+};
+
+template<typename A>
+struct Transpose : Expr<Transpose<A>> {
+        A a;
+
+        static constexpr bool nested = A::nested;
+
+        explicit Transpose(const A& a) : a(a) {}
+
+        std::size_t cols() const { return a.rows(); }
+        std::size_t rows() const { return a.cols(); }
+        bool valid() const { return a.valid(); }
+        GLfloat at(std::size_t col, std::size_t row) const { return a.at(row, col); }
+        bool overlaps(const GLfloat* p, std::size_t n) const { return a.overlaps(p, n); }
+        bool hazard(const GLfloat* p, std::size_t n) const { return a.overlaps(p, n); }
+        bool prepare() const { return a.prepare(); }
+};
+
+template<typename A, typename B>
+struct Product;
+
+namespace detail {
+template<typename E>
+void fill(GLfloat* out, const E& e);
+}
+
+template<typename X>
+struct isProduct : std::false_type {};
+
+template<typename A, typename B>
+struct isProduct<Product<A, B>> : std::true_type {};
+
+/* An operand with a product under it would be re-evaluated for every
+   entry read, making nested products O(n^4). Those are evaluated into
+   scratch by prepare() and read from there instead. Past OGLL_GEMM_MIN
+   the whole product is computed there by `ogllGemm`, into `sc`. */
+template<typename A, typename B>
+struct Product : Expr<Product<A, B>> {
+        A a; B b;
+        mutable std::vector<GLfloat> sa, sb, sc;
+        mutable const GLfloat* pa = nullptr;
+        mutable const GLfloat* pb = nullptr;
+
+        static constexpr bool nested = true;
+
+        Product(const A& a, const B& b) : a(a), b(b) {}
+
+        std::size_t cols() const { return b.cols(); }
+        std::size_t rows() const { return a.rows(); }
+        bool valid() const {
+                return a.valid() && b.valid() && a.cols() == b.rows();
+        }
+        GLfloat at(std::size_t col, std::size_t row) const {
+                if(!sc.empty()) {
+                        return sc[col * rows() + row];
+                }
+
+                GLfloat sum = 0;
+
+                for(std::size_t k = 0; k < a.cols(); k++) {
+                        sum += left(k, row) * right(col, k);
+                }
+
+                return sum;
+        }
+        bool overlaps(const GLfloat* p, std::size_t n) const {
+                return a.overlaps(p, n) || b.overlaps(p, n);
+        }
+        bool hazard(const GLfloat* p, std::size_t n) const {
+                return a.overlaps(p, n) || b.overlaps(p, n);
+        }
+        bool prepare() const {
+                const std::size_t work = rows() * cols() * a.cols();
+                const bool blocked = work >= OGLL_GEMM_MIN;
+
+                if(!a.prepare() || !b.prepare()) {
+                        return false;
+                }
+
+                pa = operand(a, sa, A::nested || blocked);
+                pb = operand(b, sb, B::nested || blocked);
+
+                if(!blocked) {
+                        return true;
+                }
+
+                sc.resize(rows() * cols());
+                return ogllGemm(rows(), cols(), a.cols(), pa, a.rows(), pb, b.rows(),
+                                sc.data(), rows(),
+                                work >= OGLL_GEMM_THREADED_MIN ? ogllGemmPool() : nullptr);
+        }
+
+private:
+        /* `x` as a packed array, through `s` unless it already is one */
+        template<typename X>
+        static const GLfloat* operand(const X& x, std::vector<GLfloat>& s, bool copy) {
+                if constexpr(std::is_same_v<X, Leaf>) {
+                        return x.m;
+                } else {
+                        if constexpr(isProduct<X>::value) {
+                                if(!x.sc.empty()) {
+                                        return x.sc.data();
+                                }
+                        }
+                        if(copy) {
+                                s.resize(x.cols() * x.rows());
+                                detail::fill(s.data(), x);
+                        }
+                        return s.data();
+                }
+        }
+
+        GLfloat left(std::size_t col, std::size_t row) const {
+                if constexpr(A::nested) {
+                        return pa[col * a.rows() + row];
+                } else {
+                        return a.at(col, row);
+                }
+        }
+        GLfloat right(std::size_t col, std::size_t row) const {
+                if constexpr(B::nested) {
+                        return pb[col * b.rows() + row];
+                } else {
+                        return b.at(col, row);
+                }
+        }
+};
+
+// --- CONSTRUCTION --- //
+
+/* Wrap an operand. A NULL `matrix_t` makes `assign` fail. */
+inline Leaf ref(const matrix_t* m) {
+        return m ? Leaf(m->m, m->cols, m->rows) : Leaf(nullptr, 0, 0);
+}
+
+template<std::size_t C, std::size_t R>
+Leaf ref(const Matrix<C, R>& m) {
+        return Leaf(m.m, C, R);
+}
+
+template<typename A, typename B>
+Sum<A, B> operator+(const Expr<A>& a, const Expr<B>& b) {
+        return Sum<A, B>(a.self(), b.self(), 1);
+}
+
+template<typename A, typename B>
+Sum<A, B> operator-(const Expr<A>& a, const Expr<B>& b) {
+        return Sum<A, B>(a.self(), b.self(), -1);
+}
+
+template<typename A>
+Scale<A> operator*(GLfloat f, const Expr<A>& a) {
+        return Scale<A>(a.self(), f);
+}
+
+template<typename A>
+Scale<A> operator*(const Expr<A>& a, GLfloat f) {
+        return Scale<A>(a.self(), f);
+}
+
+template<typename A, typename B>
+Product<A, B> operator*(const Expr<A>& a, const Expr<B>& b) {
+        return Product<A, B>(a.self(), b.self());
+}
+
+template<typename A>
+Transpose<A> t(const Expr<A>& a) {
+        return Transpose<A>(a.self());
+}
+
+// --- EVALUATION --- //
+
+namespace detail {
+
+template<typename E>
+void fill(GLfloat* out, const E& e) {
+        const std::size_t cols = e.cols();
+        const std::size_t rows = e.rows();
+
+        for(std::size_t c = 0; c < cols; c++) {
+                for(std::size_t r = 0; r < rows; r++) {
+                        out[c * rows + r] = e.at(c, r);
+                }
+        }
+}
+
+template<typename E>
+bool assign(GLfloat* out, std::size_t cols, std::size_t rows, const E& e) {
+        if(!e.valid() || e.cols() != cols || e.rows() != rows) {
+                ogll::detail::invalid("Expression shapes don't match.");
+                return false;
+        }
+
+        if(!e.prepare()) {
+                ogll::detail::invalid("Expression product failed.");
+                return false;
+        }
+
+        if(e.hazard(out, cols * rows)) {
+                std::vector<GLfloat> scratch(cols * rows);
+                fill(scratch.data(), e);
+                for(std::size_t i = 0; i < cols * rows; i++) {
+                        out[i] = scratch[i];
+                }
+        } else {
+                fill(out, e);
+        }
+
+        return true;
+}
+
+} // namespace detail
+
+/* Evaluate `e` into an existing Matrix of the same shape, in one pass.
+   Returns false, leaving `dst` untouched, if any shape is wrong or a
+   blocked product fails. */
+template<typename E>
+bool assign(matrix_t* dst, const Expr<E>& e) {
+        if(!dst) {
+                ogll::detail::invalid("Null destination given.");
+                return false;
+        }
+
+        return detail::assign(dst->m, dst->cols, dst->rows, e.self());
+}
+
+template<std::size_t C, std::size_t R, typename E>
+bool assign(Matrix<C, R>& dst, const Expr<E>& e) {
+        return detail::assign(dst.m, C, R, e.self());
+}
+
+/* Evaluate `e` into a new Matrix from `ogllMCreate`. Returns NULL if any
+   shape is wrong or a blocked product fails. */
+template<typename E>
+matrix_t* evaluate(const Expr<E>& e) {
+        matrix_t* m = nullptr;
+
+        if(!e.self().valid()) {
+                ogll::detail::invalid("Expression shapes don't match.");
+                return nullptr;
+        }
+
+        m = ogllMCreate(e.self().cols(), e.self().rows());
+
+        if(m && !e.self().prepare()) {
+                ogll::detail::invalid("Expression product failed.");
+                ogllMDestroy(m);
+                return nullptr;
+        }
+
+        if(m) {
+                detail::fill(m->m, e.self());
+        }
+
+        return m;
+}
+
+} // namespace expr
+} // namespace ogll
+
+#endif
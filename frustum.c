@@ -0,0 +1,255 @@
+#include <math.h>
+
+#include "frustum.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OGLL_X86
+#include <immintrin.h>
+#endif
+
+// --- //
+
+/* Gribb & Hartmann: each plane is the last row of the Matrix plus or
+   minus one of the others. Rows of a column-major Matrix are m[r + 4k]. */
+static void extract(frustum_t* f, const GLfloat* m) {
+        GLfloat len;
+        size_t i, axis;
+        GLfloat sign;
+
+        for(i = 0; i < 6; i++) {
+                axis = i / 2;
+                sign = i % 2 == 0 ? 1 : -1;
+
+                f->a[i] = m[3]  + sign * m[axis];
+                f->b[i] = m[7]  + sign * m[4 + axis];
+                f->c[i] = m[11] + sign * m[8 + axis];
+                f->d[i] = m[15] + sign * m[12 + axis];
+
+                len = sqrt(f->a[i] * f->a[i] + f->b[i] * f->b[i] + f->c[i] * f->c[i]);
+
+                if(len > 0) {
+                        f->a[i] /= len;
+                        f->b[i] /= len;
+                        f->c[i] /= len;
+                        f->d[i] /= len;
+                }
+        }
+}
+
+/* Extract the planes of a 4x4 view-projection Matrix */
+frustum_t* ogllFrustumFromMatrix(frustum_t* f, matrix_t* vp) {
+        OGLL_PROBE();
+        check(f && vp, "Null argument given.");
+        check(vp->cols == 4 && vp->rows == 4, "Matrix not 4x4.");
+
+        extract(f, vp->m);
+
+        return f;
+ error:
+        return NULL;
+}
+
+/* As above, from a value */
+frustum_t* ogllFrustumFromMat4(frustum_t* f, const mat4_t* vp) {
+        OGLL_PROBE();
+        check(f && vp, "Null argument given.");
+
+        extract(f, vp->m);
+
+        return f;
+ error:
+        return NULL;
+}
+
+// --- TESTS --- //
+
+/* Both the plain and SSE tests form each sum in the same order, so they
+   always agree. */
+
+static bool sphereAt(const frustum_t* f, GLfloat x, GLfloat y, GLfloat z,
+                     GLfloat r) {
+        size_t i;
+
+        for(i = 0; i < 6; i++) {
+                if(f->a[i] * x + f->b[i] * y + f->c[i] * z + f->d[i] < -r) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+/* Only the corner furthest along each plane's normal needs testing */
+static bool boxAt(const frustum_t* f, const soa_t* lo, const soa_t* hi,
+                  size_t k) {
+        size_t i;
+
+        for(i = 0; i < 6; i++) {
+                GLfloat dist = fmaxf(f->a[i] * lo->x[k], f->a[i] * hi->x[k]) +
+                               fmaxf(f->b[i] * lo->y[k], f->b[i] * hi->y[k]) +
+                               fmaxf(f->c[i] * lo->z[k], f->c[i] * hi->z[k]) +
+                               f->d[i];
+
+                if(dist < 0) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+#ifdef OGLL_X86
+
+/* Four spheres per iteration. Yields how many were tested. */
+__attribute__((target("sse")))
+static size_t sseSpheres(const frustum_t* f, const soa_t* cs, const GLfloat* rs,
+                         uint32_t* mask) {
+        size_t k, i;
+
+        for(k = 0; k + 4 <= cs->count; k += 4) {
+                __m128 x = _mm_loadu_ps(cs->x + k);
+                __m128 y = _mm_loadu_ps(cs->y + k);
+                __m128 z = _mm_loadu_ps(cs->z + k);
+                __m128 nr = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(rs + k));
+                __m128 in = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+
+                for(i = 0; i < 6; i++) {
+                        __m128 d;
+
+                        d = _mm_mul_ps(_mm_set1_ps(f->a[i]), x);
+                        d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(f->b[i]), y));
+                        d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(f->c[i]), z));
+                        d = _mm_add_ps(d, _mm_set1_ps(f->d[i]));
+                        in = _mm_and_ps(in, _mm_cmpnlt_ps(d, nr));
+                }
+
+                mask[k / 32] |= (uint32_t)_mm_movemask_ps(in) << (k % 32);
+        }
+
+        return k;
+}
+
+__attribute__((target("sse")))
+static size_t sseBoxes(const frustum_t* f, const soa_t* lo, const soa_t* hi,
+                       uint32_t* mask) {
+        size_t k, i;
+
+        for(k = 0; k + 4 <= lo->count; k += 4) {
+                __m128 x0 = _mm_loadu_ps(lo->x + k), x1 = _mm_loadu_ps(hi->x + k);
+                __m128 y0 = _mm_loadu_ps(lo->y + k), y1 = _mm_loadu_ps(hi->y + k);
+                __m128 z0 = _mm_loadu_ps(lo->z + k), z1 = _mm_loadu_ps(hi->z + k);
+                __m128 in = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+
+                for(i = 0; i < 6; i++) {
+                        __m128 a = _mm_set1_ps(f->a[i]);
+                        __m128 b = _mm_set1_ps(f->b[i]);
+                        __m128 c = _mm_set1_ps(f->c[i]);
+                        __m128 d;
+
+                        d = _mm_max_ps(_mm_mul_ps(a, x0), _mm_mul_ps(a, x1));
+                        d = _mm_add_ps(d, _mm_max_ps(_mm_mul_ps(b, y0), _mm_mul_ps(b, y1)));
+                        d = _mm_add_ps(d, _mm_max_ps(_mm_mul_ps(c, z0), _mm_mul_ps(c, z1)));
+                        d = _mm_add_ps(d, _mm_set1_ps(f->d[i]));
+                        in = _mm_and_ps(in, _mm_cmpnlt_ps(d, _mm_setzero_ps()));
+                }
+
+                mask[k / 32] |= (uint32_t)_mm_movemask_ps(in) << (k % 32);
+        }
+
+        return k;
+}
+
+#endif
+
+static bool useSse(void) {
+#ifdef OGLL_X86
+        return ogllSimdBackend() != OGLL_SIMD_SCALAR;
+#else
+        return false;
+#endif
+}
+
+static size_t popcount(const uint32_t* mask, size_t count) {
+        size_t n = 0;
+        size_t w;
+
+        for(w = 0; w < OGLL_CULL_WORDS(count); w++) {
+                n += __builtin_popcount(mask[w]);
+        }
+
+        return n;
+}
+
+/* Is a single sphere at least partly inside? */
+bool ogllFrustumSphere(const frustum_t* f, vec3_t centre, GLfloat radius) {
+        OGLL_PROBE();
+        check(f, "Null Frustum given.");
+
+        return sphereAt(f, centre.x, centre.y, centre.z, radius);
+ error:
+        return false;
+}
+
+/* Test `centres->count` spheres */
+size_t ogllFrustumCullSpheres(const frustum_t* f, const soa_t* centres,
+                              const GLfloat* radii, uint32_t* mask) {
+        OGLL_PROBE();
+        size_t k = 0;
+        size_t w;
+
+        check(f && centres && radii && mask, "Null argument given.");
+
+        for(w = 0; w < OGLL_CULL_WORDS(centres->count); w++) {
+                mask[w] = 0;
+        }
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                k = sseSpheres(f, centres, radii, mask);
+        }
+#endif
+
+        for(; k < centres->count; k++) {
+                if(sphereAt(f, centres->x[k], centres->y[k], centres->z[k], radii[k])) {
+                        mask[k / 32] |= (uint32_t)1 << (k % 32);
+                }
+        }
+
+        return popcount(mask, centres->count);
+ error:
+        return 0;
+}
+
+/* Test `mins->count` axis-aligned boxes */
+size_t ogllFrustumCullBoxes(const frustum_t* f, const soa_t* mins,
+                            const soa_t* maxs, uint32_t* mask) {
+        OGLL_PROBE();
+        size_t k = 0;
+        size_t w;
+
+        check(f && mins && maxs && mask, "Null argument given.");
+        check(mins->count == maxs->count, "Corner streams aren't the same length.");
+
+        for(w = 0; w < OGLL_CULL_WORDS(mins->count); w++) {
+                mask[w] = 0;
+        }
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                k = sseBoxes(f, mins, maxs, mask);
+        }
+#endif
+
+        for(; k < mins->count; k++) {
+                if(boxAt(f, mins, maxs, k)) {
+                        mask[k / 32] |= (uint32_t)1 << (k % 32);
+                }
+        }
+
+        return popcount(mask, mins->count);
+ error:
+        return 0;
+}
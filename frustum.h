@@ -0,0 +1,67 @@
+#ifndef __ogll_frustum__
+#define __ogll_frustum__
+
+#include <stdint.h>
+
+#include "opengl-linalg.h"
+#include "value.h"
+#include "soa.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* View frustum culling.
+ *
+ * Extract the six clip planes from a view-projection Matrix (e.g. the
+ * product of `ogllMPerspectiveP` and `ogllM4LookAtP`), then test whole
+ * arrays of bounding volumes against them and get back one visibility
+ * bit per volume. Volumes come in SoA streams so four are tested per
+ * SSE instruction.
+ *
+ * The tests are conservative: nothing visible is ever culled, but a
+ * volume just outside a frustum corner may be kept.
+ */
+
+// --- //
+
+/* 32-bit words of mask needed for `n` volumes */
+#define OGLL_CULL_WORDS(n) (((n) + 31) / 32)
+
+/* Planes in the order left, right, bottom, top, near, far, stored as one
+   lane per coefficient. A point p is inside plane i when
+   a[i]*p.x + b[i]*p.y + c[i]*p.z + d[i] >= 0. (a,b,c) is unit length, so
+   that's also the distance to the plane. */
+typedef struct frustum_t {
+        GLfloat a[6];
+        GLfloat b[6];
+        GLfloat c[6];
+        GLfloat d[6];
+} frustum_t;
+
+/* Extract the planes of a 4x4 view-projection Matrix with OpenGL's -1..1
+   clip depth. Yields `f`, or NULL if `vp` isn't 4x4. */
+frustum_t* ogllFrustumFromMatrix(frustum_t* f, matrix_t* vp);
+
+/* As above, from a value */
+frustum_t* ogllFrustumFromMat4(frustum_t* f, const mat4_t* vp);
+
+/* Is a single sphere at least partly inside? */
+bool ogllFrustumSphere(const frustum_t* f, vec3_t centre, GLfloat radius);
+
+/* Test `centres->count` spheres. Bit i of `mask` (bit i % 32 of word
+   i / 32) is set if sphere i is visible. `mask` must hold
+   OGLL_CULL_WORDS(count) words. Yields the number visible. */
+size_t ogllFrustumCullSpheres(const frustum_t* f, const soa_t* centres,
+                              const GLfloat* radii, uint32_t* mask);
+
+/* Test `mins->count` axis-aligned boxes, given as min and max corners.
+   The mask is written as for spheres. Yields the number visible. */
+size_t ogllFrustumCullBoxes(const frustum_t* f, const soa_t* mins,
+                            const soa_t* maxs, uint32_t* mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
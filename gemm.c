@@ -0,0 +1,383 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gemm.h"
+#include "alloc.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OGLL_X86
+#include <immintrin.h>
+#endif
+
+// --- //
+
+/* Micro-tile of C held in registers */
+#define MR 8
+#define NR 4
+
+/* Cache blocks: an MC x KC panel of A stays in L2, a KC x NC panel of B
+   in L3. */
+#define MC 128
+#define KC 256
+#define NC 1024
+
+typedef void (*kernel_f)(size_t kc, const GLfloat* a, const GLfloat* b,
+                         GLfloat* c, size_t ldc);
+
+typedef struct gemm_t {
+        size_t m;
+        const GLfloat* A;
+        size_t lda;
+        GLfloat* C;
+        size_t ldc;
+        kernel_f kernel;
+
+        // The block of B currently packed.
+        size_t jc, nc, pc, kc;
+        const GLfloat* bpack;
+
+        // One panel of A per worker, `apanel` floats apart.
+        GLfloat* apacks;
+        size_t apanel;
+        size_t workers;
+} gemm_t;
+
+static pool_t* gemmPool = NULL;
+
+// --- MICRO-KERNELS --- //
+
+/* c[MR x NR] += a[MR x kc] * b[kc x NR], with `a` and `b` packed */
+static void scalarKernel(size_t kc, const GLfloat* a, const GLfloat* b,
+                         GLfloat* c, size_t ldc) {
+        size_t p,i,j;
+
+        for(p = 0; p < kc; p++) {
+                for(j = 0; j < NR; j++) {
+                        for(i = 0; i < MR; i++) {
+                                c[j * ldc + i] += a[i] * b[j];
+                        }
+                }
+
+                a += MR;
+                b += NR;
+        }
+}
+
+#ifdef OGLL_X86
+
+__attribute__((target("sse")))
+static void sseKernel(size_t kc, const GLfloat* a, const GLfloat* b,
+                      GLfloat* c, size_t ldc) {
+        __m128 c00 = _mm_loadu_ps(c),           c01 = _mm_loadu_ps(c + 4);
+        __m128 c10 = _mm_loadu_ps(c + ldc),     c11 = _mm_loadu_ps(c + ldc + 4);
+        __m128 c20 = _mm_loadu_ps(c + 2 * ldc), c21 = _mm_loadu_ps(c + 2 * ldc + 4);
+        __m128 c30 = _mm_loadu_ps(c + 3 * ldc), c31 = _mm_loadu_ps(c + 3 * ldc + 4);
+        size_t p;
+
+        for(p = 0; p < kc; p++) {
+                __m128 a0 = _mm_load_ps(a);
+                __m128 a1 = _mm_load_ps(a + 4);
+                __m128 bj;
+
+                bj = _mm_set1_ps(b[0]);
+                c00 = _mm_add_ps(c00, _mm_mul_ps(a0, bj));
+                c01 = _mm_add_ps(c01, _mm_mul_ps(a1, bj));
+                bj = _mm_set1_ps(b[1]);
+                c10 = _mm_add_ps(c10, _mm_mul_ps(a0, bj));
+                c11 = _mm_add_ps(c11, _mm_mul_ps(a1, bj));
+                bj = _mm_set1_ps(b[2]);
+                c20 = _mm_add_ps(c20, _mm_mul_ps(a0, bj));
+                c21 = _mm_add_ps(c21, _mm_mul_ps(a1, bj));
+                bj = _mm_set1_ps(b[3]);
+                c30 = _mm_add_ps(c30, _mm_mul_ps(a0, bj));
+                c31 = _mm_add_ps(c31, _mm_mul_ps(a1, bj));
+
+                a += MR;
+                b += NR;
+        }
+
+        _mm_storeu_ps(c, c00);           _mm_storeu_ps(c + 4, c01);
+        _mm_storeu_ps(c + ldc, c10);     _mm_storeu_ps(c + ldc + 4, c11);
+        _mm_storeu_ps(c + 2 * ldc, c20); _mm_storeu_ps(c + 2 * ldc + 4, c21);
+        _mm_storeu_ps(c + 3 * ldc, c30); _mm_storeu_ps(c + 3 * ldc + 4, c31);
+}
+
+__attribute__((target("avx")))
+static void avxKernel(size_t kc, const GLfloat* a, const GLfloat* b,
+                      GLfloat* c, size_t ldc) {
+        __m256 c0 = _mm256_loadu_ps(c);
+        __m256 c1 = _mm256_loadu_ps(c + ldc);
+        __m256 c2 = _mm256_loadu_ps(c + 2 * ldc);
+        __m256 c3 = _mm256_loadu_ps(c + 3 * ldc);
+        size_t p;
+
+        for(p = 0; p < kc; p++) {
+                __m256 av = _mm256_load_ps(a);
+
+                c0 = _mm256_add_ps(c0, _mm256_mul_ps(av, _mm256_broadcast_ss(b)));
+                c1 = _mm256_add_ps(c1, _mm256_mul_ps(av, _mm256_broadcast_ss(b + 1)));
+                c2 = _mm256_add_ps(c2, _mm256_mul_ps(av, _mm256_broadcast_ss(b + 2)));
+                c3 = _mm256_add_ps(c3, _mm256_mul_ps(av, _mm256_broadcast_ss(b + 3)));
+
+                a += MR;
+                b += NR;
+        }
+
+        _mm256_storeu_ps(c, c0);
+        _mm256_storeu_ps(c + ldc, c1);
+        _mm256_storeu_ps(c + 2 * ldc, c2);
+        _mm256_storeu_ps(c + 3 * ldc, c3);
+}
+
+#endif
+
+static kernel_f pickKernel(void) {
+        switch(ogllSimdBackend()) {
+#ifdef OGLL_X86
+        case OGLL_SIMD_AVX: return avxKernel;
+        case OGLL_SIMD_SSE: return sseKernel;
+#endif
+        default:            return scalarKernel;
+        }
+}
+
+// --- PACKING --- //
+
+/* Copy an mc x kc block of A into MR-row panels, k-major within each
+   panel. Short panels are padded with 0s. */
+static void packA(GLfloat* dst, const GLfloat* A, size_t lda,
+                  size_t mc, size_t kc) {
+        size_t ip, p, i, mr;
+
+        for(ip = 0; ip < mc; ip += MR) {
+                mr = mc - ip < MR ? mc - ip : MR;
+
+                for(p = 0; p < kc; p++) {
+                        for(i = 0; i < mr; i++) {
+                                *dst++ = A[p * lda + ip + i];
+                        }
+                        for(; i < MR; i++) {
+                                *dst++ = 0;
+                        }
+                }
+        }
+}
+
+/* Copy a kc x nc block of B into NR-column panels, k-major within each
+   panel. Short panels are padded with 0s. */
+static void packB(GLfloat* dst, const GLfloat* B, size_t ldb,
+                  size_t kc, size_t nc) {
+        size_t jp, p, j, nr;
+
+        for(jp = 0; jp < nc; jp += NR) {
+                nr = nc - jp < NR ? nc - jp : NR;
+
+                for(p = 0; p < kc; p++) {
+                        for(j = 0; j < nr; j++) {
+                                *dst++ = B[(jp + j) * ldb + p];
+                        }
+                        for(; j < NR; j++) {
+                                *dst++ = 0;
+                        }
+                }
+        }
+}
+
+// --- MACRO-KERNEL --- //
+
+/* Multiply one packed MC block of A against the packed block of B */
+static void macroKernel(gemm_t* g, const GLfloat* apack, size_t ic, size_t mc) {
+        GLfloat tile[MR * NR];
+        GLfloat* c;
+        size_t jr, ir, mr, nr, i, j;
+
+        for(jr = 0; jr < g->nc; jr += NR) {
+                nr = g->nc - jr < NR ? g->nc - jr : NR;
+
+                for(ir = 0; ir < mc; ir += MR) {
+                        mr = mc - ir < MR ? mc - ir : MR;
+                        c = g->C + (g->jc + jr) * g->ldc + ic + ir;
+
+                        if(mr == MR && nr == NR) {
+                                g->kernel(g->kc, apack + ir * g->kc,
+                                          g->bpack + jr * g->kc, c, g->ldc);
+                                continue;
+                        }
+
+                        // Edge tile: go through a full-size copy.
+                        memset(tile, 0, sizeof(tile));
+                        for(j = 0; j < nr; j++) {
+                                for(i = 0; i < mr; i++) {
+                                        tile[j * MR + i] = c[j * g->ldc + i];
+                                }
+                        }
+
+                        g->kernel(g->kc, apack + ir * g->kc,
+                                  g->bpack + jr * g->kc, tile, MR);
+
+                        for(j = 0; j < nr; j++) {
+                                for(i = 0; i < mr; i++) {
+                                        c[j * g->ldc + i] = tile[j * MR + i];
+                                }
+                        }
+                }
+        }
+}
+
+/* Pool task over workers. Worker w takes every `workers`th MC row block
+   starting at w, packing each into its own panel of A. */
+static void rowBlocks(void* arg, size_t begin, size_t end) {
+        gemm_t* g = (gemm_t*)arg;
+        GLfloat* apack;
+        size_t w, b, ic, mc;
+
+        for(w = begin; w < end; w++) {
+                apack = g->apacks + w * g->apanel;
+
+                for(b = w; b * MC < g->m; b += g->workers) {
+                        ic = b * MC;
+                        mc = g->m - ic < MC ? g->m - ic : MC;
+
+                        packA(apack, g->A + g->pc * g->lda + ic, g->lda, mc, g->kc);
+                        macroKernel(g, apack, ic, mc);
+                }
+        }
+}
+
+static size_t roundUp(size_t x, size_t to) {
+        return (x + to - 1) / to * to;
+}
+
+static size_t min(size_t a, size_t b) {
+        return a < b ? a : b;
+}
+
+/* Workers that get at least one MC row block */
+static size_t workersFor(size_t m, pool_t* pool) {
+        return min(ogllPoolSize(pool), (m + MC - 1) / MC);
+}
+
+/* Floats for the packed block of B, rounded so the panels of A after it
+   stay 32-byte aligned */
+static size_t bpackSize(size_t n, size_t k) {
+        return roundUp(min(k, KC) * roundUp(min(n, NC), NR), 8);
+}
+
+static size_t apanelSize(size_t m, size_t k) {
+        return roundUp(min(m, MC), MR) * min(k, KC);
+}
+
+/* Floats of workspace `ogllGemmWith` needs */
+size_t ogllGemmWorkspace(size_t m, size_t n, size_t k, pool_t* pool) {
+        OGLL_PROBE();
+        if(m == 0 || n == 0 || k == 0) {
+                return 0;
+        }
+
+        // 7 spare floats to align the start to 32 bytes
+        return bpackSize(n, k) + workersFor(m, pool) * apanelSize(m, k) + 7;
+}
+
+/* C = A * B, packing into `work` */
+void ogllGemmWith(size_t m, size_t n, size_t k,
+                  const GLfloat* A, size_t lda,
+                  const GLfloat* B, size_t ldb,
+                  GLfloat* C, size_t ldc,
+                  pool_t* pool, GLfloat* work) {
+        OGLL_PROBE();
+        gemm_t g;
+        GLfloat* bpack;
+        size_t j;
+
+        check(A && B && C, "Null operands given.");
+        check(lda >= m && ldb >= k && ldc >= m, "Bad leading dimensions.");
+
+        // Sums start from 0, as in the naive loop.
+        for(j = 0; j < n; j++) {
+                memset(C + j * ldc, 0, m * sizeof(GLfloat));
+        }
+
+        if(m == 0 || n == 0 || k == 0) {
+                return;
+        }
+
+        check(work, "Null workspace given.");
+
+        bpack = (GLfloat*)(((uintptr_t)work + 31) & ~(uintptr_t)31);
+
+        g.m = m;
+        g.A = A;
+        g.lda = lda;
+        g.C = C;
+        g.ldc = ldc;
+        g.kernel = pickKernel();
+        g.bpack = bpack;
+        g.apacks = bpack + bpackSize(n, k);
+        g.apanel = apanelSize(m, k);
+        g.workers = workersFor(m, pool);
+
+        for(g.jc = 0; g.jc < n; g.jc += NC) {
+                g.nc = n - g.jc < NC ? n - g.jc : NC;
+
+                // Blocks of k run in order, so each sum stays in k order.
+                for(g.pc = 0; g.pc < k; g.pc += KC) {
+                        g.kc = k - g.pc < KC ? k - g.pc : KC;
+
+                        packB(bpack, B + g.jc * ldb + g.pc, ldb, g.kc, g.nc);
+                        ogllPoolFor(pool, g.workers, 1, rowBlocks, &g);
+                }
+        }
+
+ error:
+        return;
+}
+
+/* C = A * B */
+bool ogllGemm(size_t m, size_t n, size_t k,
+              const GLfloat* A, size_t lda,
+              const GLfloat* B, size_t ldb,
+              GLfloat* C, size_t ldc,
+              pool_t* pool) {
+        OGLL_PROBE();
+        const allocator_t* a = ogllGetAllocator();
+        GLfloat* work = NULL;
+        size_t bytes;
+
+        check(A && B && C, "Null operands given.");
+        check(lda >= m && ldb >= k && ldc >= m, "Bad leading dimensions.");
+
+        // Allocated before C is touched, so a failure leaves C as it was.
+        bytes = ogllGemmWorkspace(m, n, k, pool) * sizeof(GLfloat);
+        if(bytes > 0) {
+                work = a ? a->alloc(a->ctx, bytes, 32) : malloc(bytes);
+                check_mem(work);
+        }
+
+        ogllGemmWith(m, n, k, A, lda, B, ldb, C, ldc, pool, work);
+
+        if(a && work) {
+                a->free(a->ctx, work);
+        } else {
+                free(work);
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* Worker pool used by `ogllMMultiplyP` for large products */
+void ogllGemmSetPool(pool_t* pool) {
+        OGLL_PROBE();
+        __atomic_store_n(&gemmPool, pool, __ATOMIC_RELEASE);
+}
+
+/* The pool set by `ogllGemmSetPool` */
+pool_t* ogllGemmPool(void) {
+        OGLL_PROBE();
+        return __atomic_load_n(&gemmPool, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,67 @@
+#ifndef __ogll_gemm__
+#define __ogll_gemm__
+
+#include <GL/glew.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cache-blocked general Matrix multiply for large operands.
+ *
+ * Operands are column-major with leading dimensions, the same layout as
+ * `matrix_t->m` (where the leading dimension is `rows`). Blocks of B and A
+ * are packed into contiguous panels sized for the caches and fed to an
+ * 8x4 SIMD micro-kernel. Each entry of C is still summed in k order
+ * starting from 0 with no fused multiply-adds, so the result is
+ * bit-identical to the naive loop in `ogllMMultiplyP`.
+ *
+ * `ogllMMultiplyP` switches to this path by itself once
+ * rows * cols * inner >= OGLL_GEMM_MIN, and spreads row blocks over the
+ * pool given to `ogllGemmSetPool` once it passes OGLL_GEMM_THREADED_MIN.
+ */
+
+// --- //
+
+#define OGLL_GEMM_MIN          (48 * 48 * 48)
+#define OGLL_GEMM_THREADED_MIN (192 * 192 * 192)
+
+/* C = A * B, where A is m x k, B is k x n and C is m x n. C must not
+   overlap A or B. `pool` may be NULL. The packing buffers, sized to the
+   operands, come from the installed allocator (see alloc.h). Returns
+   false, leaving C untouched, if they can't be allocated. */
+bool ogllGemm(size_t m, size_t n, size_t k,
+              const GLfloat* A, size_t lda,
+              const GLfloat* B, size_t ldb,
+              GLfloat* C, size_t ldc,
+              pool_t* pool);
+
+/* Floats of workspace `ogllGemmWith` needs for these sizes and pool. It
+   also covers any smaller m, n or k and any pool with fewer workers. */
+size_t ogllGemmWorkspace(size_t m, size_t n, size_t k, pool_t* pool);
+
+/* `ogllGemm` packing into `work`, which has at least
+   `ogllGemmWorkspace(m, n, k, pool)` floats, instead of allocating. For
+   callers that multiply repeatedly. */
+void ogllGemmWith(size_t m, size_t n, size_t k,
+                  const GLfloat* A, size_t lda,
+                  const GLfloat* B, size_t ldb,
+                  GLfloat* C, size_t ldc,
+                  pool_t* pool, GLfloat* work);
+
+/* Worker pool used by `ogllMMultiplyP` for large products. NULL (the
+   default) keeps everything on the calling thread. */
+void ogllGemmSetPool(pool_t* pool);
+
+/* The pool set by `ogllGemmSetPool` */
+pool_t* ogllGemmPool(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
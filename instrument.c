@@ -0,0 +1,318 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+#ifdef OGLL_INSTRUMENT
+
+typedef struct event_t {
+        const ogll_site_t* site;
+        uint64_t start;
+        uint64_t dur;
+        uint32_t tid;
+} event_t;
+
+/* Every site that has been called, newest first. Never shrinks. */
+static ogll_site_t* sites = NULL;
+
+/* Charged for failures and allocations outside any probe */
+static ogll_site_t outside = { "(outside ogll)" };
+
+static int64_t liveObjects = 0;
+static int64_t liveBytes = 0;
+
+static event_t* events = NULL;
+static size_t capacity = 0;
+static size_t recorded = 0;
+static uint64_t epoch = 0;
+
+static uint32_t threads = 0;
+
+static __thread ogll_site_t* current = NULL;
+static __thread ogll_site_t* outer = NULL;
+static __thread uint32_t tid = 0;
+
+static uint64_t now(void) {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void add(uint64_t* counter, uint64_t n) {
+        __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+static void enlist(ogll_site_t* s) {
+        int unlisted = 0;
+        ogll_site_t* head;
+
+        if(__atomic_compare_exchange_n(&s->listed, &unlisted, 1, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                head = __atomic_load_n(&sites, __ATOMIC_ACQUIRE);
+
+                do {
+                        s->next = head;
+                } while(!__atomic_compare_exchange_n(&sites, &head, s, true,
+                                                     __ATOMIC_RELEASE,
+                                                     __ATOMIC_ACQUIRE));
+        }
+}
+
+ogll_probe_t ogllProbeBegin(ogll_site_t* site) {
+        ogll_probe_t p = { site, current, 0 };
+
+        if(!__atomic_load_n(&site->listed, __ATOMIC_ACQUIRE)) {
+                enlist(site);
+        }
+
+        if(!current) {
+                outer = site;
+        }
+        current = site;
+        p.start = now();
+
+        return p;
+}
+
+void ogllProbeEnd(ogll_probe_t* p) {
+        uint64_t dur = now() - p->start;
+        size_t slot;
+
+        add(&p->site->calls, 1);
+        add(&p->site->nanos, dur);
+        current = p->prev;
+
+        if(__atomic_load_n(&events, __ATOMIC_RELAXED)) {
+                slot = __atomic_fetch_add(&recorded, 1, __ATOMIC_RELAXED);
+
+                if(slot < capacity) {
+                        if(!tid) {
+                                tid = __atomic_add_fetch(&threads, 1, __ATOMIC_RELAXED);
+                        }
+
+                        events[slot].site = p->site;
+                        events[slot].start = p->start;
+                        events[slot].dur = dur;
+                        events[slot].tid = tid;
+                }
+        }
+}
+
+void ogllProbeAlloc(size_t bytes) {
+        ogll_site_t* s = current ? outer : &outside;
+
+        add(&s->allocs, 1);
+        add(&s->bytes, bytes);
+        __atomic_fetch_add(&liveObjects, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&liveBytes, (int64_t)bytes, __ATOMIC_RELAXED);
+}
+
+void ogllProbeFree(size_t bytes) {
+        ogll_site_t* s = current ? outer : &outside;
+
+        add(&s->frees, 1);
+        __atomic_fetch_sub(&liveObjects, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&liveBytes, (int64_t)bytes, __ATOMIC_RELAXED);
+}
+
+void ogllProbeFail(void) {
+        add(current ? &current->failures : &outside.failures, 1);
+}
+
+static void snapshot(ogll_stat_t* out, const ogll_site_t* s) {
+        out->name = s->name;
+        out->calls = __atomic_load_n(&s->calls, __ATOMIC_RELAXED);
+        out->nanos = __atomic_load_n(&s->nanos, __ATOMIC_RELAXED);
+        out->failures = __atomic_load_n(&s->failures, __ATOMIC_RELAXED);
+        out->allocs = __atomic_load_n(&s->allocs, __ATOMIC_RELAXED);
+        out->frees = __atomic_load_n(&s->frees, __ATOMIC_RELAXED);
+        out->bytes = __atomic_load_n(&s->bytes, __ATOMIC_RELAXED);
+}
+
+static bool used(const ogll_stat_t* st) {
+        return st->calls || st->failures || st->allocs || st->frees;
+}
+
+/* The `outside` site heads the walk, ahead of the real list */
+static const ogll_site_t* firstSite(void) {
+        return &outside;
+}
+
+static const ogll_site_t* nextSite(const ogll_site_t* s) {
+        return s == &outside ? __atomic_load_n(&sites, __ATOMIC_ACQUIRE) : s->next;
+}
+
+bool ogllInstrumentEnabled(void) {
+        return true;
+}
+
+/* Copy out up to `max` per-function records */
+size_t ogllInstrumentStats(ogll_stat_t* out, size_t max) {
+        const ogll_site_t* s;
+        ogll_stat_t st;
+        size_t n = 0;
+
+        for(s = firstSite(); s; s = nextSite(s)) {
+                snapshot(&st, s);
+
+                if(used(&st)) {
+                        if(out && n < max) {
+                                out[n] = st;
+                        }
+                        n++;
+                }
+        }
+
+        return n;
+}
+
+/* The record of one function, by name */
+bool ogllInstrumentStat(const char* name, ogll_stat_t* out) {
+        const ogll_site_t* s;
+
+        check(name && out, "Null argument given.");
+
+        for(s = firstSite(); s; s = nextSite(s)) {
+                if(strcmp(s->name, name) == 0) {
+                        snapshot(out, s);
+                        return used(out);
+                }
+        }
+
+ error:
+        return false;
+}
+
+/* Matrices and Streams currently alive */
+size_t ogllInstrumentLive(size_t* bytes) {
+        if(bytes) {
+                *bytes = (size_t)__atomic_load_n(&liveBytes, __ATOMIC_RELAXED);
+        }
+
+        return (size_t)__atomic_load_n(&liveObjects, __ATOMIC_RELAXED);
+}
+
+static void zero(ogll_site_t* s) {
+        __atomic_store_n(&s->calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->nanos, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->failures, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->allocs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->frees, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->bytes, 0, __ATOMIC_RELAXED);
+}
+
+/* Zero every counter and empty the trace */
+void ogllInstrumentReset(void) {
+        ogll_site_t* s;
+
+        zero(&outside);
+        for(s = __atomic_load_n(&sites, __ATOMIC_ACQUIRE); s; s = s->next) {
+                zero(s);
+        }
+
+        __atomic_store_n(&recorded, 0, __ATOMIC_RELAXED);
+}
+
+/* Start recording one event per call */
+bool ogllInstrumentTrace(size_t cap) {
+        event_t* fresh = NULL;
+
+        if(cap > 0) {
+                fresh = malloc(cap * sizeof(event_t));
+                check_mem(fresh);
+        }
+
+        free(events);
+        capacity = cap;
+        recorded = 0;
+        epoch = now();
+        __atomic_store_n(&events, fresh, __ATOMIC_RELEASE);
+
+        return true;
+ error:
+        return false;
+}
+
+/* Write recorded events as Chrome trace JSON */
+bool ogllInstrumentDump(FILE* f) {
+        size_t n = __atomic_load_n(&recorded, __ATOMIC_ACQUIRE);
+        size_t i;
+
+        check(f, "Null file given.");
+
+        if(n > capacity) {
+                n = capacity;
+        }
+
+        fprintf(f, "{\"traceEvents\":[");
+
+        for(i = 0; i < n; i++) {
+                const event_t* e = &events[i];
+
+                fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"ogll\",\"ph\":\"X\","
+                        "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                        i ? "," : "", e->site->name,
+                        (e->start - epoch) / 1000.0, e->dur / 1000.0, e->tid);
+        }
+
+        fprintf(f, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":\"%zu\"}}\n",
+                recorded > capacity ? recorded - capacity : 0);
+
+        return true;
+ error:
+        return false;
+}
+
+#else
+
+bool ogllInstrumentEnabled(void) {
+        return false;
+}
+
+size_t ogllInstrumentStats(ogll_stat_t* out, size_t max) {
+        (void)out;
+        (void)max;
+        return 0;
+}
+
+bool ogllInstrumentStat(const char* name, ogll_stat_t* out) {
+        (void)name;
+        (void)out;
+        return false;
+}
+
+size_t ogllInstrumentLive(size_t* bytes) {
+        if(bytes) {
+                *bytes = 0;
+        }
+
+        return 0;
+}
+
+void ogllInstrumentReset(void) {
+}
+
+bool ogllInstrumentTrace(size_t capacity) {
+        (void)capacity;
+        return false;
+}
+
+bool ogllInstrumentDump(FILE* f) {
+        check(f, "Null file given.");
+
+        fprintf(f, "{\"traceEvents\":[]}\n");
+
+        return true;
+ error:
+        return false;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef __ogll_instrument__
+#define __ogll_instrument__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opt-in instrumentation of the public API.
+ *
+ * Build the library with -DOGLL_INSTRUMENT and every public `ogll*`
+ * function counts its calls, time spent (inclusive of any `ogll*` calls
+ * it makes), `check()` failures, and the Matrices and Streams allocated
+ * and freed on its behalf. Allocations are charged to the outermost
+ * public function on the thread, so `ogllMMultiplyP` shows what it
+ * allocates through `ogllMCreate`. Failures are charged to the innermost.
+ *
+ * Without the flag the probes expand to nothing, and the query functions
+ * below report nothing, so callers needn't be built differently.
+ */
+
+// --- //
+
+typedef struct ogll_stat_t {
+        const char* name;
+        uint64_t calls;
+        uint64_t nanos;
+        uint64_t failures;
+        uint64_t allocs;
+        uint64_t frees;
+        uint64_t bytes;
+} ogll_stat_t;
+
+/* Was the library built with OGLL_INSTRUMENT? */
+bool ogllInstrumentEnabled(void);
+
+/* Copy out up to `max` per-function records, for functions called at
+   least once since the last reset. Yields how many there are in all. */
+size_t ogllInstrumentStats(ogll_stat_t* out, size_t max);
+
+/* The record of one function, by name. False if it hasn't been called. */
+bool ogllInstrumentStat(const char* name, ogll_stat_t* out);
+
+/* Matrices and Streams currently alive, and optionally their bytes */
+size_t ogllInstrumentLive(size_t* bytes);
+
+/* Zero every counter and empty the trace. Live counts are kept. */
+void ogllInstrumentReset(void);
+
+/* Start recording one event per call, keeping the first `capacity`.
+   0 stops recording and frees the buffer. Only call this while no other
+   thread is inside the library. */
+bool ogllInstrumentTrace(size_t capacity);
+
+/* Write recorded events as Chrome trace JSON, which chrome://tracing
+   and ui.perfetto.dev both load */
+bool ogllInstrumentDump(FILE* f);
+
+// --- PROBES --- //
+
+/* Used by the library sources themselves */
+
+#ifdef OGLL_INSTRUMENT
+
+typedef struct ogll_site_t {
+        const char* name;
+        uint64_t calls;
+        uint64_t nanos;
+        uint64_t failures;
+        uint64_t allocs;
+        uint64_t frees;
+        uint64_t bytes;
+        int listed;
+        struct ogll_site_t* next;
+} ogll_site_t;
+
+typedef struct ogll_probe_t {
+        ogll_site_t* site;
+        ogll_site_t* prev;
+        uint64_t start;
+} ogll_probe_t;
+
+ogll_probe_t ogllProbeBegin(ogll_site_t* site);
+void ogllProbeEnd(ogll_probe_t* p);
+void ogllProbeAlloc(size_t bytes);
+void ogllProbeFree(size_t bytes);
+void ogllProbeFail(void);
+
+/* First statement of a public function. Recorded on every return. */
+#define OGLL_PROBE() \
+        static ogll_site_t __ogll_site = { __func__ }; \
+        ogll_probe_t __ogll_probe __attribute__((cleanup(ogllProbeEnd))) = \
+                ogllProbeBegin(&__ogll_site)
+
+#define OGLL_PROBE_ALLOC(n) ogllProbeAlloc(n)
+#define OGLL_PROBE_FREE(n)  ogllProbeFree(n)
+
+#undef OGLL_PROBE_FAIL
+#define OGLL_PROBE_FAIL()   ogllProbeFail()
+
+#else
+
+#define OGLL_PROBE()
+#define OGLL_PROBE_ALLOC(n)
+#define OGLL_PROBE_FREE(n)
+
+#ifndef OGLL_PROBE_FAIL
+#define OGLL_PROBE_FAIL()
+#endif
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,6 +2,10 @@
 #include <math.h>
 
 #include "opengl-linalg.h"
+#include "alloc.h"
+#include "simd.h"
+#include "gemm.h"
+#include "instrument.h"
 #include "dbg.h"
 
 // --- //
@@ -10,42 +14,71 @@
 
 /* Create a Vector filled with zeros */
 matrix_t* ogllVCreate(size_t size) {
+        OGLL_PROBE();
         return ogllMCreate(1,size);
 }
 
 /* Create a Vector from a given array of floats */
 matrix_t* ogllVFromArray(size_t size, GLfloat* fs) {
+        OGLL_PROBE();
         return ogllMFromArray(1,size,fs);
 }
 
 /* The Cross-Product of two Vectors. Returns a new Vector. */
 matrix_t* ogllVCrossP(matrix_t* v1, matrix_t* v2) {
+        OGLL_PROBE();
         matrix_t* newV = NULL;
 
         check(v1 && v2, "Null Vectors given.");
-        check(v1->rows == v2->rows, "Vectors aren't same size.");
 
         newV = ogllVCreate(v1->rows);
         check(newV, "Vector creation failed.");
-
-        newV->m[0] = v1->m[1] * v2->m[2] - v1->m[2] * v2->m[1];
-        newV->m[1] = v1->m[0] * v2->m[2] - v1->m[2] * v2->m[0];
-        newV->m[2] = v1->m[0] * v2->m[1] - v1->m[1] * v2->m[0];
+        check(ogllVCrossInto(newV,v1,v2), "Cross-Product failed.");
 
         return newV;
  error:
+        ogllMDestroy(newV);
         return NULL;
 }
 
-/* Yields the Length/Magnitude of a given Vector */
+/* The Cross-Product of two Vectors, written into `dst` */
+matrix_t* ogllVCrossInto(matrix_t* dst, matrix_t* v1, matrix_t* v2) {
+        OGLL_PROBE();
+        GLfloat x,y,z;
+        size_t i;
+
+        check(dst && v1 && v2, "Null Vectors given.");
+        check(v1->rows == v2->rows && dst->rows == v1->rows,
+              "Vectors aren't same size.");
+        check(v1->rows >= 3, "Vectors too short.");
+
+        x = v1->m[1] * v2->m[2] - v1->m[2] * v2->m[1];
+        y = v1->m[0] * v2->m[2] - v1->m[2] * v2->m[0];
+        z = v1->m[0] * v2->m[1] - v1->m[1] * v2->m[0];
+
+        dst->m[0] = x;
+        dst->m[1] = y;
+        dst->m[2] = z;
+
+        for(i = 3; i < dst->rows; i++) {
+                dst->m[i] = 0;
+        }
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Yields the Length/Magnitude of a given Vector. Summed in double. */
 GLfloat ogllVLength(matrix_t* v) {
-        GLfloat len = 0;
+        OGLL_PROBE();
+        GLdouble len = 0;
         size_t i;
 
         check(ogllVIsVector(v), "Matrix given.");
 
         for(i = 0; i < v->rows; i++) {
-                len += v->m[i] * v->m[i];
+                len += (GLdouble)v->m[i] * v->m[i];
         }
 
         return sqrt(len);
@@ -53,20 +86,19 @@ GLfloat ogllVLength(matrix_t* v) {
         return 0;
 }
 
-/* Yields the Dot Product of two Vectors */
+/* Yields the Dot Product of two Vectors. Summed in double. */
 GLfloat ogllVDotProduct(matrix_t* v1, matrix_t* v2) {
-        GLfloat total = 0;
+        OGLL_PROBE();
+        GLdouble total = 0;
         size_t i;
 
         check(ogllVIsVector(v1) && ogllVIsVector(v2), "Matrices given.");
         check(v1->rows == v2->rows, "Vectors aren't same length.");
 
         for(i = 0; i < v1->rows; i++) {
-                total += v1->m[i] * v2->m[i];
+                total += (GLdouble)v1->m[i] * v2->m[i];
         }
 
-        debug("DOT PRODUCT: %f",total);
-
         return total;
  error:
         return 0;  // Take this return value with a grain of salt!
@@ -74,11 +106,13 @@ GLfloat ogllVDotProduct(matrix_t* v1, matrix_t* v2) {
 
 /* Are two Vectors orthogonal? */
 bool ogllVIsOrtho(matrix_t* v1, matrix_t* v2) {
+        OGLL_PROBE();
         return ogllVDotProduct(v1,v2) <= 0.000001;
 }
 
 /* Is a given Matrix struct actually a Vector? */
 bool ogllVIsVector(matrix_t* v) {
+        OGLL_PROBE();
         check(v, "Null Vector given.");
 
         return v->cols == 1;
@@ -88,29 +122,53 @@ bool ogllVIsVector(matrix_t* v) {
 
 // --- MATRICES --- //
 
-/* Create a column-major matrix */
+/* Header size rounded up so the data after it stays aligned */
+#define HEADER_SIZE ((sizeof(matrix_t) + OGLL_ALIGN - 1) & ~(size_t)(OGLL_ALIGN - 1))
+
+/* Longest row or column an aliased product copies aside on the stack */
+#define INTO_SCRATCH 1024
+
+/* Do the entries of two Matrices share any memory? */
+static bool overlaps(matrix_t* a, matrix_t* b) {
+        return a->m < b->m + b->cols * b->rows && b->m < a->m + a->cols * a->rows;
+}
+
+/* Are two Matrices the same entries, viewed the same way? */
+static bool same(matrix_t* a, matrix_t* b) {
+        return a->m == b->m && a->cols == b->cols && a->rows == b->rows;
+}
+
+/* Create a column-major matrix. The header and data share one block. */
 matrix_t* ogllMCreate(size_t cols, size_t rows) {
+        OGLL_PROBE();
+        const allocator_t* a = ogllGetAllocator();
         matrix_t* m = NULL;
-        GLfloat* innerM;
+        void* block = NULL;
+        size_t bytes;
         size_t i;
 
         check(cols > 0 && rows > 0, "Bad dimensions given.");
 
-        innerM = (GLfloat*)malloc(cols * rows * sizeof(GLfloat));
-        check_mem(innerM);
+        bytes = HEADER_SIZE + cols * rows * sizeof(GLfloat);
 
-        // Initialize each entry to 0
-        for(i = 0; i < cols * rows; i++) {
-                innerM[i] = 0;
+        if(a) {
+                block = a->alloc(a->ctx, bytes, OGLL_ALIGN);
+        } else if(posix_memalign(&block, OGLL_ALIGN, bytes) != 0) {
+                block = NULL;
         }
+        check_mem(block);
+        OGLL_PROBE_ALLOC(bytes);
 
-        // Construct actual return value
-        m = malloc(sizeof(matrix_t));
-        check_mem(m);
-
-        m->m = innerM;
+        m = (matrix_t*)block;
+        m->m = (GLfloat*)((char*)block + HEADER_SIZE);
         m->cols = cols;
         m->rows = rows;
+        m->alloc = a;
+
+        // Initialize each entry to 0
+        for(i = 0; i < cols * rows; i++) {
+                m->m[i] = 0;
+        }
 
         return m;
 
@@ -120,6 +178,7 @@ matrix_t* ogllMCreate(size_t cols, size_t rows) {
 
 /* Create a column-major Matrix from a given array of floats */
 matrix_t* ogllMFromArray(size_t cols, size_t rows, GLfloat* fs) {
+        OGLL_PROBE();
         matrix_t* m = NULL;
         size_t i;
         
@@ -141,6 +200,7 @@ matrix_t* ogllMFromArray(size_t cols, size_t rows, GLfloat* fs) {
 
 /* Make a copy of a given Matrix */
 matrix_t* ogllMCopy(matrix_t* m) {
+        OGLL_PROBE();
         matrix_t* newM = NULL;
         size_t i;
 
@@ -160,6 +220,7 @@ matrix_t* ogllMCopy(matrix_t* m) {
 
 /* Create an Identity Matrix of size `dim` */
 matrix_t* ogllMIdentity(size_t dim) {
+        OGLL_PROBE();
         matrix_t* m = ogllMCreate(dim,dim);
         unsigned int i;
 
@@ -176,6 +237,7 @@ matrix_t* ogllMIdentity(size_t dim) {
 
 /* Are two Matrices equal? */
 bool ogllMEqual(matrix_t* m1, matrix_t* m2) {
+        OGLL_PROBE();
         size_t i;
 
         check(m1 && m2, "Null Matrices given.");
@@ -193,6 +255,7 @@ bool ogllMEqual(matrix_t* m1, matrix_t* m2) {
 
 /* Set a value in a Matrix */
 void ogllMSet(matrix_t* m, size_t col, size_t row, GLfloat f) {
+        OGLL_PROBE();
         if(m && m->cols >= col && m->rows >= row) {
                 m->m[m->rows * col + row] = f;
         }
@@ -200,6 +263,7 @@ void ogllMSet(matrix_t* m, size_t col, size_t row, GLfloat f) {
 
 /* Scale a Matrix by some scalar. If the Matrix is 4x4, resets the homo bit */
 void ogllMScale(matrix_t* m, GLfloat f) {
+        OGLL_PROBE();
         size_t i;
 
         if(m) {
@@ -216,6 +280,7 @@ void ogllMScale(matrix_t* m, GLfloat f) {
 
 /* The values of m2 are added to m1 */
 matrix_t* ogllMAdd(matrix_t* m1, matrix_t* m2) {
+        OGLL_PROBE();
         size_t i;
 
         check(m1 && m2, "Null Matrices given.");
@@ -233,6 +298,7 @@ matrix_t* ogllMAdd(matrix_t* m1, matrix_t* m2) {
 
 /* Add two same-sized Matrices together. Returns a new Matrix. */
 matrix_t* ogllMAddP(matrix_t* m1, matrix_t* m2) {
+        OGLL_PROBE();
         matrix_t* newM = NULL;
 
         check(m1 && m2, "Null Matrices given.");
@@ -247,33 +313,37 @@ matrix_t* ogllMAddP(matrix_t* m1, matrix_t* m2) {
         return NULL;
 }
 
+/* Add two same-sized Matrices into `dst` */
+matrix_t* ogllMAddInto(matrix_t* dst, matrix_t* m1, matrix_t* m2) {
+        OGLL_PROBE();
+        size_t i;
+
+        check(dst && m1 && m2, "Null Matrices given.");
+        check(m1->cols == m2->cols && m1->rows == m2->rows &&
+              dst->cols == m1->cols && dst->rows == m1->rows,
+              "Matrices given aren't the same size.");
+        check((same(dst,m1) || !overlaps(dst,m1)) &&
+              (same(dst,m2) || !overlaps(dst,m2)),
+              "Destination partly overlaps an operand.");
+
+        for(i = 0; i < dst->cols * dst->rows; i++) {
+                dst->m[i] = m1->m[i] + m2->m[i];
+        }
+
+        return dst;
+ error:
+        return NULL;
+}
+
 /* Multiply two 4x4 matrices together in place. Affects `m1`. */
 matrix_t* ogllM4Multiply(matrix_t* m1, matrix_t* m2) {
-        static GLfloat fs[16];
-        size_t i,j,k;
-
+        OGLL_PROBE();
         // Were the matrices given valid?
         check(m1 && m2, "Null matrices given.");
         check(m1->cols == 4 && m1->rows == 4, "Matrix not 4x4.");
-        check(m1->cols == m2->rows, "Matrix sizes not compatible.");
-
-        // O(n^3)? I'm sorry?
-        for(i = 0; i < m1->rows; i++) {
-                for (j = 0; j < m2->cols; j++) {
-                        fs[j * (m1->rows) + i] = 0;
+        check(m2->cols == 4 && m2->rows == 4, "Matrix sizes not compatible.");
 
-                        for (k = 0; k < m2->rows; k++) {
-                                fs[j * (m1->rows) + i] +=
-                                        m1->m[k * (m1->rows) + i] *
-                                        m2->m[j * (m2->rows) + k];
-                        }
-                }
-        }
-
-        // Copy values back into `m1`.
-        for(i = 0; i < m1->cols * m1->rows; i++) {
-                m1->m[i] = fs[i];
-        }
+        ogllSimdM4Multiply(m1->m, m1->m, m2->m);
 
         return m1;
  error:
@@ -283,8 +353,9 @@ matrix_t* ogllM4Multiply(matrix_t* m1, matrix_t* m2) {
 /* Multiply two matrices together. The number of rows of m2 must match
    the number of columns of m1. Returns a new Matrix. */
 matrix_t* ogllMMultiplyP(matrix_t* m1, matrix_t* m2) {
+        OGLL_PROBE();
         matrix_t* newM = NULL;
-        size_t i,j,k;
+        size_t work;
 
         // Were the matrices given valid?
         check(m1 && m2, "Null matrices given.");
@@ -293,41 +364,204 @@ matrix_t* ogllMMultiplyP(matrix_t* m1, matrix_t* m2) {
         newM = ogllMCreate(m2->cols, m1->rows);
         check_mem(newM);
 
-        // O(n^3)? I'm sorry?
-        for(i = 0; i < m1->rows; i++) {
-                for (j = 0; j < m2->cols; j++) {
-                        newM->m[j * (m1->rows) + i] = 0;
+        // Large products go through the cache-blocked kernel, which needs
+        // packing space of its own.
+        work = m1->rows * m2->cols * m1->cols;
+        if(work >= OGLL_GEMM_MIN) {
+                check(ogllGemm(m1->rows, m2->cols, m1->cols,
+                               m1->m, m1->rows, m2->m, m2->rows,
+                               newM->m, newM->rows,
+                               work >= OGLL_GEMM_THREADED_MIN ?
+                               ogllGemmPool() : NULL),
+                      "Blocked multiply failed.");
+                return newM;
+        }
+
+        check(ogllMMultiplyInto(newM, m1, m2), "Multiply failed.");
+
+        return newM;
+ error:
+        ogllMDestroy(newM);
+        return NULL;
+}
+
+/* Multiply two matrices together into `dst` */
+matrix_t* ogllMMultiplyInto(matrix_t* dst, matrix_t* m1, matrix_t* m2) {
+        OGLL_PROBE();
+        GLfloat tmp[INTO_SCRATCH];
+        GLfloat sum;
+        bool inA, inB;
+        size_t i,j,k;
 
-                        for (k = 0; k < m2->rows; k++) {
-                                newM->m[j * (m1->rows) + i] +=
-                                        m1->m[k * (m1->rows) + i] *
-                                        m2->m[j * (m2->rows) + k];
+        // Were the matrices given valid?
+        check(dst && m1 && m2, "Null matrices given.");
+        check(m1->cols == m2->rows, "Matrix sizes not compatible.");
+        check(dst->cols == m2->cols && dst->rows == m1->rows,
+              "Destination is the wrong size.");
+
+        inA = same(dst,m1);
+        inB = same(dst,m2);
+        check((inA || !overlaps(dst,m1)) && (inB || !overlaps(dst,m2)),
+              "Destination partly overlaps an operand.");
+
+        // 4x4 products and transforms have vectorized kernels, which
+        // read all they need before writing.
+        if(m1->cols == 4 && m1->rows == 4) {
+                if(m2->cols == 4) {
+                        ogllSimdM4Multiply(dst->m, m1->m, m2->m);
+                        return dst;
+                } else if(m2->cols == 1) {
+                        ogllSimdM4Transform(dst->m, m1->m, m2->m);
+                        return dst;
+                }
+        }
+
+        if(!inA && !inB) {
+                // O(n^3)? I'm sorry?
+                for(i = 0; i < m1->rows; i++) {
+                        for(j = 0; j < m2->cols; j++) {
+                                sum = 0;
+
+                                for(k = 0; k < m2->rows; k++) {
+                                        sum += m1->m[k * m1->rows + i] *
+                                                m2->m[j * m2->rows + k];
+                                }
+
+                                dst->m[j * dst->rows + i] = sum;
                         }
                 }
+
+                return dst;
         }
 
-        return newM;
+        check(!(inA && inB), "Can't square a Matrix in place.");
+        check(m1->cols <= INTO_SCRATCH, "Matrix too large to multiply in place.");
+
+        if(inB) {
+                // dst = m1 * dst. Column j only needs column j of dst.
+                for(j = 0; j < m2->cols; j++) {
+                        for(k = 0; k < m2->rows; k++) {
+                                tmp[k] = m2->m[j * m2->rows + k];
+                        }
+
+                        for(i = 0; i < m1->rows; i++) {
+                                sum = 0;
+
+                                for(k = 0; k < m2->rows; k++) {
+                                        sum += m1->m[k * m1->rows + i] * tmp[k];
+                                }
+
+                                dst->m[j * dst->rows + i] = sum;
+                        }
+                }
+        } else {
+                // dst = dst * m2. Row i only needs row i of dst.
+                for(i = 0; i < m1->rows; i++) {
+                        for(k = 0; k < m1->cols; k++) {
+                                tmp[k] = m1->m[k * m1->rows + i];
+                        }
+
+                        for(j = 0; j < m2->cols; j++) {
+                                sum = 0;
+
+                                for(k = 0; k < m2->rows; k++) {
+                                        sum += tmp[k] * m2->m[j * m2->rows + k];
+                                }
+
+                                dst->m[j * dst->rows + i] = sum;
+                        }
+                }
+        }
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Transform `count` points by a 4x4 Matrix in one call */
+matrix_t* ogllM4TransformN(matrix_t* m, const GLfloat* in, GLfloat* out,
+                           size_t count, size_t comps, size_t stride) {
+        OGLL_PROBE();
+        check(m && in && out, "Null arguments given.");
+        check(m->cols == 4 && m->rows == 4, "Matrix not 4x4.");
+        check(comps == 3 || comps == 4, "Points must have 3 or 4 components.");
+
+        if(stride == 0) {
+                stride = comps;
+        }
+
+        check(stride >= comps, "Stride smaller than a point.");
+
+        ogllSimdM4TransformN(out, m->m, in, count, comps, stride);
+
+        return m;
+ error:
+        return NULL;
+}
+
+/* Multiply a 4x4 parent by `count` packed 4x4 children */
+matrix_t* ogllM4MultiplyN(matrix_t* m, const GLfloat* children, GLfloat* out,
+                          size_t count) {
+        OGLL_PROBE();
+        check(m && children && out, "Null arguments given.");
+        check(m->cols == 4 && m->rows == 4, "Matrix not 4x4.");
+        check(out != m->m, "Output can't overwrite the parent Matrix.");
+
+        ogllSimdM4MultiplyN(out, m->m, children, count);
+
+        return m;
  error:
         return NULL;
 }
 
 /* Transpose a Matrix. Returns a new Matrix. */
 matrix_t* ogllMTranspose(matrix_t* m) {
+        OGLL_PROBE();
         matrix_t* newM = NULL;
-        size_t i,j;
 
         check(m, "Null Matrix given.");
 
         newM = ogllMCreate(m->rows,m->cols);
         check(newM, "Matrix creation failed.");
 
+        return ogllMTransposeInto(newM,m);
+ error:
+        return NULL;
+}
+
+/* Transpose a Matrix into `dst` */
+matrix_t* ogllMTransposeInto(matrix_t* dst, matrix_t* m) {
+        OGLL_PROBE();
+        GLfloat f;
+        size_t i,j;
+
+        check(dst && m, "Null Matrix given.");
+        check(dst->cols == m->rows && dst->rows == m->cols,
+              "Destination is the wrong size.");
+
+        if(dst->m == m->m) {
+                check(m->cols == m->rows, "Only square Matrices transpose in place.");
+
+                for(i = 0; i < m->rows; i++) {
+                        for(j = i + 1; j < m->cols; j++) {
+                                f = m->m[j * m->rows + i];
+                                m->m[j * m->rows + i] = m->m[i * m->rows + j];
+                                m->m[i * m->rows + j] = f;
+                        }
+                }
+
+                return dst;
+        }
+
+        check(!overlaps(dst,m), "Destination partly overlaps the Matrix.");
+
         for(i = 0; i < m->rows; i++) {
                 for(j = 0; j < m->cols; j++) {
-                        newM->m[i * m->cols + j] = m->m[j * m->rows + i];
+                        dst->m[i * m->cols + j] = m->m[j * m->rows + i];
                 }
         }
 
-        return newM;
+        return dst;
  error:
         return NULL;
 }
@@ -335,13 +569,14 @@ matrix_t* ogllMTranspose(matrix_t* m) {
 /* Rotate a 4x4 Matrix in place by `r` radians around the unit vector
 formed by `x` `y` and `z` */
 matrix_t* ogllM4Rotate(matrix_t* m,GLfloat r,GLfloat x,GLfloat y,GLfloat z) {
-        static matrix_t rot;
-        static GLfloat fs[16] = {
+        OGLL_PROBE();
+        GLfloat fs[16] = {
                 1,0,0,0,
                 0,1,0,0,
                 0,0,1,0,
                 0,0,0,1
         };
+        matrix_t rot = { fs, 4, 4 };
 
         check(m, "Null Matrix given.");
         check(m->cols == 4 && m->rows == 4, "Matrix not 4x4");
@@ -364,11 +599,6 @@ matrix_t* ogllM4Rotate(matrix_t* m,GLfloat r,GLfloat x,GLfloat y,GLfloat z) {
         fs[9]  = y*z*(1-cosr)-x*sinr;
         fs[10] = cosr+z*z*(1-cosr);
 
-        // Set stack struct values.
-        rot.m = fs;
-        rot.cols = 4;
-        rot.rows = 4;
-
         return ogllM4Multiply(m,&rot);
  error:
         return NULL;
@@ -376,6 +606,7 @@ matrix_t* ogllM4Rotate(matrix_t* m,GLfloat r,GLfloat x,GLfloat y,GLfloat z) {
 
 /* Adds translation factor to a transformation Matrix (in place) */
 matrix_t* ogllM4Translate(matrix_t* m, GLfloat x, GLfloat y, GLfloat z) {
+        OGLL_PROBE();
         check(m, "Null Matrix given.");
         check(m->cols == 4 && m->rows == 4, "Matrix isn't 4x4");
 
@@ -395,8 +626,28 @@ matrix_t* ogllM4Translate(matrix_t* m, GLfloat x, GLfloat y, GLfloat z) {
    n    := Distance from camera to near-clipping plane.
    f    := Distance from camera to far-clipping plane. */
 matrix_t* ogllMPerspectiveP(GLfloat fov, GLfloat aspr, GLfloat n, GLfloat f) {
+        OGLL_PROBE();
         matrix_t* m = NULL;
 
+        m = ogllMCreate(4,4);
+        check(m, "Could not create Perspective Matrix.");
+        check(ogllMPerspectiveInto(m,fov,aspr,n,f),
+              "Could not create Perspective Matrix.");
+
+        return m;
+ error:
+        ogllMDestroy(m);
+        return NULL;
+}
+
+/* Write a Perspective Projection Matrix into a 4x4 `dst` */
+matrix_t* ogllMPerspectiveInto(matrix_t* dst, GLfloat fov, GLfloat aspr,
+                               GLfloat n, GLfloat f) {
+        OGLL_PROBE();
+        size_t i;
+
+        check(dst, "Null Matrix given.");
+        check(dst->cols == 4 && dst->rows == 4, "Matrix not 4x4.");
         check(aspr > 0, "Invalid Aspect Ratio given.");
         check(n < f, "Near-clipping plane farther than far-clipping plane!");
 
@@ -410,16 +661,18 @@ matrix_t* ogllMPerspectiveP(GLfloat fov, GLfloat aspr, GLfloat n, GLfloat f) {
                 0, 0, (-2*f*n)/(f-n), 0
         };
 
-        m = ogllMFromArray(4,4,fs);
-        check(m, "Could not create Perspective Matrix.");
+        for(i = 0; i < 16; i++) {
+                dst->m[i] = fs[i];
+        }
 
-        return m;
+        return dst;
  error:
         return NULL;
 }
 
 /* Generate a View Matrix */
 matrix_t* ogllM4LookAtP(matrix_t* camPos, matrix_t* target, matrix_t* up) {
+        OGLL_PROBE();
         matrix_t* view     = NULL;
         matrix_t* camDir   = NULL;
         matrix_t* camRight = NULL;
@@ -473,16 +726,66 @@ matrix_t* ogllM4LookAtP(matrix_t* camPos, matrix_t* target, matrix_t* up) {
         return NULL;
 }
 
+/* Write a View Matrix into a 4x4 `dst` */
+matrix_t* ogllM4LookAtInto(matrix_t* dst, matrix_t* camPos, matrix_t* target,
+                           matrix_t* up) {
+        OGLL_PROBE();
+        GLfloat dir[3], right[3], camUp[3], pos[3];
+        size_t i;
+
+        check(dst && camPos && target && up, "Null Matrices given.");
+        check(dst->cols == 4 && dst->rows == 4, "Matrix not 4x4.");
+        check(ogllVIsVector(camPos) &&
+              ogllVIsVector(target) &&
+              ogllVIsVector(up), "Matrices given instead of Vectors.");
+        check(camPos->rows >= 3 && target->rows >= 3 && up->rows >= 3,
+              "Vectors too short.");
+
+        // Same arithmetic as `ogllM4LookAtP`, Cross-Products included.
+        for(i = 0; i < 3; i++) {
+                dir[i] = camPos->m[i] + -target->m[i];
+                pos[i] = -camPos->m[i];
+        }
+
+        right[0] = up->m[1] * dir[2] - up->m[2] * dir[1];
+        right[1] = up->m[0] * dir[2] - up->m[2] * dir[0];
+        right[2] = up->m[0] * dir[1] - up->m[1] * dir[0];
+
+        camUp[0] = dir[1] * right[2] - dir[2] * right[1];
+        camUp[1] = dir[0] * right[2] - dir[2] * right[0];
+        camUp[2] = dir[0] * right[1] - dir[1] * right[0];
+
+        for(i = 0; i < 3; i++) {
+                dst->m[i * 4]     = right[i];
+                dst->m[i * 4 + 1] = camUp[i];
+                dst->m[i * 4 + 2] = dir[i];
+                dst->m[i * 4 + 3] = 0;
+                dst->m[12 + i]    = pos[i];
+        }
+        dst->m[15] = 1;
+
+        return dst;
+ error:
+        return NULL;
+}
+
 /* Deallocate a Matrix */
 void ogllMDestroy(matrix_t* m) {
+        OGLL_PROBE();
         if(m) {
-                free(m->m);
-                free(m);
+                OGLL_PROBE_FREE(HEADER_SIZE + m->cols * m->rows * sizeof(GLfloat));
+
+                if(m->alloc) {
+                        m->alloc->free(m->alloc->ctx, m);
+                } else {
+                        free(m);
+                }
         }
 }
 
 /* Print a Matrix */
 void ogllMPrint(matrix_t* m) {
+        OGLL_PROBE();
         size_t i,j;
 
         if(m) {
@@ -500,6 +803,7 @@ void ogllMPrint(matrix_t* m) {
 
 /* Print Matrix values in their internal order */
 void ogllMPrintLinear(matrix_t* m) {
+        OGLL_PROBE();
         size_t i;
 
         if(m) {
@@ -4,15 +4,39 @@
 #include <GL/glew.h>
 #include <stdbool.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // --- //
 
+struct allocator_t;
+
 typedef struct matrix_t {
         GLfloat* m;
         size_t cols;
         size_t rows;
+        const struct allocator_t* alloc;  // NULL if from malloc or the stack
 } matrix_t;
 
-static const GLfloat tau = 6.283185;
+/* 2pi, to the nearest float and the nearest double */
+static const GLfloat tau = 6.28318530717958647692f;
+static const GLdouble dtau = 6.28318530717958647692;
+
+/* Matrices from `ogllMCreate` keep their header and data in one block,
+   with the data aligned to this many bytes. Fit for aligned AVX loads and
+   for handing `m->m` straight to `glUniformMatrix4fv`. */
+#define OGLL_ALIGN 32
+
+/* Each function ending in P returns a new Matrix. Its `Into` twin writes
+   the same result into an existing `dst` of the right shape instead, and
+   allocates nothing. Shapes are checked before anything is written, and
+   `dst` may be one of the inputs. A `dst` that only partly overlaps an
+   input is refused.
+
+   Every function here is reentrant. In-place operations keep their
+   scratch space on the stack, so separate threads may work on separate
+   Matrices at the same time without locking. */
 
 // --- //
 
@@ -27,10 +51,15 @@ matrix_t* ogllVFromArray(size_t size, GLfloat* fs);
 /* The Cross-Product of two Vectors. Returns a new Vector. */
 matrix_t* ogllVCrossP(matrix_t* v1, matrix_t* v2);
 
-/* Yields the Length/Magnitude of a given Vector */
+/* The Cross-Product of two Vectors of 3 or more rows, written into `dst`
+   (rows past the third are zeroed). `dst` may be `v1` or `v2`. */
+matrix_t* ogllVCrossInto(matrix_t* dst, matrix_t* v1, matrix_t* v2);
+
+/* Yields the Length/Magnitude of a given Vector. Summed in double. */
 GLfloat ogllVLength(matrix_t* v);
 
-/* Yields the Dot Product of two Vectors */
+/* Yields the Dot Product of two Vectors. Summed in double, so long
+   Vectors don't drift. */
 GLfloat ogllVDotProduct(matrix_t* v1, matrix_t* v2);
 
 /* Are two Vectors orthogonal? */
@@ -41,7 +70,8 @@ bool ogllVIsVector(matrix_t* v);
 
 // --- MATRICES --- //
 
-/* Create a column-major Matrix of all 0s */
+/* Create a column-major Matrix of all 0s. Memory comes from the calling
+   thread's allocator (see alloc.h), or malloc if none is installed. */
 matrix_t* ogllMCreate(size_t cols, size_t rows);
 
 /* Create a column-major Matrix from a given array of floats */
@@ -68,6 +98,9 @@ matrix_t* ogllMAdd(matrix_t* m1, matrix_t* m2);
 /* Add two same-sized Matrices together. Returns a new Matrix. */
 matrix_t* ogllMAddP(matrix_t* m1, matrix_t* m2);
 
+/* Add two same-sized Matrices into `dst` */
+matrix_t* ogllMAddInto(matrix_t* dst, matrix_t* m1, matrix_t* m2);
+
 /* Multiply two 4x4 matrices together in place. Affects `m1`. */
 matrix_t* ogllM4Multiply(matrix_t* m1, matrix_t* m2);
 
@@ -75,9 +108,34 @@ matrix_t* ogllM4Multiply(matrix_t* m1, matrix_t* m2);
    the number of columns of m1. Returns a new Matrix. */
 matrix_t* ogllMMultiplyP(matrix_t* m1, matrix_t* m2);
 
+/* Multiply two matrices together into `dst`, which must be m2->cols x
+   m1->rows. `dst` may be `m1` (if m2 is square) or `m2` (if m1 is
+   square), in which case the inner dimension can be at most 1024.
+   Only 4x4 Matrices may be squared in place. Large products stay on the
+   plain loop, since the blocked GEMM `ogllMMultiplyP` uses needs packing
+   space; `ogllGemmWith` runs it on a workspace of the caller's. */
+matrix_t* ogllMMultiplyInto(matrix_t* dst, matrix_t* m1, matrix_t* m2);
+
+/* Transform `count` points by a 4x4 Matrix in one call. Each point is
+   `comps` (3 or 4) floats and consecutive points start `stride` floats
+   apart (0 means tightly packed). xyz points get an implicit w of 1.
+   `out` may be `in`. Nothing is allocated. */
+matrix_t* ogllM4TransformN(matrix_t* m, const GLfloat* in, GLfloat* out,
+                           size_t count, size_t comps, size_t stride);
+
+/* Multiply a 4x4 parent by `count` packed 4x4 children, writing
+   parent * child[i] into out[i]. `out` may be `children`. Nothing is
+   allocated. */
+matrix_t* ogllM4MultiplyN(matrix_t* m, const GLfloat* children, GLfloat* out,
+                          size_t count);
+
 /* Transpose a Matrix. Returns a new Matrix. */
 matrix_t* ogllMTranspose(matrix_t* m);
 
+/* Transpose a Matrix into `dst`, which must be m->rows x m->cols.
+   Square Matrices may be transposed in place. */
+matrix_t* ogllMTransposeInto(matrix_t* dst, matrix_t* m);
+
 /* Rotate a 4x4 Matrix in place by `r` radians around the unit vector
 formed by `x` `y` and `z` */
 matrix_t* ogllM4Rotate(matrix_t* m,GLfloat r,GLfloat x,GLfloat y,GLfloat z);
@@ -92,10 +150,19 @@ matrix_t* ogllM4Translate(matrix_t* m, GLfloat x, GLfloat y, GLfloat z);
    f    := Distance from camera to far-clipping plane. */
 matrix_t* ogllMPerspectiveP(GLfloat fov, GLfloat aspr, GLfloat n, GLfloat f);
 
+/* Write a Perspective Projection Matrix into a 4x4 `dst` */
+matrix_t* ogllMPerspectiveInto(matrix_t* dst, GLfloat fov, GLfloat aspr,
+                               GLfloat n, GLfloat f);
+
 /* Generate a View Matrix */
 matrix_t* ogllM4LookAtP(matrix_t* camPos, matrix_t* target, matrix_t* up);
 
-/* Deallocate a Matrix */
+/* Write a View Matrix into a 4x4 `dst`. Unlike `ogllM4LookAtP`, this
+   leaves `camPos` and `target` as they were. */
+matrix_t* ogllM4LookAtInto(matrix_t* dst, matrix_t* camPos, matrix_t* target,
+                           matrix_t* up);
+
+/* Deallocate a Matrix, returning it to the allocator it came from */
 void ogllMDestroy(matrix_t* m);
 
 /* Print a Matrix */
@@ -104,4 +171,8 @@ void ogllMPrint(matrix_t* m);
 /* Print Matrix values in their internal order */
 void ogllMPrintLinear(matrix_t* m);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
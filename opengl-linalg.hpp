@@ -0,0 +1,382 @@
+#ifndef __opengl_linalg_hpp__
+#define __opengl_linalg_hpp__
+
+/* C++17 front end for opengl-linalg.
+ *
+ * `ogll::Matrix<Cols,Rows>` is a fixed-size, column-major Matrix whose
+ * storage is laid out exactly like `matrix_t->m` (and `mat4_t` for 4x4),
+ * so `view()` hands it to the C API without copying. Shapes are template
+ * parameters: multiplying incompatible Matrices doesn't compile, where the
+ * C API would fail a `check()` at runtime. Every fixed-size loop is
+ * expanded through index sequences, and identity, translation, rotation,
+ * perspective and lookAt Matrices can be built in constant expressions.
+ *
+ * Sums run in the same order as the C loops, so products match the C API
+ * bit for bit. The constexpr `sin`/`cos`/`tan` below are series
+ * approximations good to about 1 ULP of float; Matrices built at runtime
+ * from them may differ from `ogllM4Rotate`/`ogllMPerspectiveP` in the last
+ * bit.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <utility>
+
+#include "opengl-linalg.h"
+#include "value.h"
+#include "simd.h"
+
+namespace ogll {
+
+/* `::tau` as a constant expression */
+constexpr GLfloat tau = 6.28318530717958647692f;
+
+// --- CONSTEXPR MATHS --- //
+
+namespace detail {
+
+constexpr double pi = 3.14159265358979323846;
+
+/* Reduce to [-pi, pi] */
+constexpr double wrap(double r) {
+        double turns = r / (2 * pi);
+        long long whole = static_cast<long long>(turns < 0 ? turns - 0.5
+                                                           : turns + 0.5);
+
+        return r - whole * 2 * pi;
+}
+
+/* Taylor series, run until terms vanish at double precision */
+constexpr double sin(double r) {
+        double x = wrap(r);
+        double term = x;
+        double sum = x;
+
+        for(int n = 1; n < 20; n++) {
+                term *= -x * x / ((2 * n) * (2 * n + 1));
+                sum += term;
+        }
+
+        return sum;
+}
+
+constexpr double cos(double r) {
+        double x = wrap(r);
+        double term = 1;
+        double sum = 1;
+
+        for(int n = 1; n < 20; n++) {
+                term *= -x * x / ((2 * n - 1) * (2 * n));
+                sum += term;
+        }
+
+        return sum;
+}
+
+constexpr double tan(double r) {
+        return sin(r) / cos(r);
+}
+
+/* Not constexpr, so reaching it during constant evaluation is a compile
+   error, and at runtime it logs like `check()` does. */
+inline void invalid(const char* msg) {
+        std::fprintf(stderr, "[ERROR] (ogll) %s\n", msg);
+}
+
+} // namespace detail
+
+// --- MATRICES --- //
+
+template<std::size_t Cols, std::size_t Rows>
+struct Matrix {
+        static_assert(Cols > 0 && Rows > 0, "Bad dimensions given.");
+
+        static constexpr std::size_t cols = Cols;
+        static constexpr std::size_t rows = Rows;
+        static constexpr std::size_t size = Cols * Rows;
+
+        alignas((Cols * Rows) % 4 == 0 ? 16 : alignof(GLfloat))
+        GLfloat m[Cols * Rows];
+
+        constexpr GLfloat operator()(std::size_t col, std::size_t row) const {
+                return m[col * Rows + row];
+        }
+
+        constexpr GLfloat& operator()(std::size_t col, std::size_t row) {
+                return m[col * Rows + row];
+        }
+
+        constexpr GLfloat operator[](std::size_t i) const { return m[i]; }
+        constexpr GLfloat& operator[](std::size_t i) { return m[i]; }
+
+        /* A non-owning `matrix_t` for the C API. Never `ogllMDestroy` it. */
+        matrix_t view() {
+                return matrix_t{ m, Cols, Rows, nullptr };
+        }
+
+        /* Copy from a `matrix_t`, whose shape can only be checked here at
+           runtime. Returns false on a mismatch. */
+        bool load(const matrix_t* src) {
+                if(!src || src->cols != Cols || src->rows != Rows) {
+                        detail::invalid("Matrix shape mismatch.");
+                        return false;
+                }
+
+                for(std::size_t i = 0; i < size; i++) {
+                        m[i] = src->m[i];
+                }
+
+                return true;
+        }
+};
+
+template<std::size_t N> using Vector = Matrix<1, N>;
+
+using Mat4 = Matrix<4, 4>;
+using Vec2 = Vector<2>;
+using Vec3 = Vector<3>;
+using Vec4 = Vector<4>;
+
+static_assert(sizeof(Mat4) == sizeof(mat4_t), "Mat4 must match mat4_t.");
+static_assert(sizeof(Vec4) == 4 * sizeof(GLfloat), "Vec4 must be packed.");
+
+namespace detail {
+
+template<std::size_t C, std::size_t R, std::size_t... I>
+constexpr Matrix<C, R> fill(GLfloat f, std::index_sequence<I...>) {
+        return Matrix<C, R>{{ ((void)I, f)... }};
+}
+
+template<std::size_t C, std::size_t R, std::size_t... I>
+constexpr Matrix<C, R> diagonal(std::index_sequence<I...>) {
+        return Matrix<C, R>{{ (I / R == I % R ? GLfloat(1) : GLfloat(0))... }};
+}
+
+template<std::size_t C, std::size_t R, std::size_t... I>
+constexpr Matrix<C, R> fromArray(const GLfloat* fs, std::index_sequence<I...>) {
+        return Matrix<C, R>{{ fs[I]... }};
+}
+
+template<std::size_t C, std::size_t R, typename F, std::size_t... I>
+constexpr Matrix<C, R> generate(F f, std::index_sequence<I...>) {
+        return Matrix<C, R>{{ f(I / R, I % R)... }};
+}
+
+/* One entry of a product, summed from 0 in k order like the C loop */
+template<std::size_t K, std::size_t R1, std::size_t C2, std::size_t... k>
+constexpr GLfloat dotRowCol(const Matrix<K, R1>& a, const Matrix<C2, K>& b,
+                            std::size_t i, std::size_t j,
+                            std::index_sequence<k...>) {
+        return (GLfloat(0) + ... + (a(k, i) * b(j, k)));
+}
+
+} // namespace detail
+
+/* A Matrix of all 0s */
+template<std::size_t C, std::size_t R>
+constexpr Matrix<C, R> zero() {
+        return detail::fill<C, R>(0, std::make_index_sequence<C * R>{});
+}
+
+/* An Identity Matrix of size `N` */
+template<std::size_t N>
+constexpr Matrix<N, N> identity() {
+        return detail::diagonal<N, N>(std::make_index_sequence<N * N>{});
+}
+
+/* A Matrix from `C * R` column-major floats */
+template<std::size_t C, std::size_t R>
+constexpr Matrix<C, R> fromArray(const GLfloat* fs) {
+        return detail::fromArray<C, R>(fs, std::make_index_sequence<C * R>{});
+}
+
+/* A Vector from its components */
+template<typename... T>
+constexpr Vector<sizeof...(T)> vec(T... fs) {
+        return Vector<sizeof...(T)>{{ static_cast<GLfloat>(fs)... }};
+}
+
+template<std::size_t C, std::size_t R>
+constexpr bool operator==(const Matrix<C, R>& a, const Matrix<C, R>& b) {
+        for(std::size_t i = 0; i < C * R; i++) {
+                if(a.m[i] != b.m[i]) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+template<std::size_t C, std::size_t R>
+constexpr bool operator!=(const Matrix<C, R>& a, const Matrix<C, R>& b) {
+        return !(a == b);
+}
+
+template<std::size_t C, std::size_t R>
+constexpr Matrix<C, R> operator+(const Matrix<C, R>& a, const Matrix<C, R>& b) {
+        return detail::generate<C, R>(
+                [&](std::size_t c, std::size_t r) { return a(c, r) + b(c, r); },
+                std::make_index_sequence<C * R>{});
+}
+
+template<std::size_t C, std::size_t R>
+constexpr Matrix<C, R> operator-(const Matrix<C, R>& a, const Matrix<C, R>& b) {
+        return detail::generate<C, R>(
+                [&](std::size_t c, std::size_t r) { return a(c, r) - b(c, r); },
+                std::make_index_sequence<C * R>{});
+}
+
+/* Plain scaling. Unlike `ogllMScale`, the homo bit is left alone. */
+template<std::size_t C, std::size_t R>
+constexpr Matrix<C, R> operator*(GLfloat f, const Matrix<C, R>& a) {
+        return detail::generate<C, R>(
+                [&](std::size_t c, std::size_t r) { return f * a(c, r); },
+                std::make_index_sequence<C * R>{});
+}
+
+template<std::size_t C, std::size_t R>
+constexpr Matrix<C, R> operator*(const Matrix<C, R>& a, GLfloat f) {
+        return f * a;
+}
+
+/* Matrix product. The columns of `a` must equal the rows of `b`, or this
+   overload simply doesn't exist. */
+template<std::size_t K, std::size_t R1, std::size_t C2>
+constexpr Matrix<C2, R1> operator*(const Matrix<K, R1>& a,
+                                   const Matrix<C2, K>& b) {
+        return detail::generate<C2, R1>(
+                [&](std::size_t j, std::size_t i) {
+                        return detail::dotRowCol(a, b, i, j,
+                                                 std::make_index_sequence<K>{});
+                },
+                std::make_index_sequence<C2 * R1>{});
+}
+
+/* Multiply two 4x4 Matrices in place through the SIMD kernel. Same
+   result as `m1 = m1 * m2`, but not usable in constant expressions. */
+inline Mat4& multiply(Mat4& m1, const Mat4& m2) {
+        ogllSimdM4Multiply(m1.m, m1.m, m2.m);
+        return m1;
+}
+
+/* Transpose a Matrix */
+template<std::size_t C, std::size_t R>
+constexpr Matrix<R, C> transpose(const Matrix<C, R>& a) {
+        return detail::generate<R, C>(
+                [&](std::size_t c, std::size_t r) { return a(r, c); },
+                std::make_index_sequence<C * R>{});
+}
+
+// --- VECTORS --- //
+
+/* Yields the Dot Product of two Vectors */
+template<std::size_t N>
+constexpr GLfloat dot(const Vector<N>& v1, const Vector<N>& v2) {
+        return (transpose(v1) * v2)[0];
+}
+
+/* Yields the Length/Magnitude of a given Vector */
+template<std::size_t N>
+inline GLfloat length(const Vector<N>& v) {
+        return std::sqrt(dot(v, v));
+}
+
+/* The Cross-Product of two Vectors. Agrees with `ogllV3Cross`. */
+constexpr Vec3 cross(const Vec3& v1, const Vec3& v2) {
+        return vec(v1[1] * v2[2] - v1[2] * v2[1],
+                   v1[2] * v2[0] - v1[0] * v2[2],
+                   v1[0] * v2[1] - v1[1] * v2[0]);
+}
+
+// --- TRANSFORMS --- //
+
+/* A rotation of `r` radians around the unit vector (x,y,z) */
+constexpr Mat4 rotation(GLfloat r, GLfloat x, GLfloat y, GLfloat z) {
+        GLfloat cosr = static_cast<GLfloat>(detail::cos(r));
+        GLfloat sinr = static_cast<GLfloat>(detail::sin(r));
+        Mat4 rot = identity<4>();
+
+        // Same construction as `ogllM4Rotate`.
+        rot.m[0]  = cosr+x*x*(1-cosr);
+        rot.m[1]  = y*x*(1-cosr)+z*sinr;
+        rot.m[2]  = z*x*(1-cosr)-y*sinr;
+        rot.m[4]  = x*y*(1-cosr)-z*sinr;
+        rot.m[5]  = cosr+y*y*(1-cosr);
+        rot.m[6]  = z*y*(1-cosr)+x*sinr;
+        rot.m[8]  = x*z*(1-cosr)+y*sinr;
+        rot.m[9]  = y*z*(1-cosr)-x*sinr;
+        rot.m[10] = cosr+z*z*(1-cosr);
+
+        return rot;
+}
+
+/* Rotate a 4x4 Matrix in place, like `ogllM4Rotate` */
+constexpr Mat4& rotate(Mat4& m, GLfloat r, GLfloat x, GLfloat y, GLfloat z) {
+        m = m * rotation(r, x, y, z);
+        return m;
+}
+
+/* Set the translation of a transformation Matrix, like `ogllM4Translate` */
+constexpr Mat4& translate(Mat4& m, GLfloat x, GLfloat y, GLfloat z) {
+        m.m[12] = x;
+        m.m[13] = y;
+        m.m[14] = z;
+        return m;
+}
+
+/* A Perspective Projection Matrix. See `ogllMPerspectiveP`. Bad arguments
+   fail to compile in constant expressions, and give a zero Matrix at
+   runtime. */
+constexpr Mat4 perspective(GLfloat fov, GLfloat aspr, GLfloat n, GLfloat f) {
+        Mat4 p = zero<4, 4>();
+
+        if(!(aspr > 0 && n < f)) {
+                detail::invalid("Invalid Aspect Ratio or clipping planes.");
+                return p;
+        }
+
+        GLfloat t = n * static_cast<GLfloat>(detail::tan(fov / 2.0));
+        GLfloat r = t * aspr;
+
+        p.m[0]  = n/r;
+        p.m[5]  = n/t;
+        p.m[10] = -(f+n)/(f-n);
+        p.m[11] = -1;
+        p.m[14] = (-2*f*n)/(f-n);
+
+        return p;
+}
+
+namespace detail {
+
+/* A Cross-Product with the y component negated, as `ogllVCrossP`
+   computes it, so that `lookAt` matches `ogllM4LookAtP` */
+constexpr Vec3 lookAtCross(const Vec3& v1, const Vec3& v2) {
+        return vec(v1[1] * v2[2] - v1[2] * v2[1],
+                   v1[0] * v2[2] - v1[2] * v2[0],
+                   v1[0] * v2[1] - v1[1] * v2[0]);
+}
+
+} // namespace detail
+
+/* A View Matrix, like `ogllM4LookAtP` but without touching its arguments */
+constexpr Mat4 lookAt(const Vec3& camPos, const Vec3& target, const Vec3& up) {
+        Vec3 camDir   = camPos - target;
+        Vec3 camRight = detail::lookAtCross(up, camDir);
+        Vec3 camUp    = detail::lookAtCross(camDir, camRight);
+        Mat4 view = identity<4>();
+
+        for(std::size_t c = 0; c < 3; c++) {
+                view(c, 0) = camRight[c];
+                view(c, 1) = camUp[c];
+                view(c, 2) = camDir[c];
+                view(3, c) = -camPos[c];
+        }
+
+        return view;
+}
+
+} // namespace ogll
+
+#endif
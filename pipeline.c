@@ -0,0 +1,277 @@
+#include "pipeline.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OGLL_X86
+#include <immintrin.h>
+#endif
+
+// --- //
+
+#define PIPELINE_GRAIN 4096
+
+typedef struct job_t {
+        const GLfloat* m;
+        GLfloat vx, vy, vn;         // Window offsets
+        GLfloat hw, hh, hd;         // Half extents
+        const soa_t* in;
+        soa_t* out;
+        uint8_t* codes;
+        size_t inside;
+        bool sse;
+} job_t;
+
+static bool useSse(void) {
+#ifdef OGLL_X86
+        return ogllSimdBackend() != OGLL_SIMD_SCALAR;
+#else
+        return false;
+#endif
+}
+
+static void setup(job_t* job, const pipeline_t* p) {
+        const viewport_t* vp = &p->viewport;
+
+        job->m = p->mvp.m;
+        job->vx = vp->x;
+        job->vy = vp->y;
+        job->vn = vp->near;
+        job->hw = vp->width * 0.5f;
+        job->hh = vp->height * 0.5f;
+        job->hd = (vp->far - vp->near) * 0.5f;
+}
+
+// --- VERTICES --- //
+
+/* Both the plain and SSE paths form each sum in the same order, so they
+   always agree. `s` gets window x, y, depth and 1/w. */
+static uint8_t project(const job_t* job, GLfloat x, GLfloat y, GLfloat z,
+                       GLfloat w, GLfloat* s) {
+        const GLfloat* m = job->m;
+        GLfloat cx = m[0] * x + m[4] * y + m[8]  * z + m[12] * w;
+        GLfloat cy = m[1] * x + m[5] * y + m[9]  * z + m[13] * w;
+        GLfloat cz = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+        GLfloat cw = m[3] * x + m[7] * y + m[11] * z + m[15] * w;
+        uint8_t code = 0;
+
+        code |= cx < -cw ? OGLL_CLIP_LEFT : 0;
+        code |= cx > cw ? OGLL_CLIP_RIGHT : 0;
+        code |= cy < -cw ? OGLL_CLIP_BOTTOM : 0;
+        code |= cy > cw ? OGLL_CLIP_TOP : 0;
+        code |= cz < -cw ? OGLL_CLIP_NEAR : 0;
+        code |= cz > cw ? OGLL_CLIP_FAR : 0;
+
+        s[0] = job->vx + (cx / cw + 1) * job->hw;
+        s[1] = job->vy + (cy / cw + 1) * job->hh;
+        s[2] = job->vn + (cz / cw + 1) * job->hd;
+        s[3] = 1 / cw;
+
+        return code;
+}
+
+#ifdef OGLL_X86
+
+__attribute__((target("sse")))
+static __m128 sseRow(const GLfloat* m, size_t r, __m128 x, __m128 y,
+                     __m128 z, __m128 w) {
+        __m128 c;
+
+        c = _mm_mul_ps(_mm_set1_ps(m[r]), x);
+        c = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(m[4 + r]), y));
+        c = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(m[8 + r]), z));
+        c = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(m[12 + r]), w));
+
+        return c;
+}
+
+__attribute__((target("sse")))
+static __m128 sseWindow(__m128 c, __m128 cw, GLfloat offset, GLfloat half) {
+        __m128 ndc = _mm_add_ps(_mm_div_ps(c, cw), _mm_set1_ps(1));
+
+        return _mm_add_ps(_mm_set1_ps(offset), _mm_mul_ps(ndc, _mm_set1_ps(half)));
+}
+
+/* Four vertices per iteration, from `begin` while at least four are left.
+   Yields where it stopped. */
+__attribute__((target("sse")))
+static size_t sseRange(job_t* job, size_t begin, size_t end, size_t* inside) {
+        const soa_t* in = job->in;
+        soa_t* out = job->out;
+        const GLfloat* m = job->m;
+        size_t k, i;
+
+        for(k = begin; k + 4 <= end; k += 4) {
+                __m128 x = _mm_loadu_ps(in->x + k);
+                __m128 y = _mm_loadu_ps(in->y + k);
+                __m128 z = _mm_loadu_ps(in->z + k);
+                __m128 w = in->w ? _mm_loadu_ps(in->w + k) : _mm_set1_ps(1);
+                __m128 cx = sseRow(m, 0, x, y, z, w);
+                __m128 cy = sseRow(m, 1, x, y, z, w);
+                __m128 cz = sseRow(m, 2, x, y, z, w);
+                __m128 cw = sseRow(m, 3, x, y, z, w);
+                __m128 nw = _mm_sub_ps(_mm_setzero_ps(), cw);
+                int planes[6];
+
+                planes[0] = _mm_movemask_ps(_mm_cmplt_ps(cx, nw));
+                planes[1] = _mm_movemask_ps(_mm_cmpgt_ps(cx, cw));
+                planes[2] = _mm_movemask_ps(_mm_cmplt_ps(cy, nw));
+                planes[3] = _mm_movemask_ps(_mm_cmpgt_ps(cy, cw));
+                planes[4] = _mm_movemask_ps(_mm_cmplt_ps(cz, nw));
+                planes[5] = _mm_movemask_ps(_mm_cmpgt_ps(cz, cw));
+
+                for(i = 0; i < 4; i++) {
+                        uint8_t code = 0;
+                        size_t b;
+
+                        for(b = 0; b < 6; b++) {
+                                code |= ((planes[b] >> i) & 1) << b;
+                        }
+
+                        if(job->codes) {
+                                job->codes[k + i] = code;
+                        }
+                        *inside += code == 0;
+                }
+
+                _mm_storeu_ps(out->x + k, sseWindow(cx, cw, job->vx, job->hw));
+                _mm_storeu_ps(out->y + k, sseWindow(cy, cw, job->vy, job->hh));
+                _mm_storeu_ps(out->z + k, sseWindow(cz, cw, job->vn, job->hd));
+                if(out->w) {
+                        _mm_storeu_ps(out->w + k, _mm_div_ps(_mm_set1_ps(1), cw));
+                }
+        }
+
+        return k;
+}
+
+#endif
+
+static void pipelineRange(void* arg, size_t begin, size_t end) {
+        job_t* job = arg;
+        const soa_t* in = job->in;
+        soa_t* out = job->out;
+        size_t inside = 0;
+        size_t k = begin;
+        GLfloat s[4];
+
+#ifdef OGLL_X86
+        if(job->sse) {
+                k = sseRange(job, begin, end, &inside);
+        }
+#endif
+
+        for(; k < end; k++) {
+                uint8_t code = project(job, in->x[k], in->y[k], in->z[k],
+                                       in->w ? in->w[k] : 1, s);
+
+                if(job->codes) {
+                        job->codes[k] = code;
+                }
+                inside += code == 0;
+
+                out->x[k] = s[0];
+                out->y[k] = s[1];
+                out->z[k] = s[2];
+                if(out->w) {
+                        out->w[k] = s[3];
+                }
+        }
+
+        __atomic_fetch_add(&job->inside, inside, __ATOMIC_RELAXED);
+}
+
+// --- PIPELINES --- //
+
+/* A viewport with the default depth range */
+viewport_t ogllViewport(GLfloat x, GLfloat y, GLfloat width, GLfloat height) {
+        OGLL_PROBE();
+        viewport_t vp = { x, y, width, height, 0, 1 };
+
+        return vp;
+}
+
+/* Set up a pipeline from projection, view and model Matrices */
+pipeline_t* ogllPipelineInit(pipeline_t* p, matrix_t* proj, matrix_t* view,
+                             matrix_t* model, const viewport_t* vp) {
+        OGLL_PROBE();
+        mat4_t m;
+
+        check(p && proj && vp, "Null argument given.");
+        check(ogllMat4FromMatrix(&p->mvp, proj), "Bad projection Matrix.");
+
+        if(view) {
+                check(ogllMat4FromMatrix(&m, view), "Bad view Matrix.");
+                ogllMat4Multiply(&p->mvp, &m);
+        }
+
+        if(model) {
+                check(ogllMat4FromMatrix(&m, model), "Bad model Matrix.");
+                ogllMat4Multiply(&p->mvp, &m);
+        }
+
+        return ogllPipelineFromMat4(p, &p->mvp, vp);
+ error:
+        return NULL;
+}
+
+/* As above, from a finished model-view-projection Matrix */
+pipeline_t* ogllPipelineFromMat4(pipeline_t* p, const mat4_t* mvp,
+                                 const viewport_t* vp) {
+        OGLL_PROBE();
+        check(p && mvp && vp, "Null argument given.");
+        check(vp->width >= 0 && vp->height >= 0, "Negative viewport size.");
+
+        p->mvp = *mvp;
+        p->viewport = *vp;
+
+        return p;
+ error:
+        return NULL;
+}
+
+/* Run a single vertex through */
+uint8_t ogllPipelineVertex(const pipeline_t* p, vec4_t v, vec3_t* screen) {
+        OGLL_PROBE();
+        job_t job;
+        GLfloat s[4];
+        uint8_t code;
+
+        check(p && screen, "Null argument given.");
+
+        setup(&job, p);
+        code = project(&job, v.x, v.y, v.z, v.w, s);
+
+        screen->x = s[0];
+        screen->y = s[1];
+        screen->z = s[2];
+
+        return code;
+ error:
+        return OGLL_CLIP_LEFT | OGLL_CLIP_RIGHT | OGLL_CLIP_BOTTOM |
+                OGLL_CLIP_TOP | OGLL_CLIP_NEAR | OGLL_CLIP_FAR;
+}
+
+/* Run every vertex of `in` through */
+size_t ogllPipelineRun(const pipeline_t* p, const soa_t* in, soa_t* out,
+                       uint8_t* codes, pool_t* pool) {
+        OGLL_PROBE();
+        job_t job;
+
+        check(p && in && out, "Null argument given.");
+        check(in->count == out->count, "Streams aren't the same length.");
+
+        setup(&job, p);
+        job.in = in;
+        job.out = out;
+        job.codes = codes;
+        job.inside = 0;
+        job.sse = useSse();
+
+        ogllPoolFor(pool, in->count, PIPELINE_GRAIN, pipelineRange, &job);
+
+        return job.inside;
+ error:
+        return 0;
+}
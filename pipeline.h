@@ -0,0 +1,80 @@
+#ifndef __ogll_pipeline__
+#define __ogll_pipeline__
+
+#include <stdint.h>
+
+#include "opengl-linalg.h"
+#include "value.h"
+#include "soa.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The fixed-function end of a vertex shader, on the CPU.
+ *
+ * Each vertex goes through the model-view-projection Matrix, is classified
+ * against the clip volume -w <= x,y,z <= w, divided by w, and mapped to
+ * window coordinates the way `glViewport` and `glDepthRange` would. The
+ * window origin is the bottom left, as in GL.
+ *
+ * Vertices come in SoA streams and are done four per SSE instruction, in
+ * chunks spread over a `pool_t`. Results are bit-identical whichever
+ * SIMD backend is active and however many threads run.
+ */
+
+// --- //
+
+/* Clip codes. A vertex is inside the clip volume when its code is 0. */
+#define OGLL_CLIP_LEFT   0x01
+#define OGLL_CLIP_RIGHT  0x02
+#define OGLL_CLIP_BOTTOM 0x04
+#define OGLL_CLIP_TOP    0x08
+#define OGLL_CLIP_NEAR   0x10
+#define OGLL_CLIP_FAR    0x20
+
+typedef struct viewport_t {
+        GLfloat x, y;           // Bottom left corner, in pixels
+        GLfloat width, height;
+        GLfloat near, far;      // Depth range
+} viewport_t;
+
+typedef struct pipeline_t {
+        mat4_t mvp;
+        viewport_t viewport;
+} pipeline_t;
+
+/* A viewport at (x,y) with the default depth range of 0 to 1 */
+viewport_t ogllViewport(GLfloat x, GLfloat y, GLfloat width, GLfloat height);
+
+/* Set up a pipeline from 4x4 projection, view and model Matrices, as made
+   by `ogllMPerspectiveP` and `ogllM4LookAtP`. `view` and `model` may be
+   NULL for the identity. */
+pipeline_t* ogllPipelineInit(pipeline_t* p, matrix_t* proj, matrix_t* view,
+                             matrix_t* model, const viewport_t* vp);
+
+/* As above, from a finished model-view-projection Matrix */
+pipeline_t* ogllPipelineFromMat4(pipeline_t* p, const mat4_t* mvp,
+                                 const viewport_t* vp);
+
+/* Run a single vertex through. Writes window x, y and depth to `screen`
+   and yields its clip code, or every clip bit if it fails. */
+uint8_t ogllPipelineVertex(const pipeline_t* p, vec4_t v, vec3_t* screen);
+
+/* Run every vertex of `in` through, writing window x, y and depth to
+   `out`, and the clip code of each to `codes` (which may be NULL).
+   A 3-component `in` has w = 1. If `out` has 4 components, its w lane
+   gets 1/w, for perspective-correct interpolation. `out` may be `in`.
+   `pool` may be NULL to run on the calling thread only.
+
+   Only vertices with code 0 are guaranteed a finite position on screen.
+   Yields how many that is. */
+size_t ogllPipelineRun(const pipeline_t* p, const soa_t* in, soa_t* out,
+                       uint8_t* codes, pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
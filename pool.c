@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "pool.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+struct pool_t {
+        pthread_t* threads;
+        size_t count;           // Spawned workers. The caller makes one more.
+
+        pthread_mutex_t busy;   // Held for the whole of one `ogllPoolFor`
+        pthread_mutex_t lock;
+        pthread_cond_t wake;
+        pthread_cond_t done;
+
+        // The loop currently being run.
+        ogll_task_f task;
+        void* arg;
+        size_t total;
+        size_t grain;
+        size_t next;            // Next unclaimed element. Atomic.
+        size_t pending;         // Workers yet to finish this loop.
+        unsigned long generation;
+        bool quit;
+};
+
+/* Claim and run chunks until the loop is exhausted */
+static void runChunks(pool_t* p) {
+        size_t b;
+
+        for(;;) {
+                b = __atomic_fetch_add(&p->next, p->grain, __ATOMIC_RELAXED);
+
+                if(b >= p->total) {
+                        break;
+                }
+
+                p->task(p->arg, b, b + p->grain < p->total ?
+                        b + p->grain : p->total);
+        }
+}
+
+static void* worker(void* arg) {
+        pool_t* p = (pool_t*)arg;
+        unsigned long seen = 0;
+
+        pthread_mutex_lock(&p->lock);
+
+        for(;;) {
+                while(!p->quit && p->generation == seen) {
+                        pthread_cond_wait(&p->wake, &p->lock);
+                }
+
+                if(p->quit) {
+                        break;
+                }
+
+                seen = p->generation;
+                pthread_mutex_unlock(&p->lock);
+
+                runChunks(p);
+
+                pthread_mutex_lock(&p->lock);
+
+                if(--p->pending == 0) {
+                        pthread_cond_signal(&p->done);
+                }
+        }
+
+        pthread_mutex_unlock(&p->lock);
+
+        return NULL;
+}
+
+/* Create a pool of `threads` workers, counting the caller */
+pool_t* ogllPoolCreate(size_t threads) {
+        OGLL_PROBE();
+        pool_t* p = NULL;
+        size_t i;
+
+        if(threads == 0) {
+                long n = sysconf(_SC_NPROCESSORS_ONLN);
+                threads = n > 0 ? (size_t)n : 1;
+        }
+
+        p = calloc(1, sizeof(pool_t));
+        check_mem(p);
+
+        p->threads = calloc(threads, sizeof(pthread_t));
+        check_mem(p->threads);
+
+        pthread_mutex_init(&p->busy, NULL);
+        pthread_mutex_init(&p->lock, NULL);
+        pthread_cond_init(&p->wake, NULL);
+        pthread_cond_init(&p->done, NULL);
+
+        for(i = 0; i < threads - 1; i++) {
+                check(pthread_create(&p->threads[i], NULL, worker, p) == 0,
+                      "Failed to start worker %zu.", i);
+                p->count++;
+        }
+
+        return p;
+ error:
+        ogllPoolDestroy(p);
+        return NULL;
+}
+
+/* Stop and join every worker */
+void ogllPoolDestroy(pool_t* p) {
+        OGLL_PROBE();
+        size_t i;
+
+        if(p) {
+                pthread_mutex_lock(&p->lock);
+                p->quit = true;
+                pthread_cond_broadcast(&p->wake);
+                pthread_mutex_unlock(&p->lock);
+
+                for(i = 0; i < p->count; i++) {
+                        pthread_join(p->threads[i], NULL);
+                }
+
+                pthread_cond_destroy(&p->done);
+                pthread_cond_destroy(&p->wake);
+                pthread_mutex_destroy(&p->lock);
+                pthread_mutex_destroy(&p->busy);
+                free(p->threads);
+                free(p);
+        }
+}
+
+/* Number of threads that take part in a loop, counting the caller */
+size_t ogllPoolSize(pool_t* p) {
+        OGLL_PROBE();
+        return p ? p->count + 1 : 1;
+}
+
+/* Run `task` over [0,count) in chunks of `grain` elements */
+void ogllPoolFor(pool_t* p, size_t count, size_t grain,
+                 ogll_task_f task, void* arg) {
+        OGLL_PROBE();
+        if(count == 0) {
+                return;
+        }
+
+        if(grain == 0) {
+                grain = 1;
+        }
+
+        // Not worth waking anybody up.
+        if(!p || p->count == 0 || count <= grain) {
+                task(arg, 0, count);
+                return;
+        }
+
+        pthread_mutex_lock(&p->busy);
+
+        pthread_mutex_lock(&p->lock);
+        p->task = task;
+        p->arg = arg;
+        p->total = count;
+        p->grain = grain;
+        p->next = 0;
+        p->pending = p->count;
+        p->generation++;
+        pthread_cond_broadcast(&p->wake);
+        pthread_mutex_unlock(&p->lock);
+
+        runChunks(p);
+
+        pthread_mutex_lock(&p->lock);
+        while(p->pending > 0) {
+                pthread_cond_wait(&p->done, &p->lock);
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        pthread_mutex_unlock(&p->busy);
+}
@@ -0,0 +1,43 @@
+#ifndef __ogll_pool__
+#define __ogll_pool__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A fixed set of worker threads for data-parallel loops. The calling
+ * thread always takes part in the work, so a pool of size 1 spawns no
+ * threads at all. Passing a NULL pool to `ogllPoolFor` runs the loop
+ * serially on the caller, which every subsystem built on this accepts.
+ */
+
+// --- //
+
+typedef struct pool_t pool_t;
+
+/* Process elements [begin,end) of a loop */
+typedef void (*ogll_task_f)(void* arg, size_t begin, size_t end);
+
+/* Create a pool of `threads` workers, counting the caller.
+   0 means one per online CPU. */
+pool_t* ogllPoolCreate(size_t threads);
+
+/* Stop and join every worker */
+void ogllPoolDestroy(pool_t* p);
+
+/* Number of threads that take part in a loop, counting the caller */
+size_t ogllPoolSize(pool_t* p);
+
+/* Run `task` over [0,count) in chunks of `grain` elements, spread over
+   the pool. Blocks until every chunk is done. Calls from different
+   threads are serialized; calling it from inside a task deadlocks. */
+void ogllPoolFor(pool_t* p, size_t count, size_t grain,
+                 ogll_task_f task, void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
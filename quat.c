@@ -0,0 +1,280 @@
+#include <math.h>
+
+#include "quat.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+/* Above this |dot|, slerp falls back to nlerp to avoid dividing by sin(~0) */
+#define SLERP_EPSILON 0.9995
+
+/* The identity rotation */
+quat_t ogllQIdentity(void) {
+        OGLL_PROBE();
+        return ogllQMake(0,0,0,1);
+}
+
+/* Construct a Quaternion from its components */
+quat_t ogllQMake(GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+        OGLL_PROBE();
+        quat_t q = { x, y, z, w };
+        return q;
+}
+
+/* Rotation by `r` radians around the unit vector formed by `x` `y` `z` */
+quat_t ogllQFromAxisAngle(GLfloat r, GLfloat x, GLfloat y, GLfloat z) {
+        OGLL_PROBE();
+        GLfloat s = sin(r / 2);
+
+        return ogllQMake(x * s, y * s, z * s, cos(r / 2));
+}
+
+/* Hamilton product: the rotation `b` followed by `a` */
+quat_t ogllQMultiply(quat_t a, quat_t b) {
+        OGLL_PROBE();
+        return ogllQMake(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                         a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                         a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                         a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+/* The inverse rotation of a unit Quaternion */
+quat_t ogllQConjugate(quat_t q) {
+        OGLL_PROBE();
+        return ogllQMake(-q.x, -q.y, -q.z, q.w);
+}
+
+/* Yields the Dot Product of two Quaternions */
+GLfloat ogllQDot(quat_t a, quat_t b) {
+        OGLL_PROBE();
+        return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+/* Yields the Length/Magnitude of a Quaternion */
+GLfloat ogllQLength(quat_t q) {
+        OGLL_PROBE();
+        return sqrt(ogllQDot(q,q));
+}
+
+/* Scale to unit length */
+quat_t ogllQNormalize(quat_t q) {
+        OGLL_PROBE();
+        GLfloat len = ogllQLength(q);
+
+        if(len == 0) {
+                return ogllQIdentity();
+        }
+
+        return ogllQMake(q.x / len, q.y / len, q.z / len, q.w / len);
+}
+
+/* Normalized linear interpolation along the shorter arc */
+quat_t ogllQNlerp(quat_t a, quat_t b, GLfloat t) {
+        OGLL_PROBE();
+        GLfloat sb = ogllQDot(a,b) < 0 ? -t : t;
+        GLfloat sa = 1 - t;
+
+        return ogllQNormalize(ogllQMake(sa * a.x + sb * b.x,
+                                        sa * a.y + sb * b.y,
+                                        sa * a.z + sb * b.z,
+                                        sa * a.w + sb * b.w));
+}
+
+/* Spherical linear interpolation along the shorter arc */
+quat_t ogllQSlerp(quat_t a, quat_t b, GLfloat t) {
+        OGLL_PROBE();
+        GLfloat d = ogllQDot(a,b);
+        GLfloat sign = 1;
+        GLfloat theta, s, sa, sb;
+
+        if(d < 0) {
+                d = -d;
+                sign = -1;
+        }
+
+        if(d > SLERP_EPSILON) {
+                return ogllQNlerp(a,b,t);
+        }
+
+        theta = acos(d);
+        s = sin(theta);
+        sa = sin((1 - t) * theta) / s;
+        sb = sign * sin(t * theta) / s;
+
+        return ogllQMake(sa * a.x + sb * b.x,
+                         sa * a.y + sb * b.y,
+                         sa * a.z + sb * b.z,
+                         sa * a.w + sb * b.w);
+}
+
+/* Rotate a Vector: v + 2w(u x v) + 2u x (u x v), where u = q.xyz */
+vec3_t ogllQRotateV3(quat_t q, vec3_t v) {
+        OGLL_PROBE();
+        GLfloat tx = 2 * (q.y * v.z - q.z * v.y);
+        GLfloat ty = 2 * (q.z * v.x - q.x * v.z);
+        GLfloat tz = 2 * (q.x * v.y - q.y * v.x);
+
+        return ogllV3Make(v.x + q.w * tx + (q.y * tz - q.z * ty),
+                          v.y + q.w * ty + (q.z * tx - q.x * tz),
+                          v.z + q.w * tz + (q.x * ty - q.y * tx));
+}
+
+/* Fill 16 column-major floats with the rotation of `q` */
+static void toColumns(quat_t q, GLfloat* m) {
+        GLfloat xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        GLfloat xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        GLfloat wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+        // Column 1
+        m[0]  = 1 - 2 * (yy + zz);
+        m[1]  = 2 * (xy + wz);
+        m[2]  = 2 * (xz - wy);
+        m[3]  = 0;
+        // Column 2
+        m[4]  = 2 * (xy - wz);
+        m[5]  = 1 - 2 * (xx + zz);
+        m[6]  = 2 * (yz + wx);
+        m[7]  = 0;
+        // Column 3
+        m[8]  = 2 * (xz + wy);
+        m[9]  = 2 * (yz - wx);
+        m[10] = 1 - 2 * (xx + yy);
+        m[11] = 0;
+        // Column 4
+        m[12] = 0;
+        m[13] = 0;
+        m[14] = 0;
+        m[15] = 1;
+}
+
+/* Read a rotation back out of 16 column-major floats (Shepperd's method:
+   branch on the largest diagonal term to stay well-conditioned). */
+static quat_t fromColumns(const GLfloat* m) {
+        GLfloat trace = m[0] + m[5] + m[10];
+        GLfloat s;
+
+        if(trace > 0) {
+                s = 2 * sqrt(trace + 1);
+                return ogllQMake((m[6] - m[9]) / s, (m[8] - m[2]) / s,
+                                 (m[1] - m[4]) / s, s / 4);
+        } else if(m[0] > m[5] && m[0] > m[10]) {
+                s = 2 * sqrt(1 + m[0] - m[5] - m[10]);
+                return ogllQMake(s / 4, (m[4] + m[1]) / s,
+                                 (m[8] + m[2]) / s, (m[6] - m[9]) / s);
+        } else if(m[5] > m[10]) {
+                s = 2 * sqrt(1 + m[5] - m[0] - m[10]);
+                return ogllQMake((m[4] + m[1]) / s, s / 4,
+                                 (m[9] + m[6]) / s, (m[8] - m[2]) / s);
+        } else {
+                s = 2 * sqrt(1 + m[10] - m[0] - m[5]);
+                return ogllQMake((m[8] + m[2]) / s, (m[9] + m[6]) / s,
+                                 s / 4, (m[1] - m[4]) / s);
+        }
+}
+
+/* The rotation Matrix of a unit Quaternion */
+mat4_t* ogllQToMat4(quat_t q, mat4_t* dst) {
+        OGLL_PROBE();
+        check(dst, "Null Matrix given.");
+
+        toColumns(q, dst->m);
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Write the rotation Matrix of a unit Quaternion into a 4x4 `matrix_t` */
+matrix_t* ogllQToMatrix(quat_t q, matrix_t* dst) {
+        OGLL_PROBE();
+        check(dst, "Null Matrix given.");
+        check(dst->cols == 4 && dst->rows == 4, "Matrix not 4x4.");
+
+        toColumns(q, dst->m);
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* The rotation held in the upper 3x3 of a 4x4 Matrix */
+quat_t ogllQFromMat4(const mat4_t* m) {
+        OGLL_PROBE();
+        return fromColumns(m->m);
+}
+
+/* As above, for a 4x4 `matrix_t` */
+quat_t ogllQFromMatrix(matrix_t* m) {
+        OGLL_PROBE();
+        check(m, "Null Matrix given.");
+        check(m->cols == 4 && m->rows == 4, "Matrix not 4x4.");
+
+        return fromColumns(m->m);
+ error:
+        return ogllQIdentity();
+}
+
+// --- BATCHES --- //
+
+/* out[i] = a[i] * b[i] */
+void ogllQMultiplyN(quat_t* out, const quat_t* a, const quat_t* b, size_t n) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+                out[i] = ogllQMultiply(a[i], b[i]);
+        }
+}
+
+/* out[i] = a * b[i] */
+void ogllQMultiplyOneN(quat_t* out, quat_t a, const quat_t* b, size_t n) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+                out[i] = ogllQMultiply(a, b[i]);
+        }
+}
+
+/* Normalize `n` Quaternions in place */
+void ogllQNormalizeN(quat_t* q, size_t n) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+                q[i] = ogllQNormalize(q[i]);
+        }
+}
+
+/* out[i] = nlerp(a[i], b[i], t) */
+void ogllQNlerpN(quat_t* out, const quat_t* a, const quat_t* b,
+                 GLfloat t, size_t n) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+                out[i] = ogllQNlerp(a[i], b[i], t);
+        }
+}
+
+/* out[i] = slerp(a[i], b[i], t) */
+void ogllQSlerpN(quat_t* out, const quat_t* a, const quat_t* b,
+                 GLfloat t, size_t n) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+                out[i] = ogllQSlerp(a[i], b[i], t);
+        }
+}
+
+/* Rotation Matrices for `n` Quaternions */
+void ogllQToMat4N(mat4_t* out, const quat_t* q, size_t n) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+                toColumns(q[i], out[i].m);
+        }
+}
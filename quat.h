@@ -0,0 +1,99 @@
+#ifndef __ogll_quat__
+#define __ogll_quat__
+
+#include "opengl-linalg.h"
+#include "value.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Unit Quaternions for rotations. Composing two rotations costs 16
+ * multiplies instead of a 64-multiply 4x4 product, and they interpolate
+ * cleanly. Convert to a Matrix only when it's time to upload.
+ *
+ * Conventions follow `ogllM4Rotate`: `ogllQFromAxisAngle(r,x,y,z)` gives
+ * the same rotation as that function's Matrix, and `ogllQMultiply(a,b)`
+ * corresponds to the Matrix product a * b (b is applied first).
+ */
+
+// --- //
+
+typedef struct quat_t {
+        GLfloat x, y, z, w;
+} __attribute__((aligned(16))) quat_t;
+
+/* The identity rotation */
+quat_t ogllQIdentity(void);
+
+/* Construct a Quaternion from its components */
+quat_t ogllQMake(GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+/* Rotation by `r` radians around the unit vector formed by `x` `y` `z` */
+quat_t ogllQFromAxisAngle(GLfloat r, GLfloat x, GLfloat y, GLfloat z);
+
+/* Hamilton product: the rotation `b` followed by `a` */
+quat_t ogllQMultiply(quat_t a, quat_t b);
+
+/* The inverse rotation of a unit Quaternion */
+quat_t ogllQConjugate(quat_t q);
+
+/* Yields the Dot Product of two Quaternions */
+GLfloat ogllQDot(quat_t a, quat_t b);
+
+/* Yields the Length/Magnitude of a Quaternion */
+GLfloat ogllQLength(quat_t q);
+
+/* Scale to unit length. The zero Quaternion becomes the identity. */
+quat_t ogllQNormalize(quat_t q);
+
+/* Normalized linear interpolation along the shorter arc. Cheap, and
+   close to `ogllQSlerp` for nearby rotations. */
+quat_t ogllQNlerp(quat_t a, quat_t b, GLfloat t);
+
+/* Spherical linear interpolation along the shorter arc */
+quat_t ogllQSlerp(quat_t a, quat_t b, GLfloat t);
+
+/* Rotate a Vector */
+vec3_t ogllQRotateV3(quat_t q, vec3_t v);
+
+/* The rotation Matrix of a unit Quaternion. Overwrites all of `dst`. */
+mat4_t* ogllQToMat4(quat_t q, mat4_t* dst);
+
+/* Write the rotation Matrix of a unit Quaternion into a 4x4 `matrix_t` */
+matrix_t* ogllQToMatrix(quat_t q, matrix_t* dst);
+
+/* The rotation held in the upper 3x3 of a 4x4 Matrix. The Matrix must be
+   a pure rotation (orthonormal, no scale). */
+quat_t ogllQFromMat4(const mat4_t* m);
+
+/* As above, for a 4x4 `matrix_t`. Yields the identity if `m` isn't 4x4. */
+quat_t ogllQFromMatrix(matrix_t* m);
+
+// --- BATCHES --- //
+
+/* out[i] = a[i] * b[i]. `out` may be `a` or `b`. */
+void ogllQMultiplyN(quat_t* out, const quat_t* a, const quat_t* b, size_t n);
+
+/* out[i] = a * b[i], e.g. to rotate many children by one parent */
+void ogllQMultiplyOneN(quat_t* out, quat_t a, const quat_t* b, size_t n);
+
+/* Normalize `n` Quaternions in place */
+void ogllQNormalizeN(quat_t* q, size_t n);
+
+/* out[i] = nlerp(a[i], b[i], t) */
+void ogllQNlerpN(quat_t* out, const quat_t* a, const quat_t* b,
+                 GLfloat t, size_t n);
+
+/* out[i] = slerp(a[i], b[i], t) */
+void ogllQSlerpN(quat_t* out, const quat_t* a, const quat_t* b,
+                 GLfloat t, size_t n);
+
+/* Rotation Matrices for `n` Quaternions, e.g. one upload's worth */
+void ogllQToMat4N(mat4_t* out, const quat_t* q, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "scene.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+/* Nodes per chunk handed to a worker */
+#define SCENE_GRAIN 256
+
+typedef struct level_t {
+        scene_t* s;
+        const size_t* nodes;
+} level_t;
+
+/* Reallocate every per-node array to hold `capacity` nodes */
+static bool grow(scene_t* s, size_t capacity) {
+        size_t* parent = NULL;
+        size_t* depth = NULL;
+        mat4_t* local = NULL;
+        mat4_t* world = NULL;
+        unsigned char* dirty = NULL;
+        size_t* order = NULL;
+        size_t* work = NULL;
+
+        parent = realloc(s->parent, capacity * sizeof(size_t));
+        check_mem(parent);
+        s->parent = parent;
+
+        depth = realloc(s->depth, capacity * sizeof(size_t));
+        check_mem(depth);
+        s->depth = depth;
+
+        local = realloc(s->local, capacity * sizeof(mat4_t));
+        check_mem(local);
+        s->local = local;
+
+        world = realloc(s->world, capacity * sizeof(mat4_t));
+        check_mem(world);
+        s->world = world;
+
+        dirty = realloc(s->dirty, capacity);
+        check_mem(dirty);
+        s->dirty = dirty;
+
+        order = realloc(s->order, capacity * sizeof(size_t));
+        check_mem(order);
+        s->order = order;
+
+        work = realloc(s->work, capacity * sizeof(size_t));
+        check_mem(work);
+        s->work = work;
+
+        s->capacity = capacity;
+
+        return true;
+ error:
+        return false;
+}
+
+/* Counting-sort the nodes by depth */
+static bool buildLevels(scene_t* s) {
+        size_t* starts = NULL;
+        size_t* works = NULL;
+        size_t levels = 0;
+        size_t i;
+
+        for(i = 0; i < s->count; i++) {
+                if(s->depth[i] + 1 > levels) {
+                        levels = s->depth[i] + 1;
+                }
+        }
+
+        starts = realloc(s->levelStart, (levels + 1) * sizeof(size_t));
+        check_mem(starts);
+        s->levelStart = starts;
+
+        works = realloc(s->workStart, (levels + 1) * sizeof(size_t));
+        check_mem(works);
+        s->workStart = works;
+
+        memset(starts, 0, (levels + 1) * sizeof(size_t));
+
+        for(i = 0; i < s->count; i++) {
+                starts[s->depth[i] + 1]++;
+        }
+
+        for(i = 0; i < levels; i++) {
+                starts[i + 1] += starts[i];
+        }
+
+        // `works` doubles as the fill cursor for each level.
+        memcpy(works, starts, (levels + 1) * sizeof(size_t));
+
+        for(i = 0; i < s->count; i++) {
+                s->order[works[s->depth[i]]++] = i;
+        }
+
+        s->levels = levels;
+        s->levelsStale = false;
+
+        return true;
+ error:
+        return false;
+}
+
+/* world = parent world * local, for one chunk of one level */
+static void updateNodes(void* arg, size_t begin, size_t end) {
+        level_t* l = (level_t*)arg;
+        scene_t* s = l->s;
+        size_t i, n, p;
+
+        for(i = begin; i < end; i++) {
+                n = l->nodes[i];
+                p = s->parent[n];
+
+                if(p == OGLL_NO_PARENT) {
+                        s->world[n] = s->local[n];
+                } else {
+                        ogllSimdM4Multiply(s->world[n].m,
+                                           s->world[p].m, s->local[n].m);
+                }
+        }
+}
+
+/* Create an empty Scene with room for `capacity` nodes */
+scene_t* ogllSceneCreate(size_t capacity) {
+        OGLL_PROBE();
+        scene_t* s = NULL;
+
+        s = calloc(1, sizeof(scene_t));
+        check_mem(s);
+
+        check(grow(s, capacity > 0 ? capacity : 16), "Scene allocation failed.");
+        s->levelsStale = true;
+
+        return s;
+ error:
+        ogllSceneDestroy(s);
+        return NULL;
+}
+
+/* Deallocate a Scene */
+void ogllSceneDestroy(scene_t* s) {
+        OGLL_PROBE();
+        if(s) {
+                free(s->parent);
+                free(s->depth);
+                free(s->local);
+                free(s->world);
+                free(s->dirty);
+                free(s->order);
+                free(s->levelStart);
+                free(s->work);
+                free(s->workStart);
+                free(s);
+        }
+}
+
+/* Add a node under `parent` with the given local transform */
+size_t ogllSceneAdd(scene_t* s, size_t parent, const mat4_t* local) {
+        OGLL_PROBE();
+        size_t n;
+
+        check(s, "Null Scene given.");
+        check(parent == OGLL_NO_PARENT || parent < s->count,
+              "Parent %zu doesn't exist yet.", parent);
+
+        if(s->count == s->capacity) {
+                check(grow(s, s->capacity * 2), "Scene allocation failed.");
+        }
+
+        n = s->count++;
+
+        s->parent[n] = parent;
+        s->depth[n] = parent == OGLL_NO_PARENT ? 0 : s->depth[parent] + 1;
+        s->local[n] = local ? *local : ogllMat4Identity();
+        s->world[n] = ogllMat4Identity();
+        s->dirty[n] = 1;
+        s->levelsStale = true;
+
+        return n;
+ error:
+        return OGLL_NO_PARENT;
+}
+
+/* Replace a node's local transform and mark it dirty */
+void ogllSceneSetLocal(scene_t* s, size_t node, const mat4_t* local) {
+        OGLL_PROBE();
+        if(s && local && node < s->count) {
+                s->local[node] = *local;
+                s->dirty[node] = 1;
+        }
+}
+
+/* Writable local transform of a node */
+mat4_t* ogllSceneLocal(scene_t* s, size_t node) {
+        OGLL_PROBE();
+        check(s && node < s->count, "Node %zu doesn't exist.", node);
+
+        return &s->local[node];
+ error:
+        return NULL;
+}
+
+/* Flag a node so its subtree is recomputed on the next update */
+void ogllSceneMarkDirty(scene_t* s, size_t node) {
+        OGLL_PROBE();
+        if(s && node < s->count) {
+                s->dirty[node] = 1;
+        }
+}
+
+/* World transform of a node, as of the last update */
+const mat4_t* ogllSceneWorld(scene_t* s, size_t node) {
+        OGLL_PROBE();
+        check(s && node < s->count, "Node %zu doesn't exist.", node);
+
+        return &s->world[node];
+ error:
+        return NULL;
+}
+
+/* Recompute the world transforms of every dirty subtree */
+void ogllSceneUpdate(scene_t* s, pool_t* pool) {
+        OGLL_PROBE();
+        level_t l;
+        size_t i, d, w;
+
+        check(s, "Null Scene given.");
+
+        if(s->levelsStale) {
+                check(buildLevels(s), "Failed to sort Scene by depth.");
+        }
+
+        // Parents come first, so one pass pushes dirtiness down to leaves.
+        for(i = 0; i < s->count; i++) {
+                if(s->parent[i] != OGLL_NO_PARENT && s->dirty[s->parent[i]]) {
+                        s->dirty[i] = 1;
+                }
+        }
+
+        // Gather the dirty nodes of each level.
+        for(d = 0, w = 0; d < s->levels; d++) {
+                s->workStart[d] = w;
+
+                for(i = s->levelStart[d]; i < s->levelStart[d + 1]; i++) {
+                        if(s->dirty[s->order[i]]) {
+                                s->work[w++] = s->order[i];
+                        }
+                }
+        }
+        s->workStart[s->levels] = w;
+
+        // A level only reads the one above it, which is already final.
+        l.s = s;
+        for(d = 0; d < s->levels; d++) {
+                l.nodes = s->work + s->workStart[d];
+                ogllPoolFor(pool, s->workStart[d + 1] - s->workStart[d],
+                            SCENE_GRAIN, updateNodes, &l);
+        }
+
+        memset(s->dirty, 0, s->count);
+
+ error:
+        return;
+}
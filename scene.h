@@ -0,0 +1,79 @@
+#ifndef __ogll_scene__
+#define __ogll_scene__
+
+#include <stdbool.h>
+
+#include "value.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A transform hierarchy stored as flat arrays. Nodes are numbered in the
+ * order they're added and a parent must be added before its children, so
+ * `parent[i] < i` always holds. `ogllSceneUpdate` recomputes
+ * `world = parent world * local` for every node whose local transform, or
+ * that of an ancestor, changed since the last update. Each depth level is
+ * one parallel loop over the pool.
+ */
+
+// --- //
+
+#define OGLL_NO_PARENT ((size_t)-1)
+
+typedef struct scene_t {
+        size_t count;
+        size_t capacity;
+
+        size_t* parent;         // OGLL_NO_PARENT for roots
+        size_t* depth;
+        mat4_t* local;
+        mat4_t* world;
+        unsigned char* dirty;
+
+        // Nodes grouped by depth. Rebuilt lazily after nodes are added.
+        size_t levels;
+        size_t* order;
+        size_t* levelStart;     // `levels + 1` entries
+        bool levelsStale;
+
+        // Per-update scratch: the dirty subset of `order`.
+        size_t* work;
+        size_t* workStart;
+} scene_t;
+
+/* Create an empty Scene with room for `capacity` nodes. It grows as
+   needed. */
+scene_t* ogllSceneCreate(size_t capacity);
+
+/* Deallocate a Scene */
+void ogllSceneDestroy(scene_t* s);
+
+/* Add a node under `parent` (or OGLL_NO_PARENT for a root) with the given
+   local transform, NULL meaning identity. Returns the new node's index,
+   or OGLL_NO_PARENT on failure. */
+size_t ogllSceneAdd(scene_t* s, size_t parent, const mat4_t* local);
+
+/* Replace a node's local transform and mark it dirty */
+void ogllSceneSetLocal(scene_t* s, size_t node, const mat4_t* local);
+
+/* Writable local transform of a node. Call `ogllSceneMarkDirty` after
+   changing it. */
+mat4_t* ogllSceneLocal(scene_t* s, size_t node);
+
+/* Flag a node so its subtree is recomputed on the next update */
+void ogllSceneMarkDirty(scene_t* s, size_t node);
+
+/* World transform of a node, as of the last update */
+const mat4_t* ogllSceneWorld(scene_t* s, size_t node);
+
+/* Recompute the world transforms of every dirty subtree. `pool` may be
+   NULL to run on the calling thread only. */
+void ogllSceneUpdate(scene_t* s, pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
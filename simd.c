@@ -0,0 +1,755 @@
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OGLL_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define OGLL_NEON
+#include <arm_neon.h>
+#endif
+
+// --- //
+
+typedef void (*m4mul_f)(GLfloat*, const GLfloat*, const GLfloat*);
+typedef void (*m4vec_f)(GLfloat*, const GLfloat*, const GLfloat*);
+
+typedef void (*m4vecN_f)(GLfloat*, const GLfloat*, const GLfloat*,
+                         size_t, size_t, size_t);
+
+typedef bool (*m4inv_f)(GLfloat*, const GLfloat*);
+
+typedef void (*dm4mul_f)(GLdouble*, const GLdouble*, const GLdouble*);
+typedef void (*dm4vec_f)(GLdouble*, const GLdouble*, const GLdouble*);
+
+typedef struct kernels_t {
+        ogll_simd_t kind;
+        m4mul_f multiply;
+        m4vec_f transform;
+        m4vecN_f transformN;
+        m4inv_f inverse;
+        dm4mul_f dmultiply;
+        dm4vec_f dtransform;
+} kernels_t;
+
+// --- SCALAR --- //
+
+static void scalarMultiply(GLfloat* out, const GLfloat* a, const GLfloat* b) {
+        GLfloat fs[16];
+        size_t i,j,k;
+
+        for(i = 0; i < 4; i++) {
+                for(j = 0; j < 4; j++) {
+                        fs[j * 4 + i] = 0;
+
+                        for(k = 0; k < 4; k++) {
+                                fs[j * 4 + i] += a[k * 4 + i] * b[j * 4 + k];
+                        }
+                }
+        }
+
+        for(i = 0; i < 16; i++) {
+                out[i] = fs[i];
+        }
+}
+
+static void scalarTransform(GLfloat* out, const GLfloat* m, const GLfloat* v) {
+        GLfloat fs[4];
+        size_t i,k;
+
+        for(i = 0; i < 4; i++) {
+                fs[i] = 0;
+
+                for(k = 0; k < 4; k++) {
+                        fs[i] += m[k * 4 + i] * v[k];
+                }
+        }
+
+        for(i = 0; i < 4; i++) {
+                out[i] = fs[i];
+        }
+}
+
+static void scalarTransformN(GLfloat* out, const GLfloat* m, const GLfloat* in,
+                             size_t count, size_t comps, size_t stride) {
+        GLfloat v[4] = { 0,0,0,1 };
+        size_t p,i;
+
+        for(p = 0; p < count; p++) {
+                for(i = 0; i < comps; i++) {
+                        v[i] = in[p * stride + i];
+                }
+
+                scalarTransform(v,m,v);
+
+                for(i = 0; i < comps; i++) {
+                        out[p * stride + i] = v[i];
+                }
+
+                v[3] = 1;
+        }
+}
+
+/* Cofactor expansion through the twelve 2x2 sub-determinants of the top
+   and bottom row pairs. Written for row-major input, but since
+   inverse(transpose(M)) = transpose(inverse(M)) it's just as correct for
+   column-major data. */
+static bool scalarInverse(GLfloat* out, const GLfloat* a) {
+        GLfloat s0 = a[0] * a[5] - a[4] * a[1];
+        GLfloat s1 = a[0] * a[6] - a[4] * a[2];
+        GLfloat s2 = a[0] * a[7] - a[4] * a[3];
+        GLfloat s3 = a[1] * a[6] - a[5] * a[2];
+        GLfloat s4 = a[1] * a[7] - a[5] * a[3];
+        GLfloat s5 = a[2] * a[7] - a[6] * a[3];
+        GLfloat c5 = a[10] * a[15] - a[14] * a[11];
+        GLfloat c4 = a[9]  * a[15] - a[13] * a[11];
+        GLfloat c3 = a[9]  * a[14] - a[13] * a[10];
+        GLfloat c2 = a[8]  * a[15] - a[12] * a[11];
+        GLfloat c1 = a[8]  * a[14] - a[12] * a[10];
+        GLfloat c0 = a[8]  * a[13] - a[12] * a[9];
+        GLfloat det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        GLfloat fs[16];
+        GLfloat inv;
+        size_t i;
+
+        if(det == 0) {
+                return false;
+        }
+
+        inv = 1 / det;
+
+        fs[0]  = ( a[5]  * c5 - a[6]  * c4 + a[7]  * c3) * inv;
+        fs[1]  = (-a[1]  * c5 + a[2]  * c4 - a[3]  * c3) * inv;
+        fs[2]  = ( a[13] * s5 - a[14] * s4 + a[15] * s3) * inv;
+        fs[3]  = (-a[9]  * s5 + a[10] * s4 - a[11] * s3) * inv;
+        fs[4]  = (-a[4]  * c5 + a[6]  * c2 - a[7]  * c1) * inv;
+        fs[5]  = ( a[0]  * c5 - a[2]  * c2 + a[3]  * c1) * inv;
+        fs[6]  = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * inv;
+        fs[7]  = ( a[8]  * s5 - a[10] * s2 + a[11] * s1) * inv;
+        fs[8]  = ( a[4]  * c4 - a[5]  * c2 + a[7]  * c0) * inv;
+        fs[9]  = (-a[0]  * c4 + a[1]  * c2 - a[3]  * c0) * inv;
+        fs[10] = ( a[12] * s4 - a[13] * s2 + a[15] * s0) * inv;
+        fs[11] = (-a[8]  * s4 + a[9]  * s2 - a[11] * s0) * inv;
+        fs[12] = (-a[4]  * c3 + a[5]  * c1 - a[6]  * c0) * inv;
+        fs[13] = ( a[0]  * c3 - a[1]  * c1 + a[2]  * c0) * inv;
+        fs[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * inv;
+        fs[15] = ( a[8]  * s3 - a[9]  * s1 + a[10] * s0) * inv;
+
+        for(i = 0; i < 16; i++) {
+                out[i] = fs[i];
+        }
+
+        return true;
+}
+
+static void scalarDMultiply(GLdouble* out, const GLdouble* a, const GLdouble* b) {
+        GLdouble ds[16];
+        size_t i,j,k;
+
+        for(i = 0; i < 4; i++) {
+                for(j = 0; j < 4; j++) {
+                        ds[j * 4 + i] = 0;
+
+                        for(k = 0; k < 4; k++) {
+                                ds[j * 4 + i] += a[k * 4 + i] * b[j * 4 + k];
+                        }
+                }
+        }
+
+        for(i = 0; i < 16; i++) {
+                out[i] = ds[i];
+        }
+}
+
+static void scalarDTransform(GLdouble* out, const GLdouble* m, const GLdouble* v) {
+        GLdouble ds[4];
+        size_t i,k;
+
+        for(i = 0; i < 4; i++) {
+                ds[i] = 0;
+
+                for(k = 0; k < 4; k++) {
+                        ds[i] += m[k * 4 + i] * v[k];
+                }
+        }
+
+        for(i = 0; i < 4; i++) {
+                out[i] = ds[i];
+        }
+}
+
+// --- SSE / AVX --- //
+
+#ifdef OGLL_X86
+
+/* Each output column is a linear combination of the columns of `a`.
+   All of `a` is loaded before anything is stored, so `out == a` is safe,
+   and column j of `b` is read before column j of `out` is written. */
+__attribute__((target("sse")))
+static void sseMultiply(GLfloat* out, const GLfloat* a, const GLfloat* b) {
+        __m128 c0 = _mm_loadu_ps(a);
+        __m128 c1 = _mm_loadu_ps(a + 4);
+        __m128 c2 = _mm_loadu_ps(a + 8);
+        __m128 c3 = _mm_loadu_ps(a + 12);
+        size_t j;
+
+        for(j = 0; j < 4; j++) {
+                __m128 bj = _mm_loadu_ps(b + 4 * j);
+                __m128 r;
+
+                r = _mm_mul_ps(c0, _mm_shuffle_ps(bj,bj,_MM_SHUFFLE(0,0,0,0)));
+                r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(bj,bj,_MM_SHUFFLE(1,1,1,1))));
+                r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(bj,bj,_MM_SHUFFLE(2,2,2,2))));
+                r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_shuffle_ps(bj,bj,_MM_SHUFFLE(3,3,3,3))));
+
+                _mm_storeu_ps(out + 4 * j, r);
+        }
+}
+
+__attribute__((target("sse")))
+static void sseTransform(GLfloat* out, const GLfloat* m, const GLfloat* v) {
+        __m128 vv = _mm_loadu_ps(v);
+        __m128 r;
+
+        r = _mm_mul_ps(_mm_loadu_ps(m), _mm_shuffle_ps(vv,vv,_MM_SHUFFLE(0,0,0,0)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_shuffle_ps(vv,vv,_MM_SHUFFLE(1,1,1,1))));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_shuffle_ps(vv,vv,_MM_SHUFFLE(2,2,2,2))));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_shuffle_ps(vv,vv,_MM_SHUFFLE(3,3,3,3))));
+
+        _mm_storeu_ps(out, r);
+}
+
+/* Column 3 of `m` is loaded once for the whole batch. For xyz points the
+   implicit w is 1, so `c3` is added as-is (c3 * 1 is exact). */
+__attribute__((target("sse")))
+static void sseTransformN(GLfloat* out, const GLfloat* m, const GLfloat* in,
+                          size_t count, size_t comps, size_t stride) {
+        __m128 c0 = _mm_loadu_ps(m);
+        __m128 c1 = _mm_loadu_ps(m + 4);
+        __m128 c2 = _mm_loadu_ps(m + 8);
+        __m128 c3 = _mm_loadu_ps(m + 12);
+        size_t p;
+
+        if(comps == 4) {
+                for(p = 0; p < count; p++) {
+                        const GLfloat* v = in + p * stride;
+                        __m128 r;
+
+                        r = _mm_mul_ps(c0, _mm_set1_ps(v[0]));
+                        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+                        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+                        r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(v[3])));
+
+                        _mm_storeu_ps(out + p * stride, r);
+                }
+        } else {
+                for(p = 0; p < count; p++) {
+                        const GLfloat* v = in + p * stride;
+                        GLfloat* o = out + p * stride;
+                        __m128 r;
+
+                        r = _mm_mul_ps(c0, _mm_set1_ps(v[0]));
+                        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+                        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+                        r = _mm_add_ps(r, c3);
+
+                        // Only xyz is written back; o[3] may be the next point.
+                        _mm_storel_pi((__m64*)o, r);
+                        _mm_store_ss(o + 2, _mm_movehl_ps(r,r));
+                }
+        }
+}
+
+/* 2x2 blocks are held as one register (x y / z w, row-major). */
+#define SWZ(v,x,y,z,w)    _mm_shuffle_ps(v,v,_MM_SHUFFLE(w,z,y,x))
+#define SHUF(a,b,x,y,z,w) _mm_shuffle_ps(a,b,_MM_SHUFFLE(w,z,y,x))
+
+/* a * b */
+__attribute__((target("sse")))
+static inline __m128 mat2Mul(__m128 a, __m128 b) {
+        return _mm_add_ps(_mm_mul_ps(a, SWZ(b,0,3,0,3)),
+                          _mm_mul_ps(SWZ(a,1,0,3,2), SWZ(b,2,1,2,1)));
+}
+
+/* adj(a) * b */
+__attribute__((target("sse")))
+static inline __m128 mat2AdjMul(__m128 a, __m128 b) {
+        return _mm_sub_ps(_mm_mul_ps(SWZ(a,3,3,0,0), b),
+                          _mm_mul_ps(SWZ(a,1,1,2,2), SWZ(b,2,3,0,1)));
+}
+
+/* a * adj(b) */
+__attribute__((target("sse")))
+static inline __m128 mat2MulAdj(__m128 a, __m128 b) {
+        return _mm_sub_ps(_mm_mul_ps(a, SWZ(b,3,0,3,0)),
+                          _mm_mul_ps(SWZ(a,1,0,3,2), SWZ(b,2,1,2,1)));
+}
+
+/* Block inverse: split into 2x2 blocks A B / C D and build each block of
+   the adjugate from 2x2 products. Like `scalarInverse` it's written for
+   row-major data and is equally valid for column-major. Agrees with the
+   scalar kernel to a few ULP, not bit-for-bit. */
+__attribute__((target("sse")))
+static bool sseInverse(GLfloat* out, const GLfloat* m) {
+        __m128 r0 = _mm_loadu_ps(m);
+        __m128 r1 = _mm_loadu_ps(m + 4);
+        __m128 r2 = _mm_loadu_ps(m + 8);
+        __m128 r3 = _mm_loadu_ps(m + 12);
+        __m128 A = _mm_movelh_ps(r0, r1);
+        __m128 B = _mm_movehl_ps(r1, r0);
+        __m128 C = _mm_movelh_ps(r2, r3);
+        __m128 D = _mm_movehl_ps(r3, r2);
+        __m128 dets, detA, detB, detC, detD, detM, tr;
+        __m128 DC, AB, X, Y, Z, W;
+
+        // |A| |B| |C| |D|
+        dets = _mm_sub_ps(_mm_mul_ps(SHUF(r0,r2,0,2,0,2), SHUF(r1,r3,1,3,1,3)),
+                          _mm_mul_ps(SHUF(r0,r2,1,3,1,3), SHUF(r1,r3,0,2,0,2)));
+        detA = SWZ(dets,0,0,0,0);
+        detB = SWZ(dets,1,1,1,1);
+        detC = SWZ(dets,2,2,2,2);
+        detD = SWZ(dets,3,3,3,3);
+
+        DC = mat2AdjMul(D, C);
+        AB = mat2AdjMul(A, B);
+        X = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, DC));
+        W = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, AB));
+        Y = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, AB));
+        Z = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, DC));
+
+        // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+        tr = _mm_mul_ps(AB, SWZ(DC,0,2,1,3));
+        tr = _mm_add_ps(tr, SWZ(tr,1,0,3,2));
+        tr = _mm_add_ps(tr, SWZ(tr,2,3,0,1));
+        detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD),
+                                     _mm_mul_ps(detB, detC)), tr);
+
+        if(_mm_cvtss_f32(detM) == 0) {
+                return false;
+        }
+
+        detM = _mm_div_ps(_mm_setr_ps(1,-1,-1,1), detM);
+        X = _mm_mul_ps(X, detM);
+        Y = _mm_mul_ps(Y, detM);
+        Z = _mm_mul_ps(Z, detM);
+        W = _mm_mul_ps(W, detM);
+
+        // Adjugate each block and interleave them back into rows.
+        _mm_storeu_ps(out,      SHUF(X,Y,3,1,3,1));
+        _mm_storeu_ps(out + 4,  SHUF(X,Y,2,0,2,0));
+        _mm_storeu_ps(out + 8,  SHUF(Z,W,3,1,3,1));
+        _mm_storeu_ps(out + 12, SHUF(Z,W,2,0,2,0));
+
+        return true;
+}
+
+#undef SWZ
+#undef SHUF
+
+/* Two output columns per iteration. Both halves of `ck` hold column k of
+   `a`; the in-lane permute broadcasts b[j][k] and b[j+1][k]. */
+__attribute__((target("avx")))
+static void avxMultiply(GLfloat* out, const GLfloat* a, const GLfloat* b) {
+        __m256 c0 = _mm256_broadcast_ps((const __m128*)a);
+        __m256 c1 = _mm256_broadcast_ps((const __m128*)(a + 4));
+        __m256 c2 = _mm256_broadcast_ps((const __m128*)(a + 8));
+        __m256 c3 = _mm256_broadcast_ps((const __m128*)(a + 12));
+        __m256 b01 = _mm256_loadu_ps(b);
+        __m256 b23 = _mm256_loadu_ps(b + 8);
+        __m256 r01, r23;
+
+        r01 = _mm256_mul_ps(c0, _mm256_permute_ps(b01, _MM_SHUFFLE(0,0,0,0)));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(c1, _mm256_permute_ps(b01, _MM_SHUFFLE(1,1,1,1))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(c2, _mm256_permute_ps(b01, _MM_SHUFFLE(2,2,2,2))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(c3, _mm256_permute_ps(b01, _MM_SHUFFLE(3,3,3,3))));
+
+        r23 = _mm256_mul_ps(c0, _mm256_permute_ps(b23, _MM_SHUFFLE(0,0,0,0)));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(c1, _mm256_permute_ps(b23, _MM_SHUFFLE(1,1,1,1))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(c2, _mm256_permute_ps(b23, _MM_SHUFFLE(2,2,2,2))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(c3, _mm256_permute_ps(b23, _MM_SHUFFLE(3,3,3,3))));
+
+        _mm256_storeu_ps(out, r01);
+        _mm256_storeu_ps(out + 8, r23);
+}
+
+/* Doubles take two registers per column; each half is done as in
+   `sseMultiply`. */
+__attribute__((target("sse2")))
+static void sseDMultiply(GLdouble* out, const GLdouble* a, const GLdouble* b) {
+        __m128d c0l = _mm_loadu_pd(a),      c0h = _mm_loadu_pd(a + 2);
+        __m128d c1l = _mm_loadu_pd(a + 4),  c1h = _mm_loadu_pd(a + 6);
+        __m128d c2l = _mm_loadu_pd(a + 8),  c2h = _mm_loadu_pd(a + 10);
+        __m128d c3l = _mm_loadu_pd(a + 12), c3h = _mm_loadu_pd(a + 14);
+        size_t j;
+
+        for(j = 0; j < 4; j++) {
+                __m128d b0 = _mm_set1_pd(b[4 * j]);
+                __m128d b1 = _mm_set1_pd(b[4 * j + 1]);
+                __m128d b2 = _mm_set1_pd(b[4 * j + 2]);
+                __m128d b3 = _mm_set1_pd(b[4 * j + 3]);
+                __m128d lo, hi;
+
+                lo = _mm_mul_pd(c0l, b0);
+                lo = _mm_add_pd(lo, _mm_mul_pd(c1l, b1));
+                lo = _mm_add_pd(lo, _mm_mul_pd(c2l, b2));
+                lo = _mm_add_pd(lo, _mm_mul_pd(c3l, b3));
+
+                hi = _mm_mul_pd(c0h, b0);
+                hi = _mm_add_pd(hi, _mm_mul_pd(c1h, b1));
+                hi = _mm_add_pd(hi, _mm_mul_pd(c2h, b2));
+                hi = _mm_add_pd(hi, _mm_mul_pd(c3h, b3));
+
+                _mm_storeu_pd(out + 4 * j, lo);
+                _mm_storeu_pd(out + 4 * j + 2, hi);
+        }
+}
+
+__attribute__((target("sse2")))
+static void sseDTransform(GLdouble* out, const GLdouble* m, const GLdouble* v) {
+        __m128d v0 = _mm_set1_pd(v[0]);
+        __m128d v1 = _mm_set1_pd(v[1]);
+        __m128d v2 = _mm_set1_pd(v[2]);
+        __m128d v3 = _mm_set1_pd(v[3]);
+        __m128d lo, hi;
+
+        lo = _mm_mul_pd(_mm_loadu_pd(m), v0);
+        lo = _mm_add_pd(lo, _mm_mul_pd(_mm_loadu_pd(m + 4), v1));
+        lo = _mm_add_pd(lo, _mm_mul_pd(_mm_loadu_pd(m + 8), v2));
+        lo = _mm_add_pd(lo, _mm_mul_pd(_mm_loadu_pd(m + 12), v3));
+
+        hi = _mm_mul_pd(_mm_loadu_pd(m + 2), v0);
+        hi = _mm_add_pd(hi, _mm_mul_pd(_mm_loadu_pd(m + 6), v1));
+        hi = _mm_add_pd(hi, _mm_mul_pd(_mm_loadu_pd(m + 10), v2));
+        hi = _mm_add_pd(hi, _mm_mul_pd(_mm_loadu_pd(m + 14), v3));
+
+        _mm_storeu_pd(out, lo);
+        _mm_storeu_pd(out + 2, hi);
+}
+
+/* One double column fills a whole register, so this is `sseMultiply`
+   at twice the width. */
+__attribute__((target("avx")))
+static void avxDMultiply(GLdouble* out, const GLdouble* a, const GLdouble* b) {
+        __m256d c0 = _mm256_loadu_pd(a);
+        __m256d c1 = _mm256_loadu_pd(a + 4);
+        __m256d c2 = _mm256_loadu_pd(a + 8);
+        __m256d c3 = _mm256_loadu_pd(a + 12);
+        __m256d r[4];
+        size_t j;
+
+        // `b` may be `out`, so every column is finished before any store.
+        for(j = 0; j < 4; j++) {
+                r[j] = _mm256_mul_pd(c0, _mm256_broadcast_sd(b + 4 * j));
+                r[j] = _mm256_add_pd(r[j], _mm256_mul_pd(c1, _mm256_broadcast_sd(b + 4 * j + 1)));
+                r[j] = _mm256_add_pd(r[j], _mm256_mul_pd(c2, _mm256_broadcast_sd(b + 4 * j + 2)));
+                r[j] = _mm256_add_pd(r[j], _mm256_mul_pd(c3, _mm256_broadcast_sd(b + 4 * j + 3)));
+        }
+
+        for(j = 0; j < 4; j++) {
+                _mm256_storeu_pd(out + 4 * j, r[j]);
+        }
+}
+
+__attribute__((target("avx")))
+static void avxDTransform(GLdouble* out, const GLdouble* m, const GLdouble* v) {
+        __m256d r;
+
+        r = _mm256_mul_pd(_mm256_loadu_pd(m), _mm256_broadcast_sd(v));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_loadu_pd(m + 4), _mm256_broadcast_sd(v + 1)));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_loadu_pd(m + 8), _mm256_broadcast_sd(v + 2)));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_loadu_pd(m + 12), _mm256_broadcast_sd(v + 3)));
+
+        _mm256_storeu_pd(out, r);
+}
+
+#endif
+
+// --- NEON --- //
+
+#ifdef OGLL_NEON
+
+/* The by-lane multiplies take a 2-lane vector, which is all ARMv7 has. */
+
+static void neonMultiply(GLfloat* out, const GLfloat* a, const GLfloat* b) {
+        float32x4_t c0 = vld1q_f32(a);
+        float32x4_t c1 = vld1q_f32(a + 4);
+        float32x4_t c2 = vld1q_f32(a + 8);
+        float32x4_t c3 = vld1q_f32(a + 12);
+        size_t j;
+
+        for(j = 0; j < 4; j++) {
+                float32x2_t lo = vld1_f32(b + 4 * j);
+                float32x2_t hi = vld1_f32(b + 4 * j + 2);
+                float32x4_t r;
+
+                // vmul + vadd rather than vmla, which may fuse.
+                r = vmulq_lane_f32(c0, lo, 0);
+                r = vaddq_f32(r, vmulq_lane_f32(c1, lo, 1));
+                r = vaddq_f32(r, vmulq_lane_f32(c2, hi, 0));
+                r = vaddq_f32(r, vmulq_lane_f32(c3, hi, 1));
+
+                vst1q_f32(out + 4 * j, r);
+        }
+}
+
+static void neonTransform(GLfloat* out, const GLfloat* m, const GLfloat* v) {
+        float32x4_t vv = vld1q_f32(v);
+        float32x2_t lo = vget_low_f32(vv);
+        float32x2_t hi = vget_high_f32(vv);
+        float32x4_t r;
+
+        r = vmulq_lane_f32(vld1q_f32(m), lo, 0);
+        r = vaddq_f32(r, vmulq_lane_f32(vld1q_f32(m + 4), lo, 1));
+        r = vaddq_f32(r, vmulq_lane_f32(vld1q_f32(m + 8), hi, 0));
+        r = vaddq_f32(r, vmulq_lane_f32(vld1q_f32(m + 12), hi, 1));
+
+        vst1q_f32(out, r);
+}
+
+static void neonTransformN(GLfloat* out, const GLfloat* m, const GLfloat* in,
+                           size_t count, size_t comps, size_t stride) {
+        float32x4_t c0 = vld1q_f32(m);
+        float32x4_t c1 = vld1q_f32(m + 4);
+        float32x4_t c2 = vld1q_f32(m + 8);
+        float32x4_t c3 = vld1q_f32(m + 12);
+        size_t p;
+
+        for(p = 0; p < count; p++) {
+                const GLfloat* v = in + p * stride;
+                GLfloat* o = out + p * stride;
+                float32x4_t r;
+
+                r = vmulq_n_f32(c0, v[0]);
+                r = vaddq_f32(r, vmulq_n_f32(c1, v[1]));
+                r = vaddq_f32(r, vmulq_n_f32(c2, v[2]));
+
+                if(comps == 4) {
+                        r = vaddq_f32(r, vmulq_n_f32(c3, v[3]));
+                        vst1q_f32(o, r);
+                } else {
+                        r = vaddq_f32(r, c3);
+                        vst1_f32(o, vget_low_f32(r));
+                        vst1q_lane_f32(o + 2, r, 2);
+                }
+        }
+}
+
+// Double vectors are AArch64 only. ARMv7 keeps the scalar double kernels.
+#ifdef __aarch64__
+
+static void neonDMultiply(GLdouble* out, const GLdouble* a, const GLdouble* b) {
+        float64x2_t c[8];
+        size_t j,h;
+
+        for(h = 0; h < 8; h++) {
+                c[h] = vld1q_f64(a + 2 * h);
+        }
+
+        for(j = 0; j < 4; j++) {
+                const GLdouble* bj = b + 4 * j;
+
+                // Both halves read all of column j before either is stored.
+                float64x2_t lo = vmulq_n_f64(c[0], bj[0]);
+                float64x2_t hi = vmulq_n_f64(c[1], bj[0]);
+
+                lo = vaddq_f64(lo, vmulq_n_f64(c[2], bj[1]));
+                hi = vaddq_f64(hi, vmulq_n_f64(c[3], bj[1]));
+                lo = vaddq_f64(lo, vmulq_n_f64(c[4], bj[2]));
+                hi = vaddq_f64(hi, vmulq_n_f64(c[5], bj[2]));
+                lo = vaddq_f64(lo, vmulq_n_f64(c[6], bj[3]));
+                hi = vaddq_f64(hi, vmulq_n_f64(c[7], bj[3]));
+
+                vst1q_f64(out + 4 * j, lo);
+                vst1q_f64(out + 4 * j + 2, hi);
+        }
+}
+
+static void neonDTransform(GLdouble* out, const GLdouble* m, const GLdouble* v) {
+        GLdouble v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+        float64x2_t lo, hi;
+
+        lo = vmulq_n_f64(vld1q_f64(m), v0);
+        lo = vaddq_f64(lo, vmulq_n_f64(vld1q_f64(m + 4), v1));
+        lo = vaddq_f64(lo, vmulq_n_f64(vld1q_f64(m + 8), v2));
+        lo = vaddq_f64(lo, vmulq_n_f64(vld1q_f64(m + 12), v3));
+
+        hi = vmulq_n_f64(vld1q_f64(m + 2), v0);
+        hi = vaddq_f64(hi, vmulq_n_f64(vld1q_f64(m + 6), v1));
+        hi = vaddq_f64(hi, vmulq_n_f64(vld1q_f64(m + 10), v2));
+        hi = vaddq_f64(hi, vmulq_n_f64(vld1q_f64(m + 14), v3));
+
+        vst1q_f64(out, lo);
+        vst1q_f64(out + 2, hi);
+}
+
+#endif
+
+#endif
+
+// --- DISPATCH --- //
+
+static const kernels_t scalarKernels = {
+        OGLL_SIMD_SCALAR, scalarMultiply, scalarTransform, scalarTransformN,
+        scalarInverse, scalarDMultiply, scalarDTransform
+};
+
+#ifdef OGLL_X86
+static const kernels_t sseKernels = {
+        OGLL_SIMD_SSE, sseMultiply, sseTransform, sseTransformN, sseInverse,
+        sseDMultiply, sseDTransform
+};
+
+static const kernels_t avxKernels = {
+        OGLL_SIMD_AVX, avxMultiply, sseTransform, sseTransformN, sseInverse,
+        avxDMultiply, avxDTransform
+};
+#endif
+
+#ifdef OGLL_NEON
+static const kernels_t neonKernels = {
+        OGLL_SIMD_NEON, neonMultiply, neonTransform, neonTransformN,
+#ifdef __aarch64__
+        scalarInverse, neonDMultiply, neonDTransform
+#else
+        scalarInverse, scalarDMultiply, scalarDTransform
+#endif
+};
+#endif
+
+/* Resolved lazily. Racing first calls all store the same table. */
+static const kernels_t* active = NULL;
+
+static const kernels_t* kernelsFor(ogll_simd_t s) {
+        switch(s) {
+#ifdef OGLL_X86
+        case OGLL_SIMD_SSE: return &sseKernels;
+        case OGLL_SIMD_AVX: return &avxKernels;
+#endif
+#ifdef OGLL_NEON
+        case OGLL_SIMD_NEON: return &neonKernels;
+#endif
+        default: return &scalarKernels;
+        }
+}
+
+static const kernels_t* kernels(void) {
+        const kernels_t* k = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+
+        if(!k) {
+                if(ogllSimdSupported(OGLL_SIMD_AVX)) {
+                        k = kernelsFor(OGLL_SIMD_AVX);
+                } else if(ogllSimdSupported(OGLL_SIMD_SSE)) {
+                        k = kernelsFor(OGLL_SIMD_SSE);
+                } else if(ogllSimdSupported(OGLL_SIMD_NEON)) {
+                        k = kernelsFor(OGLL_SIMD_NEON);
+                } else {
+                        k = kernelsFor(OGLL_SIMD_SCALAR);
+                }
+
+                __atomic_store_n(&active, k, __ATOMIC_RELEASE);
+        }
+
+        return k;
+}
+
+/* Multiply two 4x4 Matrices: out = a * b */
+void ogllSimdM4Multiply(GLfloat* out, const GLfloat* a, const GLfloat* b) {
+        OGLL_PROBE();
+        kernels()->multiply(out,a,b);
+}
+
+/* Transform a 4-Vector: out = m * v */
+void ogllSimdM4Transform(GLfloat* out, const GLfloat* m, const GLfloat* v) {
+        OGLL_PROBE();
+        kernels()->transform(out,m,v);
+}
+
+/* Transform `count` points of `comps` floats, `stride` floats apart */
+void ogllSimdM4TransformN(GLfloat* out, const GLfloat* m, const GLfloat* in,
+                          size_t count, size_t comps, size_t stride) {
+        OGLL_PROBE();
+        kernels()->transformN(out,m,in,count,comps,stride);
+}
+
+/* Multiply one 4x4 Matrix by `count` others: out[i] = a * bs[i] */
+void ogllSimdM4MultiplyN(GLfloat* out, const GLfloat* a, const GLfloat* bs,
+                         size_t count) {
+        OGLL_PROBE();
+        const kernels_t* k = kernels();
+        size_t i;
+
+        for(i = 0; i < count; i++) {
+                k->multiply(out + 16 * i, a, bs + 16 * i);
+        }
+}
+
+/* Invert a 4x4 Matrix. Fails, leaving `out` alone, if it's singular. */
+bool ogllSimdM4Inverse(GLfloat* out, const GLfloat* m) {
+        OGLL_PROBE();
+        return kernels()->inverse(out,m);
+}
+
+/* Multiply two double 4x4 Matrices: out = a * b */
+void ogllSimdDM4Multiply(GLdouble* out, const GLdouble* a, const GLdouble* b) {
+        OGLL_PROBE();
+        kernels()->dmultiply(out,a,b);
+}
+
+/* Transform a double 4-Vector: out = m * v */
+void ogllSimdDM4Transform(GLdouble* out, const GLdouble* m, const GLdouble* v) {
+        OGLL_PROBE();
+        kernels()->dtransform(out,m,v);
+}
+
+/* The backend currently in use */
+ogll_simd_t ogllSimdBackend(void) {
+        OGLL_PROBE();
+        return kernels()->kind;
+}
+
+/* Human-readable name of a backend */
+const char* ogllSimdName(ogll_simd_t s) {
+        OGLL_PROBE();
+        switch(s) {
+        case OGLL_SIMD_SSE:  return "sse";
+        case OGLL_SIMD_AVX:  return "avx";
+        case OGLL_SIMD_NEON: return "neon";
+        default:             return "scalar";
+        }
+}
+
+/* Is a backend usable on this CPU? */
+bool ogllSimdSupported(ogll_simd_t s) {
+        OGLL_PROBE();
+        switch(s) {
+        case OGLL_SIMD_SCALAR:
+                return true;
+#ifdef OGLL_X86
+        case OGLL_SIMD_SSE:
+                // The double kernels need SSE2.
+                return __builtin_cpu_supports("sse2");
+        case OGLL_SIMD_AVX:
+                return __builtin_cpu_supports("avx");
+#endif
+#ifdef OGLL_NEON
+        case OGLL_SIMD_NEON:
+                return true;
+#endif
+        default:
+                return false;
+        }
+}
+
+/* Force a particular backend */
+bool ogllSimdSelect(ogll_simd_t s) {
+        OGLL_PROBE();
+        check(ogllSimdSupported(s), "SIMD backend `%s` not supported.",
+              ogllSimdName(s));
+
+        __atomic_store_n(&active, kernelsFor(s), __ATOMIC_RELEASE);
+
+        return true;
+ error:
+        return false;
+}
@@ -0,0 +1,88 @@
+#ifndef __ogll_simd__
+#define __ogll_simd__
+
+#include <GL/glew.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Vectorized 4x4 kernels shared by the heap and value APIs.
+ *
+ * All Matrices are 16 column-major floats. The backend is picked on
+ * first use from what the running CPU supports (AVX, then SSE2 on x86;
+ * NEON on ARM) and falls back to plain C everywhere else.
+ *
+ * Accuracy: every backend accumulates `a[k] * b[k]` in the same order
+ * (k = 0..3) as the scalar loop in `ogllMMultiplyP`, without fused
+ * multiply-adds, so results are bit-identical to the scalar path
+ * (0 ULP). The only observable difference is the sign of an exact
+ * zero, since the scalar loop starts its sums from +0. If the library
+ * is built with FMA contraction enabled (e.g. `-mfma -ffp-contract=fast`)
+ * the scalar path may fuse and the bound loosens to 1 ULP per term,
+ * i.e. at most 4 ULP of the largest partial product.
+ *
+ * The double kernels follow the same rule against a scalar loop in
+ * double, so they too are bit-identical across backends.
+ *
+ * `ogllSimdM4Inverse` is the exception: the SSE kernel works on 2x2
+ * blocks rather than cofactors, so it agrees with the scalar one to a few
+ * ULP relative to the largest entry, not bit-for-bit.
+ */
+
+// --- //
+
+typedef enum ogll_simd_t {
+        OGLL_SIMD_SCALAR,
+        OGLL_SIMD_SSE,
+        OGLL_SIMD_AVX,
+        OGLL_SIMD_NEON
+} ogll_simd_t;
+
+/* Multiply two 4x4 Matrices: out = a * b. `out` may alias `a` or `b`. */
+void ogllSimdM4Multiply(GLfloat* out, const GLfloat* a, const GLfloat* b);
+
+/* Transform a 4-Vector: out = m * v. `out` may alias `v`. */
+void ogllSimdM4Transform(GLfloat* out, const GLfloat* m, const GLfloat* v);
+
+/* Transform `count` points. Each point is `comps` (3 or 4) floats and
+   consecutive points start `stride` floats apart. For xyz points w is
+   taken to be 1 and only xyz is written. `out` may be `in`. */
+void ogllSimdM4TransformN(GLfloat* out, const GLfloat* m, const GLfloat* in,
+                          size_t count, size_t comps, size_t stride);
+
+/* Multiply one 4x4 Matrix by `count` packed 4x4 Matrices:
+   out[i] = a * bs[i]. `out` may be `bs`, but not `a`. */
+void ogllSimdM4MultiplyN(GLfloat* out, const GLfloat* a, const GLfloat* bs,
+                         size_t count);
+
+/* Invert a 4x4 Matrix: out = m^-1. `out` may alias `m`. Returns false,
+   leaving `out` untouched, if `m` is singular. */
+bool ogllSimdM4Inverse(GLfloat* out, const GLfloat* m);
+
+/* Multiply two double 4x4 Matrices: out = a * b. `out` may alias `a`
+   or `b`. */
+void ogllSimdDM4Multiply(GLdouble* out, const GLdouble* a, const GLdouble* b);
+
+/* Transform a double 4-Vector: out = m * v. `out` may alias `v`. */
+void ogllSimdDM4Transform(GLdouble* out, const GLdouble* m, const GLdouble* v);
+
+/* The backend currently in use */
+ogll_simd_t ogllSimdBackend(void);
+
+/* Human-readable name of a backend */
+const char* ogllSimdName(ogll_simd_t s);
+
+/* Is a backend usable on this CPU? */
+bool ogllSimdSupported(ogll_simd_t s);
+
+/* Force a particular backend. Fails if the CPU doesn't support it. */
+bool ogllSimdSelect(ogll_simd_t s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
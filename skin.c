@@ -0,0 +1,385 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "skin.h"
+#include "quat.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OGLL_X86
+#include <immintrin.h>
+#endif
+
+// --- //
+
+#define SKIN_GRAIN 512
+
+typedef struct job_t {
+        ogll_skin_t mode;
+        const mat4_t* palette;
+        const GLfloat* dqs;         // 8 per bone: real xyzw, dual xyzw
+        const skin_mesh_t* mesh;
+        GLfloat* positions;
+        GLfloat* normals;
+        bool sse;
+} job_t;
+
+/* Blends have a plain version and an SSE version. Both do the same
+   operations in the same order, so which one runs makes no difference to
+   the results. */
+static bool useSse(void) {
+#ifdef OGLL_X86
+        return ogllSimdBackend() != OGLL_SIMD_SCALAR;
+#else
+        return false;
+#endif
+}
+
+static void normalize3(GLfloat* v) {
+        GLfloat len = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+        if(len > 0) {
+                v[0] /= len;
+                v[1] /= len;
+                v[2] /= len;
+        }
+}
+
+/* True cross product, unlike `ogllVCrossP` */
+static void cross3(GLfloat* out, const GLfloat* a, const GLfloat* b) {
+        GLfloat x = a[1] * b[2] - a[2] * b[1];
+        GLfloat y = a[2] * b[0] - a[0] * b[2];
+        GLfloat z = a[0] * b[1] - a[1] * b[0];
+
+        out[0] = x;
+        out[1] = y;
+        out[2] = z;
+}
+
+// --- LINEAR --- //
+
+static void blendMatrices(GLfloat* m, const mat4_t* palette,
+                          const uint16_t* j, const GLfloat* w) {
+        size_t k,c;
+
+        for(c = 0; c < 16; c++) {
+                m[c] = 0;
+        }
+
+        for(k = 0; k < OGLL_SKIN_INFLUENCES; k++) {
+                if(w[k] != 0) {
+                        for(c = 0; c < 16; c++) {
+                                m[c] += w[k] * palette[j[k]].m[c];
+                        }
+                }
+        }
+}
+
+static void linearVertex(GLfloat* p, GLfloat* n, const GLfloat* m,
+                         const GLfloat* ip, const GLfloat* in) {
+        GLfloat o[3];
+        size_t r;
+
+        for(r = 0; r < 3; r++) {
+                o[r] = m[r] * ip[0] + m[4 + r] * ip[1] + m[8 + r] * ip[2] + m[12 + r];
+        }
+
+        if(n) {
+                GLfloat on[3];
+
+                for(r = 0; r < 3; r++) {
+                        on[r] = m[r] * in[0] + m[4 + r] * in[1] + m[8 + r] * in[2];
+                }
+
+                normalize3(on);
+                n[0] = on[0];
+                n[1] = on[1];
+                n[2] = on[2];
+        }
+
+        p[0] = o[0];
+        p[1] = o[1];
+        p[2] = o[2];
+}
+
+#ifdef OGLL_X86
+
+/* The blended Matrix stays in four registers, then transforms as in
+   `sseTransformN`. */
+__attribute__((target("sse")))
+static void sseLinearVertex(GLfloat* p, GLfloat* n, const mat4_t* palette,
+                            const uint16_t* j, const GLfloat* w,
+                            const GLfloat* ip, const GLfloat* in) {
+        __m128 c0 = _mm_setzero_ps();
+        __m128 c1 = _mm_setzero_ps();
+        __m128 c2 = _mm_setzero_ps();
+        __m128 c3 = _mm_setzero_ps();
+        GLfloat o[4];
+        size_t k;
+
+        for(k = 0; k < OGLL_SKIN_INFLUENCES; k++) {
+                if(w[k] != 0) {
+                        const GLfloat* b = palette[j[k]].m;
+                        __m128 wk = _mm_set1_ps(w[k]);
+
+                        c0 = _mm_add_ps(c0, _mm_mul_ps(wk, _mm_loadu_ps(b)));
+                        c1 = _mm_add_ps(c1, _mm_mul_ps(wk, _mm_loadu_ps(b + 4)));
+                        c2 = _mm_add_ps(c2, _mm_mul_ps(wk, _mm_loadu_ps(b + 8)));
+                        c3 = _mm_add_ps(c3, _mm_mul_ps(wk, _mm_loadu_ps(b + 12)));
+                }
+        }
+
+        if(n) {
+                __m128 r;
+
+                r = _mm_mul_ps(c0, _mm_set1_ps(in[0]));
+                r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(in[1])));
+                r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(in[2])));
+                _mm_storeu_ps(o, r);
+
+                normalize3(o);
+                n[0] = o[0];
+                n[1] = o[1];
+                n[2] = o[2];
+        }
+
+        {
+                __m128 r;
+
+                r = _mm_mul_ps(c0, _mm_set1_ps(ip[0]));
+                r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(ip[1])));
+                r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(ip[2])));
+                r = _mm_add_ps(r, c3);
+                _mm_storeu_ps(o, r);
+        }
+
+        p[0] = o[0];
+        p[1] = o[1];
+        p[2] = o[2];
+}
+
+#endif
+
+// --- DUAL QUATERNIONS --- //
+
+/* q for the rotation, and 0.5 * t * q for the translation */
+static void boneDualQuat(GLfloat* dq, const mat4_t* m) {
+        quat_t q = ogllQNormalize(ogllQFromMat4(m));
+        GLfloat tx = m->m[12], ty = m->m[13], tz = m->m[14];
+
+        dq[0] = q.x;
+        dq[1] = q.y;
+        dq[2] = q.z;
+        dq[3] = q.w;
+        dq[4] = 0.5 * ( tx * q.w + ty * q.z - tz * q.y);
+        dq[5] = 0.5 * (-tx * q.z + ty * q.w + tz * q.x);
+        dq[6] = 0.5 * ( tx * q.y - ty * q.x + tz * q.w);
+        dq[7] = -0.5 * (tx * q.x + ty * q.y + tz * q.z);
+}
+
+/* Each bone's weight, negated if its rotation faces away from the first
+   bone's, so the blend takes the short way round. */
+static void signedWeights(GLfloat* sw, const GLfloat* dqs,
+                          const uint16_t* j, const GLfloat* w) {
+        const GLfloat* pivot = dqs + 8 * j[0];
+        size_t k;
+
+        for(k = 0; k < OGLL_SKIN_INFLUENCES; k++) {
+                const GLfloat* q = dqs + 8 * j[k];
+                GLfloat d = q[0] * pivot[0] + q[1] * pivot[1] +
+                        q[2] * pivot[2] + q[3] * pivot[3];
+
+                sw[k] = d < 0 ? -w[k] : w[k];
+        }
+}
+
+static void blendDualQuats(GLfloat* b, const GLfloat* dqs,
+                           const uint16_t* j, const GLfloat* sw) {
+        size_t k,c;
+
+        for(c = 0; c < 8; c++) {
+                b[c] = 0;
+        }
+
+        for(k = 0; k < OGLL_SKIN_INFLUENCES; k++) {
+                if(sw[k] != 0) {
+                        for(c = 0; c < 8; c++) {
+                                b[c] += sw[k] * dqs[8 * j[k] + c];
+                        }
+                }
+        }
+}
+
+#ifdef OGLL_X86
+
+__attribute__((target("sse")))
+static void sseBlendDualQuats(GLfloat* b, const GLfloat* dqs,
+                              const uint16_t* j, const GLfloat* sw) {
+        __m128 re = _mm_setzero_ps();
+        __m128 du = _mm_setzero_ps();
+        size_t k;
+
+        for(k = 0; k < OGLL_SKIN_INFLUENCES; k++) {
+                if(sw[k] != 0) {
+                        __m128 s = _mm_set1_ps(sw[k]);
+
+                        re = _mm_add_ps(re, _mm_mul_ps(s, _mm_loadu_ps(dqs + 8 * j[k])));
+                        du = _mm_add_ps(du, _mm_mul_ps(s, _mm_loadu_ps(dqs + 8 * j[k] + 4)));
+                }
+        }
+
+        _mm_storeu_ps(b, re);
+        _mm_storeu_ps(b + 4, du);
+}
+
+#endif
+
+/* out = v + 2 r.xyz x (r.xyz x v + r.w v), i.e. v rotated by unit r */
+static void rotate3(GLfloat* out, const GLfloat* r, const GLfloat* v) {
+        GLfloat u[3];
+        size_t i;
+
+        cross3(u, r, v);
+        for(i = 0; i < 3; i++) {
+                u[i] += r[3] * v[i];
+        }
+        cross3(u, r, u);
+
+        for(i = 0; i < 3; i++) {
+                out[i] = v[i] + 2 * u[i];
+        }
+}
+
+/* Apply a blended dual quaternion to a point and a normal */
+static void dualQuatVertex(GLfloat* p, GLfloat* n, const GLfloat* b,
+                           const GLfloat* ip, const GLfloat* in) {
+        GLfloat len = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+        GLfloat r[4], d[4], t[3], o[3];
+        size_t i;
+
+        if(len == 0) {
+                // The weights cancelled out. Leave the vertex where it was.
+                for(i = 0; i < 3; i++) {
+                        o[i] = ip[i];
+                        t[i] = n ? in[i] : 0;
+                }
+        } else {
+                for(i = 0; i < 4; i++) {
+                        r[i] = b[i] / len;
+                        d[i] = b[4 + i] / len;
+                }
+
+                // Translation: 2 (r.w d.xyz - d.w r.xyz + r.xyz x d.xyz)
+                cross3(t, r, d);
+                rotate3(o, r, ip);
+                for(i = 0; i < 3; i++) {
+                        o[i] += 2 * (r[3] * d[i] - d[3] * r[i] + t[i]);
+                }
+
+                if(n) {
+                        rotate3(t, r, in);
+                        normalize3(t);
+                }
+        }
+
+        if(n) {
+                n[0] = t[0];
+                n[1] = t[1];
+                n[2] = t[2];
+        }
+
+        p[0] = o[0];
+        p[1] = o[1];
+        p[2] = o[2];
+}
+
+// --- DRIVER --- //
+
+static void skinRange(void* arg, size_t begin, size_t end) {
+        const job_t* job = arg;
+        const skin_mesh_t* mesh = job->mesh;
+        const GLfloat* in;
+        GLfloat* n;
+        GLfloat m[16], b[8], sw[OGLL_SKIN_INFLUENCES];
+        size_t v;
+
+        for(v = begin; v < end; v++) {
+                const uint16_t* j = mesh->joints + OGLL_SKIN_INFLUENCES * v;
+                const GLfloat* w = mesh->weights + OGLL_SKIN_INFLUENCES * v;
+                const GLfloat* ip = mesh->positions + 3 * v;
+                GLfloat* p = job->positions + 3 * v;
+
+                in = job->normals ? mesh->normals + 3 * v : NULL;
+                n = job->normals ? job->normals + 3 * v : NULL;
+
+                if(job->mode == OGLL_SKIN_LINEAR) {
+#ifdef OGLL_X86
+                        if(job->sse) {
+                                sseLinearVertex(p, n, job->palette, j, w, ip, in);
+                                continue;
+                        }
+#endif
+                        blendMatrices(m, job->palette, j, w);
+                        linearVertex(p, n, m, ip, in);
+                } else {
+                        signedWeights(sw, job->dqs, j, w);
+#ifdef OGLL_X86
+                        if(job->sse) {
+                                sseBlendDualQuats(b, job->dqs, j, sw);
+                        } else
+#endif
+                        blendDualQuats(b, job->dqs, j, sw);
+                        dualQuatVertex(p, n, b, ip, in);
+                }
+        }
+}
+
+/* Skin every vertex of `mesh` */
+bool ogllSkin(ogll_skin_t mode, const mat4_t* palette, size_t bones,
+              const skin_mesh_t* mesh, GLfloat* positions, GLfloat* normals,
+              pool_t* pool) {
+        OGLL_PROBE();
+        GLfloat* dqs = NULL;
+        job_t job;
+        size_t i;
+
+        check(palette && mesh && positions, "Null argument given.");
+        check(mode == OGLL_SKIN_LINEAR || mode == OGLL_SKIN_DUALQUAT,
+              "Unknown skinning mode.");
+        check(mesh->count == 0 ||
+              (mesh->positions && mesh->joints && mesh->weights),
+              "Mesh is missing a stream.");
+
+        for(i = 0; i < mesh->count * OGLL_SKIN_INFLUENCES; i++) {
+                check(mesh->joints[i] < bones, "Joint %u out of range.",
+                      (unsigned)mesh->joints[i]);
+        }
+
+        if(mode == OGLL_SKIN_DUALQUAT) {
+                dqs = malloc(bones * 8 * sizeof(GLfloat));
+                check_mem(dqs);
+
+                for(i = 0; i < bones; i++) {
+                        boneDualQuat(dqs + 8 * i, palette + i);
+                }
+        }
+
+        job.mode = mode;
+        job.palette = palette;
+        job.dqs = dqs;
+        job.mesh = mesh;
+        job.positions = positions;
+        job.normals = mesh->normals ? normals : NULL;
+        job.sse = useSse();
+
+        ogllPoolFor(pool, mesh->count, SKIN_GRAIN, skinRange, &job);
+
+        free(dqs);
+
+        return true;
+ error:
+        free(dqs);
+        return false;
+}
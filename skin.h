@@ -0,0 +1,59 @@
+#ifndef __ogll_skin__
+#define __ogll_skin__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "value.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* CPU skinning of whole meshes against a palette of bone Matrices.
+ *
+ * Each vertex is bound to OGLL_SKIN_INFLUENCES bones, with weights that
+ * should sum to 1. Influences with weight 0 are skipped, so unused slots
+ * may point at any valid bone.
+ *
+ * Linear blending sums the weighted bone Matrices and transforms by the
+ * result. Dual-quaternion blending sums the bones as rigid transforms
+ * instead, which keeps volume at twisting joints, but ignores any scale
+ * in the palette. Normals come out unit length in both modes.
+ *
+ * Vertices are spread over `pool` in chunks. The per-vertex blend uses
+ * SSE where available, with results bit-identical to the plain loop.
+ */
+
+// --- //
+
+#define OGLL_SKIN_INFLUENCES 4
+
+typedef enum ogll_skin_t {
+        OGLL_SKIN_LINEAR,
+        OGLL_SKIN_DUALQUAT
+} ogll_skin_t;
+
+typedef struct skin_mesh_t {
+        const GLfloat* positions;   // xyz per vertex, packed
+        const GLfloat* normals;     // xyz per vertex, packed. May be NULL.
+        const uint16_t* joints;     // OGLL_SKIN_INFLUENCES per vertex
+        const GLfloat* weights;     // OGLL_SKIN_INFLUENCES per vertex
+        size_t count;
+} skin_mesh_t;
+
+/* Skin every vertex of `mesh` by the `bones` Matrices in `palette`,
+   writing packed xyz to `positions` and, if both it and the mesh's
+   normals are given, `normals`. The outputs may be the mesh's own
+   arrays. `pool` may be NULL to run on the calling thread only. Fails
+   without writing anything if a joint is out of range. */
+bool ogllSkin(ogll_skin_t mode, const mat4_t* palette, size_t bones,
+              const skin_mesh_t* mesh, GLfloat* positions, GLfloat* normals,
+              pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
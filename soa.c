@@ -0,0 +1,451 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "soa.h"
+#include "simd.h"
+#include "alloc.h"
+#include "opengl-linalg.h"
+#include "instrument.h"
+#include "dbg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OGLL_X86
+#include <immintrin.h>
+#endif
+
+// --- //
+
+#define HEADER_SIZE ((sizeof(soa_t) + OGLL_ALIGN - 1) & ~(size_t)(OGLL_ALIGN - 1))
+
+/* Lanes are padded so each one starts OGLL_ALIGN-aligned */
+#define LANE_FLOATS (OGLL_ALIGN / sizeof(GLfloat))
+
+static size_t laneLength(size_t count) {
+        return (count + LANE_FLOATS - 1) / LANE_FLOATS * LANE_FLOATS;
+}
+
+/* Each kernel has a plain loop and an SSE loop over blocks of 4, with the
+   plain loop finishing the tail. Both do the same operations in the same
+   order, so which one runs makes no difference to the results. */
+static bool useSse(void) {
+#ifdef OGLL_X86
+        return ogllSimdBackend() != OGLL_SIMD_SCALAR;
+#else
+        return false;
+#endif
+}
+
+/* Create a stream of `count` Vectors of `comps` components */
+soa_t* ogllSoaCreate(size_t count, size_t comps) {
+        OGLL_PROBE();
+        const allocator_t* a = ogllGetAllocator();
+        soa_t* s = NULL;
+        void* block = NULL;
+        GLfloat* lanes;
+        size_t len, bytes, i;
+
+        check(count > 0, "Bad count given.");
+        check(comps == 3 || comps == 4, "Streams must be 3 or 4 wide.");
+
+        len = laneLength(count);
+        bytes = HEADER_SIZE + comps * len * sizeof(GLfloat);
+
+        if(a) {
+                block = a->alloc(a->ctx, bytes, OGLL_ALIGN);
+        } else if(posix_memalign(&block, OGLL_ALIGN, bytes) != 0) {
+                block = NULL;
+        }
+        check_mem(block);
+        OGLL_PROBE_ALLOC(bytes);
+
+        s = (soa_t*)block;
+        lanes = (GLfloat*)((char*)block + HEADER_SIZE);
+        s->x = lanes;
+        s->y = lanes + len;
+        s->z = lanes + 2 * len;
+        s->w = comps == 4 ? lanes + 3 * len : NULL;
+        s->count = count;
+        s->comps = comps;
+        s->alloc = a;
+
+        for(i = 0; i < comps * len; i++) {
+                lanes[i] = 0;
+        }
+
+        return s;
+ error:
+        return NULL;
+}
+
+/* Free a stream */
+void ogllSoaDestroy(soa_t* s) {
+        OGLL_PROBE();
+        if(s) {
+                OGLL_PROBE_FREE(HEADER_SIZE + s->comps * laneLength(s->count) * sizeof(GLfloat));
+
+                if(s->alloc) {
+                        s->alloc->free(s->alloc->ctx, s);
+                } else {
+                        free(s);
+                }
+        }
+}
+
+/* Fill `s` from interleaved Vectors */
+bool ogllSoaFromInterleaved(soa_t* s, const GLfloat* in, size_t stride) {
+        OGLL_PROBE();
+        size_t i;
+
+        check(s && in, "Null argument given.");
+
+        if(stride == 0) {
+                stride = s->comps;
+        }
+        check(stride >= s->comps, "Stride smaller than a Vector.");
+
+        for(i = 0; i < s->count; i++) {
+                const GLfloat* v = in + i * stride;
+
+                s->x[i] = v[0];
+                s->y[i] = v[1];
+                s->z[i] = v[2];
+                if(s->w) {
+                        s->w[i] = v[3];
+                }
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* Write `s` out as interleaved Vectors */
+bool ogllSoaToInterleaved(const soa_t* s, GLfloat* out, size_t stride) {
+        OGLL_PROBE();
+        size_t i;
+
+        check(s && out, "Null argument given.");
+
+        if(stride == 0) {
+                stride = s->comps;
+        }
+        check(stride >= s->comps, "Stride smaller than a Vector.");
+
+        for(i = 0; i < s->count; i++) {
+                GLfloat* v = out + i * stride;
+
+                v[0] = s->x[i];
+                v[1] = s->y[i];
+                v[2] = s->z[i];
+                if(s->w) {
+                        v[3] = s->w[i];
+                }
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+// --- LANE KERNELS --- //
+
+#ifdef OGLL_X86
+
+__attribute__((target("sse")))
+static size_t sseAdd(GLfloat* o, const GLfloat* a, const GLfloat* b, size_t n) {
+        size_t i;
+
+        for(i = 0; i + 4 <= n; i += 4) {
+                _mm_storeu_ps(o + i, _mm_add_ps(_mm_loadu_ps(a + i),
+                                                _mm_loadu_ps(b + i)));
+        }
+
+        return i;
+}
+
+__attribute__((target("sse")))
+static size_t sseScale(GLfloat* o, const GLfloat* a, GLfloat f, size_t n) {
+        __m128 fv = _mm_set1_ps(f);
+        size_t i;
+
+        for(i = 0; i + 4 <= n; i += 4) {
+                _mm_storeu_ps(o + i, _mm_mul_ps(fv, _mm_loadu_ps(a + i)));
+        }
+
+        return i;
+}
+
+/* Sums are formed x, y, z, then w, as in `dotAt` */
+__attribute__((target("sse")))
+static size_t sseDot(GLfloat* o, const soa_t* a, const soa_t* b, bool root) {
+        size_t n = a->count;
+        size_t i;
+
+        for(i = 0; i + 4 <= n; i += 4) {
+                __m128 d;
+
+                d = _mm_mul_ps(_mm_loadu_ps(a->x + i), _mm_loadu_ps(b->x + i));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(a->y + i), _mm_loadu_ps(b->y + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(a->z + i), _mm_loadu_ps(b->z + i)));
+                if(a->w) {
+                        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(a->w + i),
+                                                     _mm_loadu_ps(b->w + i)));
+                }
+                if(root) {
+                        d = _mm_sqrt_ps(d);
+                }
+
+                _mm_storeu_ps(o + i, d);
+        }
+
+        return i;
+}
+
+__attribute__((target("sse")))
+static size_t sseCross(soa_t* o, const soa_t* a, const soa_t* b) {
+        size_t i;
+
+        for(i = 0; i + 4 <= o->count; i += 4) {
+                __m128 ax = _mm_loadu_ps(a->x + i);
+                __m128 ay = _mm_loadu_ps(a->y + i);
+                __m128 az = _mm_loadu_ps(a->z + i);
+                __m128 bx = _mm_loadu_ps(b->x + i);
+                __m128 by = _mm_loadu_ps(b->y + i);
+                __m128 bz = _mm_loadu_ps(b->z + i);
+
+                _mm_storeu_ps(o->x + i, _mm_sub_ps(_mm_mul_ps(ay,bz), _mm_mul_ps(az,by)));
+                _mm_storeu_ps(o->y + i, _mm_sub_ps(_mm_mul_ps(az,bx), _mm_mul_ps(ax,bz)));
+                _mm_storeu_ps(o->z + i, _mm_sub_ps(_mm_mul_ps(ax,by), _mm_mul_ps(ay,bx)));
+        }
+
+        return i;
+}
+
+/* Zero lengths are masked to give 0 rather than 0/0 */
+__attribute__((target("sse")))
+static size_t sseNormalize(soa_t* o, const soa_t* a) {
+        __m128 zero = _mm_setzero_ps();
+        size_t i;
+
+        for(i = 0; i + 4 <= o->count; i += 4) {
+                __m128 x = _mm_loadu_ps(a->x + i);
+                __m128 y = _mm_loadu_ps(a->y + i);
+                __m128 z = _mm_loadu_ps(a->z + i);
+                __m128 w = a->w ? _mm_loadu_ps(a->w + i) : zero;
+                __m128 len, keep;
+
+                len = _mm_mul_ps(x,x);
+                len = _mm_add_ps(len, _mm_mul_ps(y,y));
+                len = _mm_add_ps(len, _mm_mul_ps(z,z));
+                if(a->w) {
+                        len = _mm_add_ps(len, _mm_mul_ps(w,w));
+                }
+                len = _mm_sqrt_ps(len);
+                keep = _mm_cmpneq_ps(len, zero);
+
+                _mm_storeu_ps(o->x + i, _mm_and_ps(keep, _mm_div_ps(x,len)));
+                _mm_storeu_ps(o->y + i, _mm_and_ps(keep, _mm_div_ps(y,len)));
+                _mm_storeu_ps(o->z + i, _mm_and_ps(keep, _mm_div_ps(z,len)));
+                if(o->w) {
+                        _mm_storeu_ps(o->w + i, _mm_and_ps(keep, _mm_div_ps(w,len)));
+                }
+        }
+
+        return i;
+}
+
+#endif
+
+static GLfloat dotAt(const soa_t* a, const soa_t* b, size_t i) {
+        GLfloat d = a->x[i] * b->x[i];
+
+        d += a->y[i] * b->y[i];
+        d += a->z[i] * b->z[i];
+        if(a->w) {
+                d += a->w[i] * b->w[i];
+        }
+
+        return d;
+}
+
+static void addLane(GLfloat* o, const GLfloat* a, const GLfloat* b, size_t n) {
+        size_t i = 0;
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                i = sseAdd(o,a,b,n);
+        }
+#endif
+
+        for(; i < n; i++) {
+                o[i] = a[i] + b[i];
+        }
+}
+
+static void scaleLane(GLfloat* o, const GLfloat* a, GLfloat f, size_t n) {
+        size_t i = 0;
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                i = sseScale(o,a,f,n);
+        }
+#endif
+
+        for(; i < n; i++) {
+                o[i] = f * a[i];
+        }
+}
+
+static bool sameShape(const soa_t* a, const soa_t* b) {
+        return a->count == b->count && a->comps == b->comps;
+}
+
+// --- KERNELS --- //
+
+/* out[i] = a[i] . b[i] */
+bool ogllSoaDot(GLfloat* out, const soa_t* a, const soa_t* b) {
+        OGLL_PROBE();
+        size_t i = 0;
+
+        check(out && a && b, "Null argument given.");
+        check(sameShape(a,b), "Streams aren't the same shape.");
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                i = sseDot(out,a,b,false);
+        }
+#endif
+
+        for(; i < a->count; i++) {
+                out[i] = dotAt(a,b,i);
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* out[i] = |a[i]| */
+bool ogllSoaLength(GLfloat* out, const soa_t* a) {
+        OGLL_PROBE();
+        size_t i = 0;
+
+        check(out && a, "Null argument given.");
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                i = sseDot(out,a,a,true);
+        }
+#endif
+
+        for(; i < a->count; i++) {
+                out[i] = sqrtf(dotAt(a,a,i));
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* out[i] = a[i] x b[i] on xyz. Agrees with `ogllV3Cross`. */
+bool ogllSoaCross(soa_t* out, const soa_t* a, const soa_t* b) {
+        OGLL_PROBE();
+        size_t i = 0;
+
+        check(out && a && b, "Null argument given.");
+        check(out->count == a->count && a->count == b->count,
+              "Streams aren't the same length.");
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                i = sseCross(out,a,b);
+        }
+#endif
+
+        for(; i < out->count; i++) {
+                GLfloat x = a->y[i] * b->z[i] - a->z[i] * b->y[i];
+                GLfloat y = a->z[i] * b->x[i] - a->x[i] * b->z[i];
+                GLfloat z = a->x[i] * b->y[i] - a->y[i] * b->x[i];
+
+                out->x[i] = x;
+                out->y[i] = y;
+                out->z[i] = z;
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* out[i] = a[i] / |a[i]| */
+bool ogllSoaNormalize(soa_t* out, const soa_t* a) {
+        OGLL_PROBE();
+        size_t i = 0;
+
+        check(out && a, "Null argument given.");
+        check(sameShape(out,a), "Streams aren't the same shape.");
+
+#ifdef OGLL_X86
+        if(useSse()) {
+                i = sseNormalize(out,a);
+        }
+#endif
+
+        for(; i < out->count; i++) {
+                GLfloat len = sqrtf(dotAt(a,a,i));
+
+                if(len == 0) {
+                        out->x[i] = out->y[i] = out->z[i] = 0;
+                        if(out->w) {
+                                out->w[i] = 0;
+                        }
+                } else {
+                        out->x[i] = a->x[i] / len;
+                        out->y[i] = a->y[i] / len;
+                        out->z[i] = a->z[i] / len;
+                        if(out->w) {
+                                out->w[i] = a->w[i] / len;
+                        }
+                }
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* out[i] = a[i] + b[i] */
+bool ogllSoaAdd(soa_t* out, const soa_t* a, const soa_t* b) {
+        OGLL_PROBE();
+        check(out && a && b, "Null argument given.");
+        check(sameShape(out,a) && sameShape(a,b), "Streams aren't the same shape.");
+
+        addLane(out->x, a->x, b->x, out->count);
+        addLane(out->y, a->y, b->y, out->count);
+        addLane(out->z, a->z, b->z, out->count);
+        if(out->w) {
+                addLane(out->w, a->w, b->w, out->count);
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* out[i] = f * a[i] */
+bool ogllSoaScale(soa_t* out, const soa_t* a, GLfloat f) {
+        OGLL_PROBE();
+        check(out && a, "Null argument given.");
+        check(sameShape(out,a), "Streams aren't the same shape.");
+
+        scaleLane(out->x, a->x, f, out->count);
+        scaleLane(out->y, a->y, f, out->count);
+        scaleLane(out->z, a->z, f, out->count);
+        if(out->w) {
+                scaleLane(out->w, a->w, f, out->count);
+        }
+
+        return true;
+ error:
+        return false;
+}
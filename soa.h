@@ -0,0 +1,77 @@
+#ifndef __ogll_soa__
+#define __ogll_soa__
+
+#include <GL/glew.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Streams of Vectors in structure-of-arrays layout.
+ *
+ * Each component lives in its own aligned lane, so a bulk operation
+ * handles 4 (SSE) or more Vectors per instruction instead of one heap
+ * Vector per call. Use these for physics and culling passes over large
+ * sets, and convert to and from the interleaved layouts the GPU wants
+ * at the edges.
+ *
+ * Every kernel takes a count from its operands, which must match, and
+ * `out` may be any of the inputs. Results are bit-identical whichever
+ * SIMD backend is active.
+ */
+
+// --- //
+
+typedef struct soa_t {
+        GLfloat* x;
+        GLfloat* y;
+        GLfloat* z;
+        GLfloat* w;  // NULL for 3-component streams
+        size_t count;
+        size_t comps;
+        const struct allocator_t* alloc;
+} soa_t;
+
+/* Create a stream of `count` Vectors of `comps` (3 or 4) components,
+   all 0. One allocation, through the installed allocator if any. */
+soa_t* ogllSoaCreate(size_t count, size_t comps);
+
+/* Free a stream */
+void ogllSoaDestroy(soa_t* s);
+
+/* Fill `s` from interleaved Vectors `stride` floats apart (0 means
+   packed). `s->comps` floats are read from each. */
+bool ogllSoaFromInterleaved(soa_t* s, const GLfloat* in, size_t stride);
+
+/* Write `s` out as interleaved Vectors `stride` floats apart (0 means
+   packed). Only `s->comps` floats are written for each. */
+bool ogllSoaToInterleaved(const soa_t* s, GLfloat* out, size_t stride);
+
+// --- KERNELS --- //
+
+/* out[i] = a[i] . b[i], over every component */
+bool ogllSoaDot(GLfloat* out, const soa_t* a, const soa_t* b);
+
+/* out[i] = |a[i]| */
+bool ogllSoaLength(GLfloat* out, const soa_t* a);
+
+/* out[i] = a[i] x b[i] on xyz. Agrees with `ogllV3Cross`.
+   The w lane of `out`, if any, is left alone. */
+bool ogllSoaCross(soa_t* out, const soa_t* a, const soa_t* b);
+
+/* out[i] = a[i] / |a[i]|. Zero Vectors stay zero. */
+bool ogllSoaNormalize(soa_t* out, const soa_t* a);
+
+/* out[i] = a[i] + b[i] */
+bool ogllSoaAdd(soa_t* out, const soa_t* a, const soa_t* b);
+
+/* out[i] = f * a[i] */
+bool ogllSoaScale(soa_t* out, const soa_t* a, GLfloat f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
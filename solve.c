@@ -0,0 +1,769 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "solve.h"
+#include "gemm.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+#define SOLVE_BLOCK       64    // Panel width
+#define SOLVE_BLOCKED_MIN 128   // Below this, one panel covers everything
+#define SOLVE_STRIP       256   // Columns per trailing GEMM
+#define SOLVE_GRAIN       8     // Columns per task
+
+/* Element (row r, col c) of a column-major Matrix */
+#define AT(a, r, c) ((a)->m[(c) * (a)->rows + (r)])
+
+typedef struct sub_t {
+        GLfloat* C;
+        size_t ldc;
+        const GLfloat* S;
+        size_t rows;
+        size_t r0, c0;
+        bool lower;
+} sub_t;
+
+typedef struct rhs_t {
+        matrix_t* f;            // The factored Matrix
+        const size_t* piv;
+        const GLfloat* tau;
+        matrix_t* b;
+} rhs_t;
+
+/* `pool`, if `work` multiply-adds are enough to share out */
+static pool_t* shared(pool_t* pool, size_t work) {
+        return work >= OGLL_GEMM_THREADED_MIN ? pool : NULL;
+}
+
+/* The GEMM pool, if `work` multiply-adds are enough to share out */
+static pool_t* poolFor(size_t work) {
+        return shared(ogllGemmPool(), work);
+}
+
+static size_t panelWidth(size_t n) {
+        return n < SOLVE_BLOCKED_MIN ? n : SOLVE_BLOCK;
+}
+
+static void subRange(void* arg, size_t begin, size_t end) {
+        const sub_t* s = arg;
+        size_t c, r;
+
+        for(c = begin; c < end; c++) {
+                GLfloat* dst = s->C + (s->c0 + c) * s->ldc + s->r0;
+                const GLfloat* src = s->S + c * s->rows;
+
+                // In the lower triangle, rows start at the diagonal
+                for(r = s->lower ? c : 0; r < s->rows; r++) {
+                        dst[r] -= src[r];
+                }
+        }
+}
+
+/* C -= A * B, where A is m x k and B is k x n, one strip of columns at a
+   time through `scratch` (m x SOLVE_STRIP). If `lower`, C is square and
+   only its lower triangle is updated. `work` is GEMM workspace for `big`,
+   the pool used if the update is large enough. */
+static void gemmSub(size_t m, size_t n, size_t k,
+                    const GLfloat* A, size_t lda,
+                    const GLfloat* B, size_t ldb,
+                    GLfloat* C, size_t ldc,
+                    GLfloat* scratch, bool lower,
+                    pool_t* big, GLfloat* work) {
+        pool_t* pool = shared(big, m * n * k);
+        sub_t s;
+        size_t c0, w;
+
+        for(c0 = 0; c0 < n; c0 += SOLVE_STRIP) {
+                w = n - c0 < SOLVE_STRIP ? n - c0 : SOLVE_STRIP;
+
+                s.C = C;
+                s.ldc = ldc;
+                s.S = scratch;
+                s.r0 = lower ? c0 : 0;
+                s.c0 = c0;
+                s.rows = m - s.r0;
+                s.lower = lower;
+
+                ogllGemmWith(s.rows, w, k, A + s.r0, lda, B + c0 * ldb, ldb,
+                             scratch, s.rows, pool, work);
+                ogllPoolFor(pool, w, SOLVE_GRAIN, subRange, &s);
+        }
+}
+
+static void swapRows(matrix_t* a, size_t r1, size_t r2, size_t c0, size_t c1) {
+        GLfloat t;
+        size_t c;
+
+        for(c = c0; c < c1; c++) {
+                t = AT(a, r1, c);
+                AT(a, r1, c) = AT(a, r2, c);
+                AT(a, r2, c) = t;
+        }
+}
+
+// --- LU --- //
+
+/* Unblocked LU of rows k.., columns k..k+b */
+static void luPanel(matrix_t* a, size_t* piv, size_t k, size_t b) {
+        size_t n = a->rows;
+        size_t i, j, c, p;
+        GLfloat f;
+
+        for(j = k; j < k + b; j++) {
+                GLfloat* col = a->m + j * n;
+
+                p = j;
+                for(i = j + 1; i < n; i++) {
+                        if(fabsf(col[i]) > fabsf(col[p])) {
+                                p = i;
+                        }
+                }
+
+                piv[j] = p;
+                if(p != j) {
+                        swapRows(a, j, p, k, k + b);
+                }
+
+                if(col[j] != 0) {
+                        for(i = j + 1; i < n; i++) {
+                                col[i] /= col[j];
+                        }
+                }
+
+                for(c = j + 1; c < k + b; c++) {
+                        GLfloat* cc = a->m + c * n;
+
+                        f = cc[j];
+                        for(i = j + 1; i < n; i++) {
+                                cc[i] -= col[i] * f;
+                        }
+                }
+        }
+}
+
+typedef struct lustep_t {
+        matrix_t* a;
+        const size_t* piv;
+        size_t k, b;
+} lustep_t;
+
+/* Apply the panel's row swaps to columns [begin,end) outside it, then
+   solve those columns against its unit-lower L. */
+static void luRowsRange(void* arg, size_t begin, size_t end) {
+        const lustep_t* s = arg;
+        matrix_t* a = s->a;
+        size_t c, i, j;
+        GLfloat f;
+
+        for(c = begin; c < end; c++) {
+                // Columns of the panel are already done
+                if(c >= s->k && c < s->k + s->b) {
+                        continue;
+                }
+
+                for(j = s->k; j < s->k + s->b; j++) {
+                        if(s->piv[j] != j) {
+                                swapRows(a, j, s->piv[j], c, c + 1);
+                        }
+                }
+
+                if(c >= s->k + s->b) {
+                        for(j = s->k; j < s->k + s->b; j++) {
+                                f = AT(a, j, c);
+                                for(i = j + 1; i < s->k + s->b; i++) {
+                                        AT(a, i, c) -= AT(a, i, j) * f;
+                                }
+                        }
+                }
+        }
+}
+
+/* Factor a square Matrix in place into LU */
+bool ogllMLUDecompose(matrix_t* a, size_t* piv) {
+        OGLL_PROBE();
+        pool_t* pool = ogllGemmPool();
+        GLfloat* scratch = NULL;
+        GLfloat* work = NULL;
+        lustep_t s;
+        size_t n, nb, k, b, rest;
+
+        check(a && piv, "Null argument given.");
+        check(a->rows == a->cols, "Matrix not square.");
+
+        n = a->rows;
+        nb = panelWidth(n);
+
+        if(nb < n) {
+                scratch = malloc((n * SOLVE_STRIP +
+                                  ogllGemmWorkspace(n, SOLVE_STRIP, nb, pool)) *
+                                 sizeof(GLfloat));
+                check_mem(scratch);
+                work = scratch + n * SOLVE_STRIP;
+        }
+
+        for(k = 0; k < n; k += nb) {
+                b = n - k < nb ? n - k : nb;
+                rest = n - k - b;
+
+                luPanel(a, piv, k, b);
+
+                s.a = a;
+                s.piv = piv;
+                s.k = k;
+                s.b = b;
+                ogllPoolFor(poolFor(n * b * rest), n, SOLVE_GRAIN, luRowsRange, &s);
+
+                // A22 -= L21 * U12
+                gemmSub(rest, rest, b,
+                        a->m + k * n + k + b, n,
+                        a->m + (k + b) * n + k, n,
+                        a->m + (k + b) * n + k + b, n,
+                        scratch, false, pool, work);
+        }
+
+        free(scratch);
+
+        return true;
+ error:
+        free(scratch);
+        return false;
+}
+
+static void luSolveRange(void* arg, size_t begin, size_t end) {
+        const rhs_t* s = arg;
+        const matrix_t* f = s->f;
+        size_t n = f->rows;
+        size_t c, i, j;
+        GLfloat t;
+
+        for(c = begin; c < end; c++) {
+                GLfloat* x = s->b->m + c * n;
+
+                for(j = 0; j < n; j++) {
+                        if(s->piv[j] != j) {
+                                t = x[j];
+                                x[j] = x[s->piv[j]];
+                                x[s->piv[j]] = t;
+                        }
+                }
+
+                for(j = 0; j < n; j++) {
+                        t = x[j];
+                        for(i = j + 1; i < n; i++) {
+                                x[i] -= AT(f, i, j) * t;
+                        }
+                }
+
+                for(j = n; j-- > 0;) {
+                        x[j] /= AT(f, j, j);
+                        t = x[j];
+                        for(i = 0; i < j; i++) {
+                                x[i] -= AT(f, i, j) * t;
+                        }
+                }
+        }
+}
+
+/* Solve AX = B given LU */
+bool ogllMLUSolve(matrix_t* lu, const size_t* piv, matrix_t* b) {
+        OGLL_PROBE();
+        rhs_t s = { lu, piv, NULL, b };
+        size_t i;
+
+        check(lu && piv && b, "Null argument given.");
+        check(lu->rows == lu->cols, "Matrix not square.");
+        check(b->rows == lu->rows, "Right-hand side is the wrong height.");
+
+        for(i = 0; i < lu->rows; i++) {
+                check(AT(lu, i, i) != 0, "Matrix is singular.");
+        }
+
+        ogllPoolFor(poolFor(lu->rows * lu->rows * b->cols), b->cols,
+                    SOLVE_GRAIN, luSolveRange, &s);
+
+        return true;
+ error:
+        return false;
+}
+
+// --- CHOLESKY --- //
+
+/* Unblocked Cholesky of rows k.., columns k..k+b */
+static bool cholPanel(matrix_t* a, size_t k, size_t b) {
+        size_t n = a->rows;
+        size_t i, j, c;
+        GLfloat d, f;
+
+        for(j = k; j < k + b; j++) {
+                GLfloat* col = a->m + j * n;
+
+                check(col[j] > 0, "Matrix not positive definite.");
+
+                d = sqrt(col[j]);
+                col[j] = d;
+                for(i = j + 1; i < n; i++) {
+                        col[i] /= d;
+                }
+
+                for(c = j + 1; c < k + b; c++) {
+                        GLfloat* cc = a->m + c * n;
+
+                        f = col[c];
+                        for(i = c; i < n; i++) {
+                                cc[i] -= col[i] * f;
+                        }
+                }
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* Factor a symmetric positive-definite Matrix in place into LL^T */
+bool ogllMCholeskyDecompose(matrix_t* a) {
+        OGLL_PROBE();
+        pool_t* pool = ogllGemmPool();
+        GLfloat* scratch = NULL;
+        GLfloat* lt = NULL;
+        GLfloat* work = NULL;
+        size_t n, nb, k, b, rest, i, j;
+
+        check(a, "Null Matrix given.");
+        check(a->rows == a->cols, "Matrix not square.");
+
+        n = a->rows;
+        nb = panelWidth(n);
+
+        if(nb < n) {
+                scratch = malloc((n * SOLVE_STRIP + nb * n +
+                                  ogllGemmWorkspace(n, SOLVE_STRIP, nb, pool)) *
+                                 sizeof(GLfloat));
+                check_mem(scratch);
+                lt = scratch + n * SOLVE_STRIP;
+                work = lt + nb * n;
+        }
+
+        for(k = 0; k < n; k += nb) {
+                b = n - k < nb ? n - k : nb;
+                rest = n - k - b;
+
+                check(cholPanel(a, k, b), "Cholesky failed at column %zu.", k);
+
+                if(rest == 0) {
+                        break;
+                }
+
+                // A22 -= L21 * L21^T, lower triangle only
+                for(i = 0; i < rest; i++) {
+                        for(j = 0; j < b; j++) {
+                                lt[i * b + j] = AT(a, k + b + i, k + j);
+                        }
+                }
+
+                gemmSub(rest, rest, b,
+                        a->m + k * n + k + b, n,
+                        lt, b,
+                        a->m + (k + b) * n + k + b, n,
+                        scratch, true, pool, work);
+        }
+
+        free(scratch);
+
+        return true;
+ error:
+        free(scratch);
+        return false;
+}
+
+static void cholSolveRange(void* arg, size_t begin, size_t end) {
+        const rhs_t* s = arg;
+        const matrix_t* f = s->f;
+        size_t n = f->rows;
+        size_t c, i, j;
+        GLfloat t;
+
+        for(c = begin; c < end; c++) {
+                GLfloat* x = s->b->m + c * n;
+
+                for(j = 0; j < n; j++) {
+                        x[j] /= AT(f, j, j);
+                        t = x[j];
+                        for(i = j + 1; i < n; i++) {
+                                x[i] -= AT(f, i, j) * t;
+                        }
+                }
+
+                for(j = n; j-- > 0;) {
+                        t = x[j];
+                        for(i = j + 1; i < n; i++) {
+                                t -= AT(f, i, j) * x[i];
+                        }
+                        x[j] = t / AT(f, j, j);
+                }
+        }
+}
+
+/* Solve AX = B given LL^T */
+bool ogllMCholeskySolve(matrix_t* l, matrix_t* b) {
+        OGLL_PROBE();
+        rhs_t s = { l, NULL, NULL, b };
+        size_t i;
+
+        check(l && b, "Null argument given.");
+        check(l->rows == l->cols, "Matrix not square.");
+        check(b->rows == l->rows, "Right-hand side is the wrong height.");
+
+        for(i = 0; i < l->rows; i++) {
+                check(AT(l, i, i) > 0, "Matrix not factored.");
+        }
+
+        ogllPoolFor(poolFor(l->rows * l->rows * b->cols), b->cols,
+                    SOLVE_GRAIN, cholSolveRange, &s);
+
+        return true;
+ error:
+        return false;
+}
+
+// --- QR --- //
+
+/* Reflect column j onto the axis, leaving beta on the diagonal and v
+   below it (with an implicit 1 on top). Yields tau, where
+   H = I - tau v v^T. */
+static GLfloat house(matrix_t* a, size_t j) {
+        GLfloat* col = a->m + j * a->rows;
+        GLfloat alpha = col[j];
+        GLdouble sigma = 0;
+        GLfloat norm, beta, tau;
+        size_t i;
+
+        for(i = j + 1; i < a->rows; i++) {
+                sigma += (GLdouble)col[i] * col[i];
+        }
+
+        if(sigma == 0) {
+                return 0;
+        }
+
+        norm = sqrt(alpha * (GLdouble)alpha + sigma);
+        beta = alpha > 0 ? -norm : norm;
+        tau = (beta - alpha) / beta;
+
+        for(i = j + 1; i < a->rows; i++) {
+                col[i] /= alpha - beta;
+        }
+        col[j] = beta;
+
+        return tau;
+}
+
+/* x -= tau v (v^T x), with v from column j of `a` */
+static void reflect(const matrix_t* a, size_t j, GLfloat tau, GLfloat* x) {
+        const GLfloat* v = a->m + j * a->rows;
+        GLfloat w = x[j];
+        size_t i;
+
+        for(i = j + 1; i < a->rows; i++) {
+                w += v[i] * x[i];
+        }
+        w *= tau;
+
+        x[j] -= w;
+        for(i = j + 1; i < a->rows; i++) {
+                x[i] -= w * v[i];
+        }
+}
+
+/* Unblocked QR of rows k.., columns k..k+b */
+static void qrPanel(matrix_t* a, GLfloat* tau, size_t k, size_t b) {
+        size_t j, c;
+
+        for(j = k; j < k + b; j++) {
+                tau[j] = house(a, j);
+
+                if(tau[j] != 0) {
+                        for(c = j + 1; c < k + b; c++) {
+                                reflect(a, j, tau[j], a->m + c * a->rows);
+                        }
+                }
+        }
+}
+
+/* Apply the panel at k to the columns after it, as one block reflection
+   I - V T^T V^T (compact WY). `w` has room for the pieces, and `work` is
+   GEMM workspace for `pool`. */
+static void qrUpdate(matrix_t* a, const GLfloat* tau, size_t k, size_t b,
+                     GLfloat* w, pool_t* pool, GLfloat* work) {
+        size_t m = a->rows;
+        size_t mk = m - k;
+        size_t n2 = a->cols - k - b;
+        GLfloat* v = w;                 // mk x b
+        GLfloat* vt = v + mk * b;       // b x mk
+        GLfloat* t = vt + b * mk;       // b x b, upper
+        GLfloat* y = t + b * b;         // b x n2
+        GLfloat* ty = y + b * n2;       // b x n2
+        GLfloat* strip = ty + b * n2;   // mk x SOLVE_STRIP
+        GLfloat* a2 = a->m + (k + b) * m + k;
+        size_t r, c, i, j;
+        GLfloat z;
+
+        for(c = 0; c < b; c++) {
+                for(r = 0; r < mk; r++) {
+                        v[c * mk + r] = r < c ? 0 : r == c ? 1 : AT(a, k + r, k + c);
+                        vt[r * b + c] = v[c * mk + r];
+                }
+        }
+
+        // T(0..i, i) = -tau_i T(0..i, 0..i) V(:, 0..i)^T v_i
+        for(i = 0; i < b; i++) {
+                for(j = 0; j < i; j++) {
+                        z = 0;
+                        for(r = i; r < mk; r++) {
+                                z += v[j * mk + r] * v[i * mk + r];
+                        }
+                        ty[j] = z;
+                }
+
+                for(j = 0; j < i; j++) {
+                        z = 0;
+                        for(r = j; r < i; r++) {
+                                z += t[r * b + j] * ty[r];
+                        }
+                        t[i * b + j] = -tau[k + i] * z;
+                }
+
+                t[i * b + i] = tau[k + i];
+                for(j = i + 1; j < b; j++) {
+                        t[i * b + j] = 0;
+                }
+        }
+
+        // Y = V^T A2, then T^T Y, then A2 -= V (T^T Y)
+        ogllGemmWith(b, n2, mk, vt, b, a2, m, y, b, shared(pool, b * n2 * mk), work);
+
+        for(c = 0; c < n2; c++) {
+                for(i = 0; i < b; i++) {
+                        z = 0;
+                        for(j = 0; j <= i; j++) {
+                                z += t[i * b + j] * y[c * b + j];
+                        }
+                        ty[c * b + i] = z;
+                }
+        }
+
+        gemmSub(mk, n2, b, v, mk, ty, b, a2, m, strip, false, pool, work);
+}
+
+/* Factor a Matrix with rows >= cols in place into QR */
+bool ogllMQRDecompose(matrix_t* a, GLfloat* tau) {
+        OGLL_PROBE();
+        pool_t* pool = ogllGemmPool();
+        GLfloat* scratch = NULL;
+        GLfloat* work = NULL;
+        size_t m, n, nb, k, b, pieces, ws;
+
+        check(a && tau, "Null argument given.");
+        check(a->rows >= a->cols, "Matrix has more columns than rows.");
+
+        m = a->rows;
+        n = a->cols;
+        nb = panelWidth(n);
+
+        if(nb < n) {
+                // Workspace for both GEMMs in `qrUpdate`
+                pieces = 2 * m * nb + nb * nb + 2 * nb * n + m * SOLVE_STRIP;
+                ws = ogllGemmWorkspace(nb, n, m, pool);
+                if(ws < ogllGemmWorkspace(m, SOLVE_STRIP, nb, pool)) {
+                        ws = ogllGemmWorkspace(m, SOLVE_STRIP, nb, pool);
+                }
+
+                scratch = malloc((pieces + ws) * sizeof(GLfloat));
+                check_mem(scratch);
+                work = scratch + pieces;
+        }
+
+        for(k = 0; k < n; k += nb) {
+                b = n - k < nb ? n - k : nb;
+
+                qrPanel(a, tau, k, b);
+
+                if(k + b < n) {
+                        qrUpdate(a, tau, k, b, scratch, pool, work);
+                }
+        }
+
+        free(scratch);
+
+        return true;
+ error:
+        free(scratch);
+        return false;
+}
+
+static void qrSolveRange(void* arg, size_t begin, size_t end) {
+        const rhs_t* s = arg;
+        const matrix_t* f = s->f;
+        size_t n = f->cols;
+        size_t c, i, j;
+        GLfloat t;
+
+        for(c = begin; c < end; c++) {
+                GLfloat* x = s->b->m + c * f->rows;
+
+                for(j = 0; j < n; j++) {
+                        if(s->tau[j] != 0) {
+                                reflect(f, j, s->tau[j], x);
+                        }
+                }
+
+                for(j = n; j-- > 0;) {
+                        x[j] /= AT(f, j, j);
+                        t = x[j];
+                        for(i = 0; i < j; i++) {
+                                x[i] -= AT(f, i, j) * t;
+                        }
+                }
+        }
+}
+
+/* Least-squares solution of AX = B given QR */
+bool ogllMQRSolve(matrix_t* qr, const GLfloat* tau, matrix_t* b) {
+        OGLL_PROBE();
+        rhs_t s = { qr, NULL, tau, b };
+        size_t i;
+
+        check(qr && tau && b, "Null argument given.");
+        check(qr->rows >= qr->cols, "Matrix has more columns than rows.");
+        check(b->rows == qr->rows, "Right-hand side is the wrong height.");
+
+        for(i = 0; i < qr->cols; i++) {
+                check(AT(qr, i, i) != 0, "Matrix is rank deficient.");
+        }
+
+        ogllPoolFor(poolFor(qr->rows * qr->cols * b->cols), b->cols,
+                    SOLVE_GRAIN, qrSolveRange, &s);
+
+        return true;
+ error:
+        return false;
+}
+
+// --- CONVENIENCE --- //
+
+/* The determinant of a square Matrix */
+GLfloat ogllMDeterminant(matrix_t* m) {
+        OGLL_PROBE();
+        matrix_t* lu = NULL;
+        size_t* piv = NULL;
+        GLdouble det = 1;
+        size_t i;
+
+        check(m, "Null Matrix given.");
+        check(m->rows == m->cols, "Matrix not square.");
+
+        lu = ogllMCopy(m);
+        piv = malloc(m->rows * sizeof(size_t));
+        check_mem(lu && piv);
+        check(ogllMLUDecompose(lu, piv), "LU failed.");
+
+        for(i = 0; i < m->rows; i++) {
+                det *= AT(lu, i, i);
+                if(piv[i] != i) {
+                        det = -det;
+                }
+        }
+
+        ogllMDestroy(lu);
+        free(piv);
+
+        return det;
+ error:
+        ogllMDestroy(lu);
+        free(piv);
+        return 0;
+}
+
+/* The inverse of a square Matrix */
+matrix_t* ogllMInverseP(matrix_t* m) {
+        OGLL_PROBE();
+        matrix_t* lu = NULL;
+        matrix_t* inv = NULL;
+        size_t* piv = NULL;
+
+        check(m, "Null Matrix given.");
+        check(m->rows == m->cols, "Matrix not square.");
+
+        lu = ogllMCopy(m);
+        inv = ogllMIdentity(m->rows);
+        piv = malloc(m->rows * sizeof(size_t));
+        check_mem(lu && inv && piv);
+
+        check(ogllMLUDecompose(lu, piv), "LU failed.");
+        check(ogllMLUSolve(lu, piv, inv), "Matrix has no inverse.");
+
+        ogllMDestroy(lu);
+        free(piv);
+
+        return inv;
+ error:
+        ogllMDestroy(lu);
+        ogllMDestroy(inv);
+        free(piv);
+        return NULL;
+}
+
+/* The solution X of AX = B */
+matrix_t* ogllMSolveP(matrix_t* a, matrix_t* b) {
+        OGLL_PROBE();
+        matrix_t* f = NULL;
+        matrix_t* x = NULL;
+        matrix_t* out = NULL;
+        void* aux = NULL;
+        size_t c;
+
+        check(a && b, "Null Matrices given.");
+        check(a->rows == b->rows, "Right-hand side is the wrong height.");
+        check(a->rows >= a->cols, "Underdetermined system.");
+
+        f = ogllMCopy(a);
+        x = ogllMCopy(b);
+        check_mem(f && x);
+
+        if(a->rows == a->cols) {
+                aux = malloc(a->rows * sizeof(size_t));
+                check_mem(aux);
+                check(ogllMLUDecompose(f, aux), "LU failed.");
+                check(ogllMLUSolve(f, aux, x), "Matrix is singular.");
+
+                out = x;
+                x = NULL;
+        } else {
+                aux = malloc(a->cols * sizeof(GLfloat));
+                check_mem(aux);
+                check(ogllMQRDecompose(f, aux), "QR failed.");
+                check(ogllMQRSolve(f, aux, x), "Matrix is rank deficient.");
+
+                // The solution is the top of each column
+                out = ogllMCreate(b->cols, a->cols);
+                check_mem(out);
+                for(c = 0; c < b->cols; c++) {
+                        memcpy(out->m + c * a->cols, x->m + c * x->rows,
+                               a->cols * sizeof(GLfloat));
+                }
+        }
+
+        ogllMDestroy(f);
+        ogllMDestroy(x);
+        free(aux);
+
+        return out;
+ error:
+        ogllMDestroy(f);
+        ogllMDestroy(x);
+        free(aux);
+        return NULL;
+}
@@ -0,0 +1,84 @@
+#ifndef __ogll_solve__
+#define __ogll_solve__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "opengl-linalg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Factorizations of general Matrices, and the solvers built on them.
+ *
+ * Each factorization works in place on the column-major `matrix_t`
+ * layout, as LAPACK's do:
+ *
+ *   LU        PA = LU with partial pivoting. Unit-diagonal L below the
+ *             diagonal, U on and above it, plus the row swaps.
+ *   Cholesky  A = LL^T for symmetric positive-definite A. L on and below
+ *             the diagonal. The upper triangle is not touched.
+ *   QR        A = QR by Householder reflections, for rows >= cols. R on
+ *             and above the diagonal, the reflections below it, plus
+ *             their scale factors.
+ *
+ * Large Matrices are done in column panels, with the trailing update of
+ * each step going through the cache-blocked GEMM (see gemm.h). Updates
+ * big enough to pay for it are spread over the pool given to
+ * `ogllGemmSetPool`. The results don't depend on the pool. The GEMM
+ * workspace is allocated once per factorization, along with the rest of
+ * the scratch space.
+ *
+ * Matrices hold floats, so expect a relative error around 1e-7 times the
+ * condition number.
+ */
+
+// --- DECOMPOSITIONS --- //
+
+/* Factor a square Matrix in place into LU. `piv` gets one entry per row:
+   row i was swapped with row piv[i], in order. A singular Matrix still
+   factors, with a 0 on the diagonal of U. */
+bool ogllMLUDecompose(matrix_t* a, size_t* piv);
+
+/* Factor a symmetric positive-definite Matrix in place into LL^T, reading
+   only the lower triangle. Fails if it isn't positive definite. */
+bool ogllMCholeskyDecompose(matrix_t* a);
+
+/* Factor a Matrix with rows >= cols in place into QR. `tau` gets one
+   entry per column. */
+bool ogllMQRDecompose(matrix_t* a, GLfloat* tau);
+
+// --- SOLVERS --- //
+
+/* Overwrite `b` (one right-hand side per column) with the solution of
+   AX = B, given A factored by `ogllMLUDecompose`. Fails if A is
+   singular. */
+bool ogllMLUSolve(matrix_t* lu, const size_t* piv, matrix_t* b);
+
+/* As above, given A factored by `ogllMCholeskyDecompose` */
+bool ogllMCholeskySolve(matrix_t* l, matrix_t* b);
+
+/* Least-squares solution of AX = B, given A factored by
+   `ogllMQRDecompose`. `b` has as many rows as A, and the solution is
+   left in its first A->cols rows. Fails if A is rank deficient. */
+bool ogllMQRSolve(matrix_t* qr, const GLfloat* tau, matrix_t* b);
+
+// --- CONVENIENCE --- //
+
+/* The determinant of a square Matrix, by LU on a copy. 0 if it fails. */
+GLfloat ogllMDeterminant(matrix_t* m);
+
+/* The inverse of a square Matrix. NULL if it is singular. */
+matrix_t* ogllMInverseP(matrix_t* m);
+
+/* The solution X of AX = B, as a new Matrix. Square A is solved by LU,
+   and taller A in the least-squares sense by QR. Neither input is
+   changed. */
+matrix_t* ogllMSolveP(matrix_t* a, matrix_t* b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
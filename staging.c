@@ -0,0 +1,331 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "staging.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+#define ROUND_UP(n, a) (((n) + (a) - 1) & ~(size_t)((a) - 1))
+
+// --- MEMORY --- //
+
+static void* memoryMap(void* ctx, size_t size) {
+        void* p = NULL;
+
+        (void)ctx;
+
+        return posix_memalign(&p, OGLL_STAGING_MAX_ALIGN, size) == 0 ? p : NULL;
+}
+
+static void memoryUnmap(void* ctx, void* p) {
+        (void)ctx;
+        free(p);
+}
+
+static const staging_backend_t memory = {
+        memoryMap, memoryUnmap, NULL, NULL, NULL, NULL
+};
+
+/* Plain aligned memory */
+const staging_backend_t* ogllStagingMemory(void) {
+        OGLL_PROBE();
+        return &memory;
+}
+
+// --- STAGES --- //
+
+/* Create a Stage of `frames` frames of at least `frameSize` bytes each */
+staging_t* ogllStagingCreate(size_t frameSize, size_t frames,
+                             const staging_backend_t* backend) {
+        OGLL_PROBE();
+        staging_t* s = NULL;
+
+        check(frameSize > 0, "Empty frames requested.");
+        check(frames >= 1 && frames <= OGLL_STAGING_MAX_FRAMES,
+              "Bad frame count: %zu", frames);
+
+        s = calloc(1, sizeof(staging_t));
+        check_mem(s);
+
+        // Every frame starts at the strictest alignment a push can ask for.
+        s->frameSize = ROUND_UP(frameSize, OGLL_STAGING_MAX_ALIGN);
+        s->frames = frames;
+        s->frame = frames - 1;  // So the first `Begin` lands on frame 0
+        s->backend = backend ? backend : &memory;
+
+        s->base = s->backend->map(s->backend->ctx, s->frameSize * frames);
+        check(s->base, "Couldn't map %zu bytes.", s->frameSize * frames);
+
+        return s;
+ error:
+        free(s);
+        return NULL;
+}
+
+/* Deallocate a Stage */
+void ogllStagingDestroy(staging_t* s) {
+        OGLL_PROBE();
+        size_t f;
+
+        if(s) {
+                if(s->backend->wait) {
+                        for(f = 0; f < s->frames; f++) {
+                                s->backend->wait(s->backend->ctx, f);
+                        }
+                }
+
+                s->backend->unmap(s->backend->ctx, s->base);
+                free(s);
+        }
+}
+
+/* Move on to the next frame and empty it */
+bool ogllStagingBegin(staging_t* s) {
+        OGLL_PROBE();
+        check(s, "Null Stage given.");
+        check(!s->open, "Previous frame never ended.");
+
+        s->frame = (s->frame + 1) % s->frames;
+
+        if(s->backend->wait) {
+                s->backend->wait(s->backend->ctx, s->frame);
+        }
+
+        s->head = 0;
+        s->open = true;
+
+        return true;
+ error:
+        return false;
+}
+
+/* Fence the current frame */
+size_t ogllStagingEnd(staging_t* s) {
+        OGLL_PROBE();
+        check(s, "Null Stage given.");
+        check(s->open, "No frame begun.");
+
+        if(s->backend->flush && s->head > 0) {
+                s->backend->flush(s->backend->ctx, s->frame * s->frameSize, s->head);
+        }
+
+        if(s->backend->fence) {
+                s->backend->fence(s->backend->ctx, s->frame);
+        }
+
+        s->open = false;
+
+        return s->head;
+ error:
+        return 0;
+}
+
+/* Reserve `bytes` in the current frame */
+void* ogllStagingAlloc(staging_t* s, size_t bytes, size_t align,
+                       size_t* offset) {
+        OGLL_PROBE();
+        size_t start;
+
+        check(s, "Null Stage given.");
+        check(s->open, "No frame begun.");
+        check(align > 0 && (align & (align - 1)) == 0 &&
+              align <= OGLL_STAGING_MAX_ALIGN, "Bad alignment: %zu", align);
+
+        start = ROUND_UP(s->head, align);
+        check(start <= s->frameSize && bytes <= s->frameSize - start,
+              "Staging frame full.");
+
+        s->head = start + bytes;
+
+        if(offset) {
+                *offset = s->frame * s->frameSize + start;
+        }
+
+        return s->base + s->frame * s->frameSize + start;
+ error:
+        return NULL;
+}
+
+/* Pack `count` 4x4 heap Matrices as mat4[count] */
+bool ogllStagingPushMatrices(staging_t* s, matrix_t** ms, size_t count,
+                             size_t align, size_t* offset) {
+        OGLL_PROBE();
+        GLfloat* out;
+        size_t i;
+
+        check(ms || count == 0, "Null Matrices given.");
+        check(count <= SIZE_MAX / sizeof(mat4_t), "Too many Matrices to stage.");
+
+        // Check everything before reserving, so a failure leaves no gap.
+        for(i = 0; i < count; i++) {
+                check(ms[i] && ms[i]->cols == 4 && ms[i]->rows == 4,
+                      "Matrix %zu not 4x4.", i);
+        }
+
+        out = ogllStagingAlloc(s, count * sizeof(mat4_t), align, offset);
+        check(out, "Couldn't stage %zu Matrices.", count);
+
+        for(i = 0; i < count; i++) {
+                memcpy(out + 16 * i, ms[i]->m, 16 * sizeof(GLfloat));
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* Pack `count` 4x4 values as mat4[count] */
+bool ogllStagingPushMat4s(staging_t* s, const mat4_t* ms, size_t count,
+                          size_t align, size_t* offset) {
+        OGLL_PROBE();
+        void* out;
+
+        check(ms || count == 0, "Null Matrices given.");
+        check(count <= SIZE_MAX / sizeof(mat4_t), "Too many Matrices to stage.");
+
+        out = ogllStagingAlloc(s, count * sizeof(mat4_t), align, offset);
+        check(out, "Couldn't stage %zu Matrices.", count);
+
+        // mat4_t is already the std140 layout.
+        memcpy(out, ms, count * sizeof(mat4_t));
+
+        return true;
+ error:
+        return false;
+}
+
+/* Pack the upper 3x3 of `count` 4x4 values as mat3[count] */
+bool ogllStagingPushMat3s(staging_t* s, const mat4_t* ms, size_t count,
+                          size_t align, size_t* offset) {
+        OGLL_PROBE();
+        GLfloat* out;
+        size_t i,j;
+
+        check(ms || count == 0, "Null Matrices given.");
+        check(count <= SIZE_MAX / (12 * sizeof(GLfloat)), "Too many Matrices to stage.");
+
+        out = ogllStagingAlloc(s, count * 12 * sizeof(GLfloat), align, offset);
+        check(out, "Couldn't stage %zu Matrices.", count);
+
+        for(i = 0; i < count; i++) {
+                for(j = 0; j < 3; j++) {
+                        out[12 * i + 4 * j]     = ms[i].m[4 * j];
+                        out[12 * i + 4 * j + 1] = ms[i].m[4 * j + 1];
+                        out[12 * i + 4 * j + 2] = ms[i].m[4 * j + 2];
+                        out[12 * i + 4 * j + 3] = 0;
+                }
+        }
+
+        return true;
+ error:
+        return false;
+}
+
+/* Start and used size of the current frame */
+const void* ogllStagingFrame(staging_t* s, size_t* offset, size_t* used) {
+        OGLL_PROBE();
+        check(s, "Null Stage given.");
+
+        if(offset) {
+                *offset = s->frame * s->frameSize;
+        }
+
+        if(used) {
+                *used = s->head;
+        }
+
+        return s->base + s->frame * s->frameSize;
+ error:
+        return NULL;
+}
+
+// --- GL --- //
+
+#ifdef OGLL_STAGING_GL
+
+#define MAP_FLAGS (GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+
+static void* persistentMap(void* ctx, size_t size) {
+        staging_gl_t* gl = ctx;
+        void* p;
+
+        glGenBuffers(1, &gl->buffer);
+        glBindBuffer(gl->target, gl->buffer);
+        glBufferStorage(gl->target, size, NULL, MAP_FLAGS);
+        p = glMapBufferRange(gl->target, 0, size, MAP_FLAGS);
+
+        if(!p) {
+                glDeleteBuffers(1, &gl->buffer);
+                gl->buffer = 0;
+        }
+
+        return p;
+}
+
+static void persistentUnmap(void* ctx, void* p) {
+        staging_gl_t* gl = ctx;
+        size_t f;
+
+        (void)p;
+
+        for(f = 0; f < OGLL_STAGING_MAX_FRAMES; f++) {
+                if(gl->fences[f]) {
+                        glDeleteSync(gl->fences[f]);
+                        gl->fences[f] = 0;
+                }
+        }
+
+        glBindBuffer(gl->target, gl->buffer);
+        glUnmapBuffer(gl->target);
+        glDeleteBuffers(1, &gl->buffer);
+        gl->buffer = 0;
+}
+
+static void persistentFence(void* ctx, size_t frame) {
+        staging_gl_t* gl = ctx;
+
+        if(gl->fences[frame]) {
+                glDeleteSync(gl->fences[frame]);
+        }
+
+        gl->fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+static void persistentWait(void* ctx, size_t frame) {
+        staging_gl_t* gl = ctx;
+        GLenum r;
+
+        if(gl->fences[frame]) {
+                do {
+                        r = glClientWaitSync(gl->fences[frame],
+                                             GL_SYNC_FLUSH_COMMANDS_BIT,
+                                             1000000000);
+                } while(r == GL_TIMEOUT_EXPIRED);
+
+                glDeleteSync(gl->fences[frame]);
+                gl->fences[frame] = 0;
+        }
+}
+
+/* Set up `gl` for `target` */
+const staging_backend_t* ogllStagingGL(staging_gl_t* gl, GLenum target) {
+        OGLL_PROBE();
+        check(gl, "Null GL backing given.");
+
+        memset(gl, 0, sizeof(staging_gl_t));
+        gl->target = target;
+        gl->backend.map = persistentMap;
+        gl->backend.unmap = persistentUnmap;
+        gl->backend.fence = persistentFence;
+        gl->backend.wait = persistentWait;
+        gl->backend.ctx = gl;
+
+        return &gl->backend;
+ error:
+        return NULL;
+}
+
+#endif
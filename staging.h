@@ -0,0 +1,132 @@
+#ifndef __ogll_staging__
+#define __ogll_staging__
+
+#include <GL/glew.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "opengl-linalg.h"
+#include "value.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Batched upload of Matrices through a ring of staging frames.
+ *
+ * A Stage is one buffer cut into 1 to OGLL_STAGING_MAX_FRAMES frames,
+ * usually 2 or 3 to keep the GPU busy. Each frame, `Begin` moves
+ * on to the next one (waiting until the GPU is done with it), the `Push`
+ * calls pack Matrices back to back, and `End` fences the frame. Every
+ * push yields a byte offset into the whole buffer, ready for
+ * `glBindBufferRange`.
+ *
+ * Packing follows std140 and std430, which agree for Matrices. Arrays of
+ * mat4 have a 64-byte stride and arrays of mat3 a 48-byte stride (each
+ * column padded to a vec4). Each push can start at a larger alignment, e.g.
+ * GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, up to OGLL_STAGING_MAX_ALIGN.
+ *
+ * Where the bytes live is up to a backend. The default is plain memory,
+ * to be copied into a UBO/SSBO with one `glBufferSubData` per frame and
+ * testable without a GL context. Built with -DOGLL_STAGING_GL, a
+ * persistently mapped GL buffer is also available and pushes write
+ * straight into it.
+ *
+ * A Stage is not thread-safe. Use one per rendering thread.
+ */
+
+// --- //
+
+#define OGLL_STAGING_MAX_FRAMES 4
+#define OGLL_STAGING_MAX_ALIGN  256
+
+typedef struct staging_backend_t {
+        /* Return `size` writable bytes, or NULL. Offsets handed out by
+           the Stage count from the start of this block. */
+        void* (*map)(void* ctx, size_t size);
+        /* Release what `map` returned */
+        void (*unmap)(void* ctx, void* p);
+        /* The GPU's reads of `frame` have been queued. May be NULL. */
+        void (*fence)(void* ctx, size_t frame);
+        /* Block until the GPU is done reading `frame`. May be NULL. */
+        void (*wait)(void* ctx, size_t frame);
+        /* Bytes [offset, offset + size) were written. May be NULL. */
+        void (*flush)(void* ctx, size_t offset, size_t size);
+        void* ctx;
+} staging_backend_t;
+
+typedef struct staging_t {
+        char* base;
+        size_t frameSize;
+        size_t frames;
+        size_t frame;      // Frame being written
+        size_t head;       // Bytes used in that frame
+        bool open;         // Between `Begin` and `End`?
+        const staging_backend_t* backend;
+} staging_t;
+
+/* Plain aligned memory. Never waits, since nothing reads it behind your
+   back. */
+const staging_backend_t* ogllStagingMemory(void);
+
+/* Create a Stage of `frames` (1 to OGLL_STAGING_MAX_FRAMES) frames of at
+   least `frameSize` bytes each. A NULL backend means plain memory. */
+staging_t* ogllStagingCreate(size_t frameSize, size_t frames,
+                             const staging_backend_t* backend);
+
+/* Deallocate a Stage. Waits on every frame first. */
+void ogllStagingDestroy(staging_t* s);
+
+/* Move on to the next frame and empty it */
+bool ogllStagingBegin(staging_t* s);
+
+/* Fence the current frame. Yields the bytes used in it. */
+size_t ogllStagingEnd(staging_t* s);
+
+/* Reserve `bytes` in the current frame, starting at a multiple of
+   `align` (a power of two). Yields where to write, or NULL if the frame
+   is full. `offset` gets the byte offset into the whole buffer. */
+void* ogllStagingAlloc(staging_t* s, size_t bytes, size_t align,
+                       size_t* offset);
+
+/* Pack `count` 4x4 heap Matrices as mat4[count] */
+bool ogllStagingPushMatrices(staging_t* s, matrix_t** ms, size_t count,
+                             size_t align, size_t* offset);
+
+/* Pack `count` 4x4 values as mat4[count], in one copy */
+bool ogllStagingPushMat4s(staging_t* s, const mat4_t* ms, size_t count,
+                          size_t align, size_t* offset);
+
+/* Pack the upper 3x3 of `count` 4x4 values as mat3[count], e.g. for
+   normal Matrices */
+bool ogllStagingPushMat3s(staging_t* s, const mat4_t* ms, size_t count,
+                          size_t align, size_t* offset);
+
+/* Start and used size of the current frame, for one `glBufferSubData` */
+const void* ogllStagingFrame(staging_t* s, size_t* offset, size_t* used);
+
+// --- GL --- //
+
+#ifdef OGLL_STAGING_GL
+
+/* Backing for a persistently and coherently mapped buffer bound to
+   `target` (e.g. GL_UNIFORM_BUFFER). Needs GL 4.4 or
+   ARB_buffer_storage, and a current context on the calling thread. */
+typedef struct staging_gl_t {
+        GLuint buffer;
+        GLenum target;
+        GLsync fences[OGLL_STAGING_MAX_FRAMES];
+        staging_backend_t backend;
+} staging_gl_t;
+
+/* Set up `gl` for `target`. Yields its backend for `ogllStagingCreate`.
+   `gl` must outlive the Stage. `gl->buffer` is valid once it's created. */
+const staging_backend_t* ogllStagingGL(staging_gl_t* gl, GLenum target);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "store.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+#define STORE_ORDER 0x01020304u
+
+struct store_writer_t {
+        FILE* f;
+        uint64_t pos;
+        uint64_t count;
+        store_run_t* runs;
+        size_t nruns;
+        size_t capacity;
+        bool failed;
+};
+
+/* Is every run where the header says, in order, and inside the file
+   between the header and the run table, with none overlapping? */
+static bool validRuns(const store_t* s) {
+        const store_header_t* h = s->header;
+        uint64_t next = 0;
+        uint64_t end = sizeof(store_header_t);
+        uint64_t i, bytes;
+
+        for(i = 0; i < h->runs; i++) {
+                const store_run_t* r = &s->runs[i];
+
+                check(r->cols > 0 && r->rows > 0, "Run %llu has no shape.",
+                      (unsigned long long)i);
+                check(r->rows <= UINT64_MAX / sizeof(GLfloat) / r->cols,
+                      "Run %llu has an impossible shape.", (unsigned long long)i);
+                check(r->first == next, "Run %llu is out of order.",
+                      (unsigned long long)i);
+                check(r->offset % OGLL_STORE_ALIGN == 0 &&
+                      r->offset >= end && r->offset <= h->table,
+                      "Run %llu is misplaced.", (unsigned long long)i);
+
+                bytes = (uint64_t)r->cols * r->rows * sizeof(GLfloat);
+                check(r->count <= (h->table - r->offset) / bytes,
+                      "Run %llu runs into the run table.", (unsigned long long)i);
+
+                next += r->count;
+                end = r->offset + r->count * bytes;
+        }
+
+        check(next == h->count, "Runs don't add up to the Matrix count.");
+
+        return true;
+ error:
+        return false;
+}
+
+// --- READING --- //
+
+/* Map a store file */
+store_t* ogllStoreOpen(const char* path) {
+        OGLL_PROBE();
+        store_t* s = NULL;
+        struct stat st;
+        int fd = -1;
+        const store_header_t* h;
+
+        check(path, "Null path given.");
+
+        s = calloc(1, sizeof(store_t));
+        check_mem(s);
+
+        fd = open(path, O_RDONLY);
+        check(fd >= 0, "Can't open %s.", path);
+        check(fstat(fd, &st) == 0, "Can't stat %s.", path);
+        check((uint64_t)st.st_size >= sizeof(store_header_t), "%s is too short.", path);
+
+        s->size = st.st_size;
+        s->base = mmap(NULL, s->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        check(s->base != MAP_FAILED, "Can't map %s.", path);
+        close(fd);
+        fd = -1;
+
+        h = s->header = s->base;
+        check(memcmp(h->magic, OGLL_STORE_MAGIC, 8) == 0,
+              "%s isn't a finished store.", path);
+        check(h->version >= 1 && h->version <= OGLL_STORE_VERSION,
+              "%s has unsupported version %u.", path, h->version);
+        check(h->order == STORE_ORDER, "%s was written with another byte order.", path);
+        check(h->size == s->size, "%s is truncated.", path);
+        check(h->table % sizeof(uint64_t) == 0 &&
+              h->table >= sizeof(store_header_t) && h->table <= s->size &&
+              h->runs <= (s->size - h->table) / sizeof(store_run_t),
+              "%s has a bad run table.", path);
+
+        s->runs = (const store_run_t*)((const char*)s->base + h->table);
+        check(validRuns(s), "%s has bad runs.", path);
+
+        return s;
+ error:
+        if(fd >= 0) {
+                close(fd);
+        }
+        if(s && s->base && s->base != MAP_FAILED) {
+                munmap(s->base, s->size);
+        }
+        free(s);
+        return NULL;
+}
+
+/* Unmap a store */
+void ogllStoreClose(store_t* s) {
+        OGLL_PROBE();
+        if(s) {
+                munmap(s->base, s->size);
+                free(s);
+        }
+}
+
+/* Number of Matrices in a store */
+size_t ogllStoreCount(const store_t* s) {
+        OGLL_PROBE();
+        return s ? s->header->count : 0;
+}
+
+/* A view of Matrix `i` */
+matrix_t ogllStoreView(const store_t* s, size_t i) {
+        OGLL_PROBE();
+        matrix_t v = { NULL, 0, 0, NULL };
+        const store_run_t* r;
+        size_t lo, hi, mid;
+
+        check(s, "Null store given.");
+        check(i < s->header->count, "Matrix %zu out of range.", i);
+
+        // The last run starting at or before `i`
+        lo = 0;
+        hi = s->header->runs;
+        while(hi - lo > 1) {
+                mid = lo + (hi - lo) / 2;
+
+                if(s->runs[mid].first <= i) {
+                        lo = mid;
+                } else {
+                        hi = mid;
+                }
+        }
+
+        r = &s->runs[lo];
+        v.cols = r->cols;
+        v.rows = r->rows;
+        v.m = (GLfloat*)((char*)s->base + r->offset) + (i - r->first) * v.cols * v.rows;
+
+        return v;
+ error:
+        return v;
+}
+
+/* Number of runs in a store */
+size_t ogllStoreRuns(const store_t* s) {
+        OGLL_PROBE();
+        return s ? s->header->runs : 0;
+}
+
+/* The packed data of run `r` */
+GLfloat* ogllStoreRunData(const store_t* s, size_t r, store_run_t* run) {
+        OGLL_PROBE();
+        check(s && run, "Null argument given.");
+        check(r < s->header->runs, "Run %zu out of range.", r);
+
+        *run = s->runs[r];
+
+        return (GLfloat*)((char*)s->base + run->offset);
+ error:
+        return NULL;
+}
+
+// --- WRITING --- //
+
+static bool put(store_writer_t* w, const void* data, size_t bytes) {
+        if(!w->failed && bytes > 0 && fwrite(data, 1, bytes, w->f) != bytes) {
+                w->failed = true;
+        }
+        w->pos += bytes;
+
+        return !w->failed;
+}
+
+/* Zeroes up to the next OGLL_STORE_ALIGN boundary */
+static bool pad(store_writer_t* w) {
+        static const char zeros[OGLL_STORE_ALIGN];
+
+        return put(w, zeros, (OGLL_STORE_ALIGN - w->pos % OGLL_STORE_ALIGN) % OGLL_STORE_ALIGN);
+}
+
+/* Start writing a store file */
+store_writer_t* ogllStoreWriterOpen(const char* path) {
+        OGLL_PROBE();
+        store_writer_t* w = NULL;
+        store_header_t blank;
+
+        check(path, "Null path given.");
+
+        w = calloc(1, sizeof(store_writer_t));
+        check_mem(w);
+
+        w->f = fopen(path, "wb");
+        check(w->f, "Can't create %s.", path);
+
+        // Stays zeroed, and so unreadable, until the writer is closed
+        memset(&blank, 0, sizeof(blank));
+        check(put(w, &blank, sizeof(blank)), "Can't write to %s.", path);
+
+        return w;
+ error:
+        if(w && w->f) {
+                fclose(w->f);
+        }
+        free(w);
+        return NULL;
+}
+
+/* Append `count` Matrices of the same shape */
+bool ogllStoreWriteArray(store_writer_t* w, size_t cols, size_t rows,
+                         const GLfloat* fs, size_t count) {
+        OGLL_PROBE();
+        store_run_t* last;
+        store_run_t* runs;
+
+        check(w && (fs || count == 0), "Null argument given.");
+        check(cols > 0 && rows > 0 && cols <= UINT32_MAX && rows <= UINT32_MAX,
+              "Bad Matrix shape.");
+        check(!w->failed, "Writer already failed.");
+
+        if(count == 0) {
+                return true;
+        }
+
+        last = w->nruns > 0 ? &w->runs[w->nruns - 1] : NULL;
+
+        if(!last || last->cols != cols || last->rows != rows) {
+                if(w->nruns == w->capacity) {
+                        w->capacity = w->capacity ? 2 * w->capacity : 8;
+                        runs = realloc(w->runs, w->capacity * sizeof(store_run_t));
+                        check_mem(runs);
+                        w->runs = runs;
+                }
+
+                check(pad(w), "Write failed.");
+
+                last = &w->runs[w->nruns++];
+                last->first = w->count;
+                last->count = 0;
+                last->offset = w->pos;
+                last->cols = cols;
+                last->rows = rows;
+        }
+
+        check(put(w, fs, count * cols * rows * sizeof(GLfloat)), "Write failed.");
+
+        last->count += count;
+        w->count += count;
+
+        return true;
+ error:
+        if(w) {
+                w->failed = true;
+        }
+        return false;
+}
+
+/* Append a Matrix */
+bool ogllStoreWrite(store_writer_t* w, matrix_t* m) {
+        OGLL_PROBE();
+        check(m, "Null Matrix given.");
+
+        return ogllStoreWriteArray(w, m->cols, m->rows, m->m, 1);
+ error:
+        return false;
+}
+
+/* Write the index and finish the file */
+bool ogllStoreWriterClose(store_writer_t* w) {
+        OGLL_PROBE();
+        store_header_t h;
+        bool ok;
+
+        check(w, "Null writer given.");
+
+        memset(&h, 0, sizeof(h));
+        pad(w);
+        h.table = w->pos;
+        put(w, w->runs, w->nruns * sizeof(store_run_t));
+
+        memcpy(h.magic, OGLL_STORE_MAGIC, 8);
+        h.version = OGLL_STORE_VERSION;
+        h.order = STORE_ORDER;
+        h.count = w->count;
+        h.runs = w->nruns;
+        h.size = w->pos;
+
+        // The header goes in last, so a file cut short never passes for a
+        // finished one.
+        ok = !w->failed && fflush(w->f) == 0 &&
+                fseek(w->f, 0, SEEK_SET) == 0 &&
+                fwrite(&h, sizeof(h), 1, w->f) == 1;
+        ok = fclose(w->f) == 0 && ok;
+
+        free(w->runs);
+        free(w);
+
+        check(ok, "Finishing the store failed.");
+
+        return true;
+ error:
+        return false;
+}
@@ -0,0 +1,115 @@
+#ifndef __ogll_store__
+#define __ogll_store__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opengl-linalg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A binary file of Matrices that loads by memory mapping.
+ *
+ * Opening a store maps the file and checks its header and run table. No
+ * Matrix data is read or copied: `ogllStoreView` hands out `matrix_t`
+ * views straight into the mapping, so each page is faulted in the first
+ * time it's touched. The mapping is private. Writing through a view
+ * changes only this process's copy of that page, never the file.
+ *
+ * Files are written in one pass by a store_writer_t, which streams the
+ * data out as it comes and writes the index at the end. A file whose
+ * writer never finished is rejected on open.
+ *
+ * Layout, all little-endian as written by the host:
+ *
+ *   store_header_t      64 bytes
+ *   run data            each run starts on an OGLL_STORE_ALIGN boundary
+ *   store_run_t[runs]   at `table`
+ *
+ * A run is a stretch of Matrices of the same shape, packed column-major
+ * one after the other. Writing many Matrices of the same shape in a row,
+ * like a table of 4x4 transforms, makes a single run.
+ */
+
+// --- //
+
+#define OGLL_STORE_MAGIC   "OGLLSTOR"
+#define OGLL_STORE_VERSION 1
+#define OGLL_STORE_ALIGN   64
+
+typedef struct store_header_t {
+        char magic[8];          // OGLL_STORE_MAGIC, not NUL-terminated
+        uint32_t version;       // OGLL_STORE_VERSION when written
+        uint32_t order;         // 0x01020304, to catch a foreign byte order
+        uint64_t count;         // Matrices in the file
+        uint64_t runs;          // Entries in the run table
+        uint64_t table;         // Byte offset of the run table
+        uint64_t size;          // Bytes in the whole file
+        uint8_t reserved[16];   // 0
+} store_header_t;
+
+typedef struct store_run_t {
+        uint64_t first;         // Index of the run's first Matrix
+        uint64_t count;         // Matrices in the run
+        uint64_t offset;        // Byte offset of its data
+        uint32_t cols;
+        uint32_t rows;
+} store_run_t;
+
+typedef struct store_t {
+        void* base;
+        size_t size;
+        const store_header_t* header;
+        const store_run_t* runs;
+} store_t;
+
+typedef struct store_writer_t store_writer_t;
+
+// --- READING --- //
+
+/* Map a store file. NULL if it can't be read or isn't a valid store. */
+store_t* ogllStoreOpen(const char* path);
+
+/* Unmap a store. Views into it must no longer be used. */
+void ogllStoreClose(store_t* s);
+
+/* Number of Matrices in a store */
+size_t ogllStoreCount(const store_t* s);
+
+/* A view of Matrix `i`, to be used like the result of `ogllMat4View`:
+   never passed to `ogllMDestroy`, and valid until the store is closed.
+   Has no data (m = NULL) if `i` is out of range. */
+matrix_t ogllStoreView(const store_t* s, size_t i);
+
+/* Number of runs in a store */
+size_t ogllStoreRuns(const store_t* s);
+
+/* The packed data of run `r`, for passing a whole table at once to the
+   bulk functions like `ogllM4MultiplyN`. Copies its entry into `run`.
+   NULL if `r` is out of range. */
+GLfloat* ogllStoreRunData(const store_t* s, size_t r, store_run_t* run);
+
+// --- WRITING --- //
+
+/* Start writing a store file, replacing any file at `path` */
+store_writer_t* ogllStoreWriterOpen(const char* path);
+
+/* Append a Matrix */
+bool ogllStoreWrite(store_writer_t* w, matrix_t* m);
+
+/* Append `count` Matrices of the same shape, packed column-major in `fs` */
+bool ogllStoreWriteArray(store_writer_t* w, size_t cols, size_t rows,
+                         const GLfloat* fs, size_t count);
+
+/* Write the index and finish the file. Frees the writer whether or not
+   it succeeds. */
+bool ogllStoreWriterClose(store_writer_t* w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+// Multithreaded stress test for opengl-linalg
+//
+// Each thread rotates, translates and multiplies its own Matrices in a
+// tight loop and compares against a result computed up front on the main
+// thread. Any shared scratch state inside the library shows up as a
+// mismatch, and as a data race when built with -fsanitize=thread:
+//
+//   gcc -fsanitize=thread -g -O1 test-threads.c opengl-linalg.c simd.c
+//       value.c alloc.c pool.c scene.c gemm.c error.c -lm -lpthread
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "opengl-linalg.h"
+#include "value.h"
+#include "scene.h"
+#include "gemm.h"
+#include "dbg.h"
+
+// --- //
+
+#define THREADS    8
+#define ITERATIONS 20000
+#define NODES      20000
+
+typedef struct job_t {
+        int id;
+        matrix_t* expected;
+        int failures;
+} job_t;
+
+/* The work every thread repeats. Depends only on `id`. */
+static matrix_t* work(matrix_t* m, int id) {
+        GLfloat k = (id + 1) / (GLfloat)THREADS;
+        matrix_t* other = ogllMIdentity(4);
+        mat4_t v = ogllMat4Identity();
+        matrix_t view = ogllMat4View(&v);
+
+        ogllM4Rotate(m, tau * k, 0,0,1);
+        ogllM4Rotate(m, tau / (id + 2), 1,0,0);
+        ogllM4Translate(other, id, -id, k);
+        ogllM4Multiply(m, other);
+
+        ogllMat4Rotate(&v, tau * k, 0,1,0);
+        ogllM4Multiply(m, &view);
+
+        ogllMDestroy(other);
+
+        return m;
+}
+
+static void* runJob(void* arg) {
+        job_t* job = (job_t*)arg;
+        int i;
+
+        for(i = 0; i < ITERATIONS; i++) {
+                matrix_t* m = ogllMIdentity(4);
+
+                work(m, job->id);
+
+                if(!ogllMEqual(m, job->expected)) {
+                        job->failures++;
+                }
+
+                ogllMDestroy(m);
+        }
+
+        return NULL;
+}
+
+/* Build a random hierarchy, update it on a pool, and compare every world
+   transform against a serial walk. Then dirty one subtree and repeat. */
+static int sceneMismatches(pool_t* pool) {
+        scene_t* s = ogllSceneCreate(0);
+        mat4_t* expected = malloc(NODES * sizeof(mat4_t));
+        size_t i, p;
+        int bad = 0, pass;
+
+        check(s && expected, "Scene creation failed.");
+
+        srand(1);
+        for(i = 0; i < NODES; i++) {
+                mat4_t local = ogllMat4Identity();
+                ogllMat4Rotate(&local, rand() / (GLfloat)RAND_MAX, 0,0,1);
+                ogllMat4Translate(&local, 1, i % 3, 0);
+                p = i == 0 ? OGLL_NO_PARENT : (size_t)rand() % i;
+                ogllSceneAdd(s, p, &local);
+        }
+
+        for(pass = 0; pass < 2; pass++) {
+                if(pass == 1) {
+                        ogllMat4Rotate(ogllSceneLocal(s, 3), 1, 1,0,0);
+                        ogllSceneMarkDirty(s, 3);
+                }
+
+                ogllSceneUpdate(s, pool);
+
+                for(i = 0; i < NODES; i++) {
+                        p = s->parent[i];
+                        expected[i] = p == OGLL_NO_PARENT ? s->local[i] :
+                                ogllMat4MultiplyP(&expected[p], &s->local[i]);
+
+                        if(!ogllMat4Equal(&expected[i], ogllSceneWorld(s, i))) {
+                                bad++;
+                        }
+                }
+        }
+
+        ogllSceneDestroy(s);
+        free(expected);
+
+        return bad;
+ error:
+        ogllSceneDestroy(s);
+        free(expected);
+        return 1;
+}
+
+/* A large product split over the pool must match the serial one */
+static int gemmMismatches(pool_t* pool) {
+        matrix_t* a = ogllMCreate(300,257);
+        matrix_t* b = ogllMCreate(190,300);
+        matrix_t* serial = NULL;
+        matrix_t* threaded = NULL;
+        size_t i;
+        int bad;
+
+        check(a && b, "Matrix creation failed.");
+
+        for(i = 0; i < a->cols * a->rows; i++) {
+                a->m[i] = (i % 17) - 8.0;
+        }
+        for(i = 0; i < b->cols * b->rows; i++) {
+                b->m[i] = (i % 13) / 7.0;
+        }
+
+        serial = ogllMMultiplyP(a,b);
+        ogllGemmSetPool(pool);
+        threaded = ogllMMultiplyP(a,b);
+        ogllGemmSetPool(NULL);
+
+        bad = !ogllMEqual(serial,threaded);
+
+        ogllMDestroy(a);
+        ogllMDestroy(b);
+        ogllMDestroy(serial);
+        ogllMDestroy(threaded);
+
+        return bad;
+ error:
+        ogllMDestroy(a);
+        ogllMDestroy(b);
+        return 1;
+}
+
+int main(int argc, char** argv) {
+        pthread_t threads[THREADS];
+        job_t jobs[THREADS];
+        int i, failures = 0;
+
+        for(i = 0; i < THREADS; i++) {
+                jobs[i].id = i;
+                jobs[i].failures = 0;
+                jobs[i].expected = work(ogllMIdentity(4), i);
+                check(jobs[i].expected, "Expected Matrix creation failed.");
+        }
+
+        log_info("Running %d threads x %d iterations", THREADS, ITERATIONS);
+
+        for(i = 0; i < THREADS; i++) {
+                check(pthread_create(&threads[i], NULL, runJob, &jobs[i]) == 0,
+                      "Failed to start thread %d.", i);
+        }
+
+        for(i = 0; i < THREADS; i++) {
+                pthread_join(threads[i], NULL);
+                failures += jobs[i].failures;
+                ogllMDestroy(jobs[i].expected);
+        }
+
+        printf("Mismatches: %d\n", failures);
+
+        log_info("Scene update on a pool of %d", THREADS);
+        pool_t* pool = ogllPoolCreate(THREADS);
+        check(pool, "Pool creation failed.");
+        i = sceneMismatches(pool);
+        printf("Scene mismatches: %d\n", i);
+        failures += i;
+        i = gemmMismatches(pool);
+        printf("GEMM mismatches: %d\n", i);
+        failures += i;
+        ogllPoolDestroy(pool);
+
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+ error:
+        return EXIT_FAILURE;
+}
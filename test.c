@@ -1,12 +1,67 @@
 // Testing opengl-linalg
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
 
 #include "opengl-linalg.h"
+#include "value.h"
+#include "simd.h"
+#include "alloc.h"
+#include "quat.h"
+#include "dvalue.h"
+#include "affine.h"
+#include "soa.h"
+#include "frustum.h"
+#include "staging.h"
+#include "skin.h"
+#include "pipeline.h"
+#include "bvh.h"
+#include "solve.h"
+#include "store.h"
+#include "instrument.h"
 #include "dbg.h"
 
 // --- //
 
+/* A rows x cols system big enough for the blocked solvers, with a heavy
+   diagonal so it's well conditioned, and a right-hand side whose
+   solution is all 1s */
+static matrix_t* bigSystem(size_t rows, size_t cols, bool symmetric, matrix_t** rhs) {
+        matrix_t* a = ogllMCreate(cols, rows);
+        matrix_t* b = ogllMCreate(1, rows);
+        size_t r, c;
+
+        for(r = 0; r < rows; r++) {
+                b->m[r] = 0;
+
+                for(c = 0; c < cols; c++) {
+                        a->m[c * rows + r] = (symmetric ? r * c % 97 :
+                                              (r * 131 + c * 71) % 97) / 97.0f;
+                        if(r == c) {
+                                a->m[c * rows + r] += cols;
+                        }
+                        b->m[r] += a->m[c * rows + r];
+                }
+        }
+
+        *rhs = b;
+        return a;
+}
+
+/* Are the first n entries of `x` within `tol` of 1? */
+static bool allOnes(const matrix_t* x, size_t n, GLfloat tol) {
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+                if(!(fabsf(x->m[i] - 1) <= tol)) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
 int main(int argc, char** argv) {
         int i;
         GLfloat A[] = {1,2,3,4};
@@ -69,7 +124,306 @@ int main(int argc, char** argv) {
         
         log_info("Vector Length");
         printf("%.2f\n", ogllVLength(v2));
-        
+
+        log_info("Value types");
+        mat4_t vm = ogllMat4Identity();
+        mat4_t vlook;
+        matrix_t vview = ogllMat4View(&vm);
+        GLfloat eye[] = {1,2,3};
+        GLfloat at[]  = {0,0,0};
+        GLfloat upv[] = {0,1,0};
+        matrix_t* camPos = ogllVFromArray(3,eye);
+        matrix_t* target = ogllVFromArray(3,at);
+        matrix_t* up     = ogllVFromArray(3,upv);
+        matrix_t* look   = ogllM4LookAtP(camPos,target,up);
+        ogllMat4Rotate(&vm,tau/2, 0,0,1);
+        ogllMat4Print(&vm);
+        printf("Equal? %d\n", ogllMEqual(&vview,id));
+        ogllMat4LookAt(&vlook, ogllV3Make(1,2,3), ogllV3Make(0,0,0),
+                       ogllV3Make(0,1,0));
+        vview = ogllMat4View(&vlook);
+        printf("Equal? %d\n", ogllMEqual(&vview,look));
+        ogllMDestroy(camPos);
+        ogllMDestroy(target);
+        ogllMDestroy(up);
+        ogllMDestroy(look);
+
+        log_info("SIMD kernels (default: %s)", ogllSimdName(ogllSimdBackend()));
+        GLfloat R[16], S[16], ref[16], out[16];
+        for(i = 0; i < 16; i++) {
+                R[i] = (i * 7 % 11) - 5.5;
+                S[i] = (i * 5 % 13) / 3.0;
+        }
+        ogllSimdSelect(OGLL_SIMD_SCALAR);
+        ogllSimdM4Multiply(ref,R,S);
+        for(i = OGLL_SIMD_SSE; i <= OGLL_SIMD_NEON; i++) {
+                if(ogllSimdSelect(i)) {
+                        matrix_t rm = { ref, 4, 4 };
+                        matrix_t om = { out, 4, 4 };
+                        ogllSimdM4Multiply(out,R,S);
+                        printf("%s matches scalar? %d\n", ogllSimdName(i),
+                               ogllMEqual(&rm,&om));
+                }
+        }
+
+        log_info("Batch transforms");
+        GLfloat pts[] = { 1,0,0, 0,1,0, 0,0,1 };
+        GLfloat kids[32];
+        matrix_t* t = ogllMIdentity(4);
+        ogllM4Translate(t,1,2,3);
+        ogllM4TransformN(t,pts,pts,3,3,0);
+        for(i = 0; i < 9; i += 3) {
+                printf("%.2f %.2f %.2f\n", pts[i], pts[i+1], pts[i+2]);
+        }
+        for(i = 0; i < 32; i++) {
+                kids[i] = (i % 5 == 0);
+        }
+        ogllM4MultiplyN(t,kids,kids,2);
+        matrix_t kid = { kids + 16, 4, 4 };
+        ogllMPrint(&kid);
+        ogllMDestroy(t);
+
+        log_info("Frame arena");
+        arena_t* arena = ogllArenaCreate(4096);
+        ogllSetAllocator(ogllArenaAllocator(arena));
+        matrix_t* aprod = ogllMMultiplyP(n,o);
+        matrix_t* atrans = ogllMTranspose(aprod);
+        ogllMPrint(atrans);
+        printf("Arena bytes used: %zu\n", arena->used);
+        printf("Aligned? %d\n", (uintptr_t)aprod->m % OGLL_ALIGN == 0 &&
+               (uintptr_t)n->m % OGLL_ALIGN == 0);
+        ogllMDestroy(aprod);
+        ogllMDestroy(atrans);
+        ogllArenaReset(arena);
+        ogllSetAllocator(NULL);
+        ogllArenaDestroy(arena);
+
+        log_info("Quaternions");
+        quat_t qa = ogllQFromAxisAngle(tau/8,0,0,1);
+        quat_t qb = ogllQFromAxisAngle(tau/4,1,0,0);
+        matrix_t* qm = ogllMIdentity(4);
+        matrix_t* rm = ogllMIdentity(4);
+        ogllM4Rotate(rm,tau/8,0,0,1);
+        ogllM4Rotate(rm,tau/4,1,0,0);
+        ogllQToMatrix(ogllQMultiply(qa,qb),qm);
+        ogllMPrint(qm);
+        GLfloat qerr = 0;
+        for(i = 0; i < 16; i++) {
+                qerr = fmax(qerr, fabs(qm->m[i] - rm->m[i]));
+        }
+        printf("Matches ogllM4Rotate? %d\n", qerr < 1e-6);
+        quat_t qback = ogllQFromMatrix(qm);
+        printf("Round trip dot: %.4f\n",
+               fabs(ogllQDot(qback, ogllQMultiply(qa,qb))));
+        quat_t qhalf = ogllQSlerp(ogllQIdentity(),qa,0.5);
+        printf("Slerp halfway: %.4f %.4f %.4f %.4f\n",
+               qhalf.x, qhalf.y, qhalf.z, qhalf.w);
+        ogllMDestroy(qm);
+        ogllMDestroy(rm);
+
+        log_info("Inverses");
+        matrix_t* trs = ogllMIdentity(4);
+        matrix_t* tinv = ogllMIdentity(4);
+        ogllM4Translate(trs,1,2,3);
+        ogllM4Rotate(trs,tau/8,0,0,1);
+        printf("Kind (2 = rigid): %d\n", ogllM4Kind(trs));
+        ogllMScale(trs,2);
+        printf("Kind (1 = affine): %d\n", ogllM4Kind(trs));
+        ogllM4Inverse(tinv,trs);
+        matrix_t* tid = ogllMMultiplyP(trs,tinv);
+        ogllMPrint(tid);
+        vec3_t dt, ds;
+        quat_t dr;
+        ogllM4Decompose(trs,&dt,&dr,&ds);
+        printf("T: %.2f %.2f %.2f S: %.2f %.2f %.2f\n",
+               dt.x, dt.y, dt.z, ds.x, ds.y, ds.z);
+        ogllMDestroy(trs);
+        ogllMDestroy(tinv);
+        ogllMDestroy(tid);
+
+        log_info("Vector streams");
+        GLfloat packed[] = { 3,4,0, 0,0,2, 1,1,1, 0,0,0, 6,8,0 };
+        GLfloat lens[5];
+        soa_t* stream = ogllSoaCreate(5,3);
+        ogllSoaFromInterleaved(stream,packed,0);
+        ogllSoaLength(lens,stream);
+        printf("Lengths: %.2f %.2f %.2f %.2f %.2f\n",
+               lens[0], lens[1], lens[2], lens[3], lens[4]);
+        ogllSoaNormalize(stream,stream);
+        ogllSoaToInterleaved(stream,packed,0);
+        printf("Normalized: %.2f %.2f %.2f\n", packed[12], packed[13], packed[14]);
+        ogllSoaDestroy(stream);
+
+        log_info("Frustum culling");
+        matrix_t* cproj = ogllMPerspectiveP(tau/8,1,1,100);
+        mat4_t cview, cvp;
+        frustum_t fr;
+        ogllMat4LookAt(&cview, ogllV3Make(0,0,0), ogllV3Make(0,0,-1),
+                       ogllV3Make(0,1,0));
+        ogllMat4FromMatrix(&cvp,cproj);
+        ogllMat4Multiply(&cvp,&cview);
+        ogllFrustumFromMat4(&fr,&cvp);
+        soa_t* centres = ogllSoaCreate(4,3);
+        GLfloat cpts[] = { 0,0,-10, 0,0,10, 0,0,-200, 1,1,-5 };
+        GLfloat radii[] = { 1, 1, 1, 1 };
+        uint32_t vis[OGLL_CULL_WORDS(4)];
+        ogllSoaFromInterleaved(centres,cpts,0);
+        size_t nvis = ogllFrustumCullSpheres(&fr,centres,radii,vis);
+        printf("Visible: %zu mask: %x\n", nvis, vis[0]);
+        ogllSoaDestroy(centres);
+        ogllMDestroy(cproj);
+
+        log_info("Products into existing Matrices");
+        matrix_t* into = ogllMCreate(4,4);
+        matrix_t* ia = ogllMIdentity(4);
+        ogllM4Translate(ia,1,2,3);
+        ogllMMultiplyInto(into,ia,ia);
+        ogllMPrint(into);
+        ogllMMultiplyInto(ia,ia,into);      // In place
+        ogllMTransposeInto(ia,ia);
+        ogllMPrint(ia);
+        matrix_t lo = { into->m, 3, 4, NULL };
+        matrix_t hi = { into->m + 4, 3, 4, NULL };
+        printf("Partial overlap refused? %d\n", ogllMAddInto(&hi,&lo,&lo) == NULL);
+        ogllMDestroy(ia);
+        ogllMDestroy(into);
+
+        log_info("Double precision, far from the origin");
+        dmat4_t far = ogllDMat4Identity();
+        mat4_t near;
+        ogllDMat4Translate(&far, 1e7 + 0.25, 0, -3e7 + 0.5);
+        ogllDMat4CameraRelative(&near, &far, ogllDV3Make(1e7, 0, -3e7));
+        printf("Camera-relative: %.2f %.2f %.2f\n",
+               near.m[12], near.m[13], near.m[14]);
+
+        log_info("Staging a batch of Matrices");
+        staging_t* stage = ogllStagingCreate(1024, 3, NULL);
+        mat4_t batch[2] = { ogllMat4Identity(), ogllMat4Identity() };
+        size_t staged, used;
+        ogllStagingBegin(stage);
+        ogllStagingPushMat4s(stage, batch, 2, 256, &staged);
+        ogllStagingPushMat3s(stage, batch, 2, 256, &staged);
+        used = ogllStagingEnd(stage);
+        printf("mat3s at %zu, %zu bytes used\n", staged, used);
+        ogllStagingDestroy(stage);
+
+        log_info("Quiet errors");
+        ogllSetErrorLogging(false);
+        ogllGetError();
+        ogllVDotProduct(v, m);
+        printf("Dot product: %s (%s)\n", ogllStatusName(ogllGetError()),
+               ogllLastError()->msg);
+        ogllSetErrorLogging(true);
+
+        log_info("Skinning");
+        mat4_t bones[2] = { ogllMat4Identity(), ogllMat4Identity() };
+        GLfloat rest[] = { 1,0,0 }, skinned[3];
+        uint16_t joints[OGLL_SKIN_INFLUENCES] = { 0, 1, 0, 0 };
+        GLfloat weights[OGLL_SKIN_INFLUENCES] = { 0.5f, 0.5f, 0, 0 };
+        skin_mesh_t skm = { rest, NULL, joints, weights, 1 };
+        ogllMat4Rotate(&bones[1], tau/4, 0, 0, 1);
+        ogllSkin(OGLL_SKIN_LINEAR, bones, 2, &skm, skinned, NULL, NULL);
+        printf("Linear: %.2f %.2f %.2f\n", skinned[0], skinned[1], skinned[2]);
+        ogllSkin(OGLL_SKIN_DUALQUAT, bones, 2, &skm, skinned, NULL, NULL);
+        printf("Dual quaternion: %.2f %.2f %.2f\n", skinned[0], skinned[1], skinned[2]);
+
+        log_info("Projecting to the screen");
+        matrix_t* pproj = ogllMPerspectiveP(tau/4,1,1,100);
+        viewport_t port = ogllViewport(0,0,640,480);
+        pipeline_t pipe;
+        soa_t* verts = ogllSoaCreate(3,3);
+        GLfloat vpts[] = { 0,0,-10, 5,5,-10, 0,0,10 };
+        uint8_t vcodes[3];
+        ogllPipelineInit(&pipe, pproj, NULL, NULL, &port);
+        ogllSoaFromInterleaved(verts,vpts,0);
+        size_t nin = ogllPipelineRun(&pipe, verts, verts, vcodes, NULL);
+        printf("Inside: %zu codes: %x %x %x\n", nin, vcodes[0], vcodes[1], vcodes[2]);
+        printf("Screen: %.1f %.1f %.1f / %.1f %.1f %.1f\n",
+               verts->x[0], verts->y[0], verts->z[0],
+               verts->x[1], verts->y[1], verts->z[1]);
+        ogllSoaDestroy(verts);
+        ogllMDestroy(pproj);
+
+        log_info("Casting rays");
+        GLfloat quad[] = { -1,-1,0, 1,-1,0, 1,1,0, -1,1,0 };
+        uint32_t quadIdx[] = { 0,1,2, 0,2,3 };
+        bvh_t* bvh = ogllBvhCreate(quad, quadIdx, 2);
+        hit_t hit;
+        printf("Hit? %d ", ogllBvhIntersect(bvh, ogllV3Make(-0.5,0.5,5),
+                                            ogllV3Make(0,0,-1), INFINITY, &hit));
+        printf("triangle %u at t = %.2f\n", hit.triangle, hit.t);
+        matrix_t* lift = ogllMIdentity(4);
+        ogllM4Translate(lift,0,0,2);
+        ogllM4TransformN(lift, quad, quad, 4, 3, 0);
+        ogllBvhRefit(bvh, NULL);
+        ogllBvhIntersect(bvh, ogllV3Make(-0.5,0.5,5), ogllV3Make(0,0,-1), INFINITY, &hit);
+        printf("After moving: t = %.2f\n", hit.t);
+        ogllMDestroy(lift);
+        ogllBvhDestroy(bvh);
+
+        log_info("Solving systems");
+        GLfloat sys[] = { 4,2,0, 2,5,1, 0,1,3 };
+        GLfloat rhs[] = { 6,8,4 };
+        matrix_t* sa = ogllMFromArray(3,3,sys);
+        matrix_t* sb = ogllMFromArray(1,3,rhs);
+        matrix_t* sx = ogllMSolveP(sa,sb);
+        printf("x: %.2f %.2f %.2f det: %.2f\n",
+               sx->m[0], sx->m[1], sx->m[2], ogllMDeterminant(sa));
+        ogllMCholeskyDecompose(sa);
+        ogllMCholeskySolve(sa,sb);
+        printf("Cholesky agrees? %d\n", fabs(sb->m[0] - sx->m[0]) < 1e-5);
+        ogllMDestroy(sx);
+        ogllMDestroy(sa);
+
+        // Past SOLVE_BLOCKED_MIN, so the panel updates go through GEMM
+        size_t bpiv[129];
+        GLfloat btau[129];
+        matrix_t* bb;
+        matrix_t* ba = bigSystem(129, 129, false, &bb);
+        bool luOk = ogllMLUDecompose(ba, bpiv) && ogllMLUSolve(ba, bpiv, bb) &&
+                allOnes(bb, 129, 1e-4);
+        ogllMDestroy(ba);
+        ogllMDestroy(bb);
+        ba = bigSystem(129, 129, true, &bb);
+        bool cholOk = ogllMCholeskyDecompose(ba) && ogllMCholeskySolve(ba, bb) &&
+                allOnes(bb, 129, 1e-4);
+        ogllMDestroy(ba);
+        ogllMDestroy(bb);
+        ba = bigSystem(300, 129, false, &bb);
+        bool qrOk = ogllMQRDecompose(ba, btau) && ogllMQRSolve(ba, btau, bb) &&
+                allOnes(bb, 129, 1e-4);
+        ogllMDestroy(ba);
+        ogllMDestroy(bb);
+        printf("Blocked LU, Cholesky and QR accurate? %d %d %d\n", luOk, cholOk, qrOk);
+
+        log_info("Memory-mapped stores");
+        GLfloat poses[] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1,
+                            2,0,0,0, 0,2,0,0, 0,0,2,0, 1,2,3,1 };
+        store_writer_t* sw = ogllStoreWriterOpen("test-store.bin");
+        ogllStoreWriteArray(sw, 4, 4, poses, 2);
+        ogllStoreWrite(sw, sb);
+        ogllStoreWriterClose(sw);
+        store_t* store = ogllStoreOpen("test-store.bin");
+        matrix_t pose = ogllStoreView(store, 1);
+        printf("%zu Matrices in %zu runs, translation: %.2f %.2f %.2f\n",
+               ogllStoreCount(store), ogllStoreRuns(store),
+               pose.m[12], pose.m[13], pose.m[14]);
+        ogllStoreClose(store);
+        remove("test-store.bin");
+
+        ogllMDestroy(sb);
+
+        log_info("Instrumentation");
+        ogll_stat_t st;
+        if(ogllInstrumentStat("ogllMMultiplyP",&st)) {
+                printf("ogllMMultiplyP: %llu calls, %llu allocs, %llu bytes\n",
+                       (unsigned long long)st.calls, (unsigned long long)st.allocs,
+                       (unsigned long long)st.bytes);
+                printf("Live objects: %zu\n", ogllInstrumentLive(NULL));
+        } else {
+                printf("Instrumented? %d\n", ogllInstrumentEnabled());
+        }
+
         debug("Destroying Matrices...");
 
         ogllMDestroy(v);
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <math.h>
+
+#include "value.h"
+#include "simd.h"
+#include "instrument.h"
+#include "dbg.h"
+
+// --- //
+
+// --- VECTORS --- //
+
+/* Construct Vectors from their components */
+vec2_t ogllV2Make(GLfloat x, GLfloat y) {
+        OGLL_PROBE();
+        vec2_t v = { x, y };
+        return v;
+}
+
+vec3_t ogllV3Make(GLfloat x, GLfloat y, GLfloat z) {
+        OGLL_PROBE();
+        vec3_t v = { x, y, z };
+        return v;
+}
+
+vec4_t ogllV4Make(GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+        OGLL_PROBE();
+        vec4_t v = { x, y, z, w };
+        return v;
+}
+
+/* Component-wise sum of two Vectors */
+vec3_t ogllV3Add(vec3_t v1, vec3_t v2) {
+        OGLL_PROBE();
+        return ogllV3Make(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);
+}
+
+vec4_t ogllV4Add(vec4_t v1, vec4_t v2) {
+        OGLL_PROBE();
+        return ogllV4Make(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w);
+}
+
+/* Scale a Vector by some scalar */
+vec3_t ogllV3Scale(vec3_t v, GLfloat f) {
+        OGLL_PROBE();
+        return ogllV3Make(v.x * f, v.y * f, v.z * f);
+}
+
+vec4_t ogllV4Scale(vec4_t v, GLfloat f) {
+        OGLL_PROBE();
+        return ogllV4Make(v.x * f, v.y * f, v.z * f, v.w * f);
+}
+
+/* The Cross-Product of two Vectors */
+vec3_t ogllV3Cross(vec3_t v1, vec3_t v2) {
+        OGLL_PROBE();
+        return ogllV3Make(v1.y * v2.z - v1.z * v2.y,
+                          v1.z * v2.x - v1.x * v2.z,
+                          v1.x * v2.y - v1.y * v2.x);
+}
+
+/* Yields the Dot Product of two Vectors */
+GLfloat ogllV2Dot(vec2_t v1, vec2_t v2) {
+        OGLL_PROBE();
+        return v1.x * v2.x + v1.y * v2.y;
+}
+
+GLfloat ogllV3Dot(vec3_t v1, vec3_t v2) {
+        OGLL_PROBE();
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+
+GLfloat ogllV4Dot(vec4_t v1, vec4_t v2) {
+        OGLL_PROBE();
+        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+}
+
+/* Yields the Length/Magnitude of a given Vector */
+GLfloat ogllV2Length(vec2_t v) {
+        OGLL_PROBE();
+        return sqrt(ogllV2Dot(v,v));
+}
+
+GLfloat ogllV3Length(vec3_t v) {
+        OGLL_PROBE();
+        return sqrt(ogllV3Dot(v,v));
+}
+
+GLfloat ogllV4Length(vec4_t v) {
+        OGLL_PROBE();
+        return sqrt(ogllV4Dot(v,v));
+}
+
+/* Are two Vectors orthogonal? */
+bool ogllV3IsOrtho(vec3_t v1, vec3_t v2) {
+        OGLL_PROBE();
+        return ogllV3Dot(v1,v2) <= 0.000001;
+}
+
+/* A non-owning `matrix_t` view of a Vector */
+matrix_t ogllV3View(vec3_t* v) {
+        OGLL_PROBE();
+        matrix_t view = { (GLfloat*)v, 1, 3 };
+        return view;
+}
+
+matrix_t ogllV4View(vec4_t* v) {
+        OGLL_PROBE();
+        matrix_t view = { (GLfloat*)v, 1, 4 };
+        return view;
+}
+
+// --- MATRICES --- //
+
+/* A 4x4 Matrix of all 0s */
+mat4_t ogllMat4Zero(void) {
+        OGLL_PROBE();
+        mat4_t m = {{ 0 }};
+        return m;
+}
+
+/* The 4x4 Identity Matrix */
+mat4_t ogllMat4Identity(void) {
+        OGLL_PROBE();
+        mat4_t m = {{
+                1,0,0,0,
+                0,1,0,0,
+                0,0,1,0,
+                0,0,0,1
+        }};
+        return m;
+}
+
+/* A 4x4 Matrix from 16 column-major floats */
+mat4_t ogllMat4FromArray(const GLfloat* fs) {
+        OGLL_PROBE();
+        mat4_t m;
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                m.m[i] = fs[i];
+        }
+
+        return m;
+}
+
+/* Copy a 4x4 `matrix_t` into caller storage */
+mat4_t* ogllMat4FromMatrix(mat4_t* dst, matrix_t* m) {
+        OGLL_PROBE();
+        size_t i;
+
+        check(dst && m, "Null Matrices given.");
+        check(m->cols == 4 && m->rows == 4, "Matrix not 4x4.");
+
+        for(i = 0; i < 16; i++) {
+                dst->m[i] = m->m[i];
+        }
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* A non-owning `matrix_t` view of a 4x4 Matrix */
+matrix_t ogllMat4View(mat4_t* m) {
+        OGLL_PROBE();
+        matrix_t view = { m->m, 4, 4 };
+        return view;
+}
+
+/* Are two Matrices equal? */
+bool ogllMat4Equal(const mat4_t* m1, const mat4_t* m2) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                if(m1->m[i] != m2->m[i]) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+/* Set a value in a Matrix */
+void ogllMat4Set(mat4_t* m, size_t col, size_t row, GLfloat f) {
+        OGLL_PROBE();
+        if(m && col < 4 && row < 4) {
+                m->m[4 * col + row] = f;
+        }
+}
+
+/* Scale a Matrix by some scalar in place. Resets the homo bit. */
+void ogllMat4Scale(mat4_t* m, GLfloat f) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                m->m[i] *= f;
+        }
+
+        m->m[15] = 1;
+}
+
+/* The values of m2 are added to m1 */
+mat4_t* ogllMat4Add(mat4_t* m1, const mat4_t* m2) {
+        OGLL_PROBE();
+        size_t i;
+
+        for(i = 0; i < 16; i++) {
+                m1->m[i] += m2->m[i];
+        }
+
+        return m1;
+}
+
+/* Multiply two 4x4 matrices together in place. Affects `m1`. */
+mat4_t* ogllMat4Multiply(mat4_t* m1, const mat4_t* m2) {
+        OGLL_PROBE();
+        *m1 = ogllMat4MultiplyP(m1,m2);
+
+        return m1;
+}
+
+/* Multiply two 4x4 matrices together. Returns the product by value. */
+mat4_t ogllMat4MultiplyP(const mat4_t* m1, const mat4_t* m2) {
+        OGLL_PROBE();
+        mat4_t p;
+
+        ogllSimdM4Multiply(p.m, m1->m, m2->m);
+
+        return p;
+}
+
+/* Transform a Vector by a 4x4 Matrix: m * v */
+vec4_t ogllMat4MultiplyV(const mat4_t* m, vec4_t v) {
+        OGLL_PROBE();
+        ogllSimdM4Transform((GLfloat*)&v, m->m, (GLfloat*)&v);
+
+        return v;
+}
+
+/* Transpose a 4x4 Matrix. Returns the result by value. */
+mat4_t ogllMat4Transpose(const mat4_t* m) {
+        OGLL_PROBE();
+        mat4_t t;
+        size_t i,j;
+
+        for(i = 0; i < 4; i++) {
+                for(j = 0; j < 4; j++) {
+                        t.m[i * 4 + j] = m->m[j * 4 + i];
+                }
+        }
+
+        return t;
+}
+
+/* Rotate a 4x4 Matrix in place by `r` radians around the unit vector
+formed by `x` `y` and `z` */
+mat4_t* ogllMat4Rotate(mat4_t* m, GLfloat r, GLfloat x, GLfloat y, GLfloat z) {
+        OGLL_PROBE();
+        mat4_t rot = ogllMat4Identity();
+        GLfloat cosr = cos(r);
+        GLfloat sinr = sin(r);
+
+        // Same construction as `ogllM4Rotate`.
+        // Column 1
+        rot.m[0] = cosr+x*x*(1-cosr);
+        rot.m[1] = y*x*(1-cosr)+z*sinr;
+        rot.m[2] = z*x*(1-cosr)-y*sinr;
+        // Column 2
+        rot.m[4] = x*y*(1-cosr)-z*sinr;
+        rot.m[5] = cosr+y*y*(1-cosr);
+        rot.m[6] = z*y*(1-cosr)+x*sinr;
+        // Column 3
+        rot.m[8]  = x*z*(1-cosr)+y*sinr;
+        rot.m[9]  = y*z*(1-cosr)-x*sinr;
+        rot.m[10] = cosr+z*z*(1-cosr);
+
+        return ogllMat4Multiply(m,&rot);
+}
+
+/* Adds translation factor to a transformation Matrix (in place) */
+mat4_t* ogllMat4Translate(mat4_t* m, GLfloat x, GLfloat y, GLfloat z) {
+        OGLL_PROBE();
+        m->m[12] = x;
+        m->m[13] = y;
+        m->m[14] = z;
+
+        return m;
+}
+
+/* Writes a Perspective Projection Matrix into `dst` */
+mat4_t* ogllMat4Perspective(mat4_t* dst,
+                            GLfloat fov, GLfloat aspr, GLfloat n, GLfloat f) {
+        OGLL_PROBE();
+        check(dst, "Null Matrix given.");
+        check(aspr > 0, "Invalid Aspect Ratio given.");
+        check(n < f, "Near-clipping plane farther than far-clipping plane!");
+
+        GLfloat t = n * tan(fov / 2.0);
+        GLfloat r = t * aspr;
+
+        *dst = ogllMat4Zero();
+        dst->m[0]  = n/r;
+        dst->m[5]  = n/t;
+        dst->m[10] = -(f+n)/(f-n);
+        dst->m[11] = -1;
+        dst->m[14] = (-2*f*n)/(f-n);
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* A Cross-Product with the y component negated, as `ogllVCrossP`
+   computes it. `ogllMat4LookAt` builds its axes with this so that it
+   stays identical to `ogllM4LookAtP`. */
+static vec3_t lookAtCross(vec3_t v1, vec3_t v2) {
+        return ogllV3Make(v1.y * v2.z - v1.z * v2.y,
+                          v1.x * v2.z - v1.z * v2.x,
+                          v1.x * v2.y - v1.y * v2.x);
+}
+
+/* Writes a View Matrix into `dst` */
+mat4_t* ogllMat4LookAt(mat4_t* dst, vec3_t camPos, vec3_t target, vec3_t up) {
+        OGLL_PROBE();
+        vec3_t camDir, camRight, camUp;
+
+        check(dst, "Null Matrix given.");
+
+        camDir   = ogllV3Add(camPos, ogllV3Scale(target,-1));
+        camRight = lookAtCross(up,camDir);
+        camUp    = lookAtCross(camDir,camRight);
+
+        *dst = ogllMat4Identity();
+
+        // Column 1
+        dst->m[0] = camRight.x;
+        dst->m[1] = camUp.x;
+        dst->m[2] = camDir.x;
+
+        // Column 2
+        dst->m[4] = camRight.y;
+        dst->m[5] = camUp.y;
+        dst->m[6] = camDir.y;
+
+        // Column 3
+        dst->m[8]  = camRight.z;
+        dst->m[9]  = camUp.z;
+        dst->m[10] = camDir.z;
+
+        // Column 4
+        dst->m[12] = -camPos.x;
+        dst->m[13] = -camPos.y;
+        dst->m[14] = -camPos.z;
+
+        return dst;
+ error:
+        return NULL;
+}
+
+/* Print a Matrix */
+void ogllMat4Print(const mat4_t* m) {
+        OGLL_PROBE();
+        size_t i,j;
+
+        if(m) {
+                for(i = 0; i < 4; i++) {
+                        printf("[ ");
+
+                        for(j = 0; j < 4; j++) {
+                                printf("%.2f ", m->m[4 * j + i]);
+                        }
+
+                        printf("]\n");
+                }
+        }
+}
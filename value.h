@@ -0,0 +1,137 @@
+#ifndef __ogll_value__
+#define __ogll_value__
+
+#include "opengl-linalg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fixed-size Vector and Matrix types that live on the stack or inside
+ * caller structs. Nothing in this module touches the heap. The Matrix
+ * layout is column-major, exactly like `matrix_t->m`, so a `mat4_t` can
+ * be handed straight to `glUniformMatrix4fv`.
+ */
+
+// --- //
+
+typedef struct vec2_t {
+        GLfloat x, y;
+} vec2_t;
+
+typedef struct vec3_t {
+        GLfloat x, y, z;
+} vec3_t;
+
+typedef struct vec4_t {
+        GLfloat x, y, z, w;
+} __attribute__((aligned(16))) vec4_t;
+
+typedef struct mat4_t {
+        GLfloat m[16];
+} __attribute__((aligned(16))) mat4_t;
+
+// --- VECTORS --- //
+
+/* Construct Vectors from their components */
+vec2_t ogllV2Make(GLfloat x, GLfloat y);
+vec3_t ogllV3Make(GLfloat x, GLfloat y, GLfloat z);
+vec4_t ogllV4Make(GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+/* Component-wise sum of two Vectors */
+vec3_t ogllV3Add(vec3_t v1, vec3_t v2);
+vec4_t ogllV4Add(vec4_t v1, vec4_t v2);
+
+/* Scale a Vector by some scalar */
+vec3_t ogllV3Scale(vec3_t v, GLfloat f);
+vec4_t ogllV4Scale(vec4_t v, GLfloat f);
+
+/* The Cross-Product of two Vectors. `ogllVCrossP` gives the y component
+   the opposite sign. */
+vec3_t ogllV3Cross(vec3_t v1, vec3_t v2);
+
+/* Yields the Dot Product of two Vectors */
+GLfloat ogllV2Dot(vec2_t v1, vec2_t v2);
+GLfloat ogllV3Dot(vec3_t v1, vec3_t v2);
+GLfloat ogllV4Dot(vec4_t v1, vec4_t v2);
+
+/* Yields the Length/Magnitude of a given Vector */
+GLfloat ogllV2Length(vec2_t v);
+GLfloat ogllV3Length(vec3_t v);
+GLfloat ogllV4Length(vec4_t v);
+
+/* Are two Vectors orthogonal? */
+bool ogllV3IsOrtho(vec3_t v1, vec3_t v2);
+
+/* A non-owning `matrix_t` view of a Vector, usable with the heap API.
+   Never call `ogllMDestroy` on the result. */
+matrix_t ogllV3View(vec3_t* v);
+matrix_t ogllV4View(vec4_t* v);
+
+// --- MATRICES --- //
+
+/* A 4x4 Matrix of all 0s */
+mat4_t ogllMat4Zero(void);
+
+/* The 4x4 Identity Matrix */
+mat4_t ogllMat4Identity(void);
+
+/* A 4x4 Matrix from 16 column-major floats */
+mat4_t ogllMat4FromArray(const GLfloat* fs);
+
+/* Copy a 4x4 `matrix_t` into caller storage. Returns `dst`, or NULL if
+   `m` isn't 4x4. */
+mat4_t* ogllMat4FromMatrix(mat4_t* dst, matrix_t* m);
+
+/* A non-owning `matrix_t` view of a 4x4 Matrix, usable with the heap API.
+   Never call `ogllMDestroy` on the result. */
+matrix_t ogllMat4View(mat4_t* m);
+
+/* Are two Matrices equal? */
+bool ogllMat4Equal(const mat4_t* m1, const mat4_t* m2);
+
+/* Set a value in a Matrix */
+void ogllMat4Set(mat4_t* m, size_t col, size_t row, GLfloat f);
+
+/* Scale a Matrix by some scalar in place. Resets the homo bit. */
+void ogllMat4Scale(mat4_t* m, GLfloat f);
+
+/* The values of m2 are added to m1 */
+mat4_t* ogllMat4Add(mat4_t* m1, const mat4_t* m2);
+
+/* Multiply two 4x4 matrices together in place. Affects `m1`. */
+mat4_t* ogllMat4Multiply(mat4_t* m1, const mat4_t* m2);
+
+/* Multiply two 4x4 matrices together. Returns the product by value. */
+mat4_t ogllMat4MultiplyP(const mat4_t* m1, const mat4_t* m2);
+
+/* Transform a Vector by a 4x4 Matrix: m * v */
+vec4_t ogllMat4MultiplyV(const mat4_t* m, vec4_t v);
+
+/* Transpose a 4x4 Matrix. Returns the result by value. */
+mat4_t ogllMat4Transpose(const mat4_t* m);
+
+/* Rotate a 4x4 Matrix in place by `r` radians around the unit vector
+formed by `x` `y` and `z` */
+mat4_t* ogllMat4Rotate(mat4_t* m, GLfloat r, GLfloat x, GLfloat y, GLfloat z);
+
+/* Adds translation factor to a transformation Matrix (in place) */
+mat4_t* ogllMat4Translate(mat4_t* m, GLfloat x, GLfloat y, GLfloat z);
+
+/* Writes a Perspective Projection Matrix into `dst`.
+   See `ogllMPerspectiveP` for the meaning of the arguments. */
+mat4_t* ogllMat4Perspective(mat4_t* dst,
+                            GLfloat fov, GLfloat aspr, GLfloat n, GLfloat f);
+
+/* Writes a View Matrix into `dst`. Unlike `ogllM4LookAtP`, the
+   arguments are never modified. */
+mat4_t* ogllMat4LookAt(mat4_t* dst, vec3_t camPos, vec3_t target, vec3_t up);
+
+/* Print a Matrix */
+void ogllMat4Print(const mat4_t* m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif